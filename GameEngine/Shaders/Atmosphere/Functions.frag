@@ -2,37 +2,43 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
-uniform float mTopRadius;
-uniform float mBotRadius;
-
-// Sun light at top of atmosphere
-uniform vec3 mSolarIrradiance;
-// Radius of sun in radians (Based on view point)
-uniform float mSunAngularRadius;
-// Solar intensity
-uniform float mSolarIntensity; 
-
-// Rayleigh density
-uniform float mHr;
-// Mie density
-uniform float mHm;
-// Rayleigh extinction factor
-uniform vec3 mBr;
-// Mie extinction factor
-uniform vec3 mBm;
-// Mie phase function G variable
-uniform float mMiePhaseG;
-
-uniform int TRANSMITTANCE_TEXTURE_WIDTH;
-uniform int TRANSMITTANCE_TEXTURE_HEIGHT;
-
-uniform int SCATTERING_TEXTURE_R_SIZE;
-uniform int SCATTERING_TEXTURE_MU_SIZE;
-uniform int SCATTERING_TEXTURE_MU_S_SIZE;
-uniform int SCATTERING_TEXTURE_NU_SIZE;
-
-uniform int IRRADIANCE_TEXTURE_WIDTH;
-uniform int IRRADIANCE_TEXTURE_HEIGHT;
+// Constants shared by all atmosphere shaders (Matches AtmosphereUniforms in Atmosphere.h)
+layout (std140) uniform AtmosphereUniforms
+{
+    // Sun light at top of atmosphere
+    vec3 mSolarIrradiance;
+    // Solar intensity
+    float mSolarIntensity;
+    // Rayleigh extinction factor
+    vec3 mBr;
+    float mTopRadius;
+    // Mie extinction factor
+    vec3 mBm;
+    float mBotRadius;
+    // Tangent and cosine of sun angular radius
+    vec2 mSunSize;
+    // Radius of sun in radians (Based on view point)
+    float mSunAngularRadius;
+    // Rayleigh density
+    float mHr;
+    // Mie density
+    float mHm;
+    // Mie phase function G variable
+    float mMiePhaseG;
+    float mBaseHeight;
+    float mDistScale;
+
+    int TRANSMITTANCE_TEXTURE_WIDTH;
+    int TRANSMITTANCE_TEXTURE_HEIGHT;
+
+    int SCATTERING_TEXTURE_R_SIZE;
+    int SCATTERING_TEXTURE_MU_SIZE;
+    int SCATTERING_TEXTURE_MU_S_SIZE;
+    int SCATTERING_TEXTURE_NU_SIZE;
+
+    int IRRADIANCE_TEXTURE_WIDTH;
+    int IRRADIANCE_TEXTURE_HEIGHT;
+};
 
 // Transmittance precalculation texture
 uniform sampler2D mTransmittanceTexture;
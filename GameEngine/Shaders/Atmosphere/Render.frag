@@ -11,13 +11,45 @@ uniform sampler2D mDepth;
 uniform mat4 mInvProjView;
 uniform vec3 mCamPos;
 uniform vec3 mSunDir;
-uniform vec2 mSunSize;
-uniform float mBaseHeight;
-uniform float mDistScale;
 uniform float mColorMultiplier;
 
-uniform float mBotRadius;
-uniform vec3 mSolarIrradiance;
+// Constants shared by all atmosphere shaders (Matches AtmosphereUniforms in Atmosphere.h)
+layout (std140) uniform AtmosphereUniforms
+{
+    // Sun light at top of atmosphere
+    vec3 mSolarIrradiance;
+    // Solar intensity
+    float mSolarIntensity;
+    // Rayleigh extinction factor
+    vec3 mBr;
+    float mTopRadius;
+    // Mie extinction factor
+    vec3 mBm;
+    float mBotRadius;
+    // Tangent and cosine of sun angular radius
+    vec2 mSunSize;
+    // Radius of sun in radians (Based on view point)
+    float mSunAngularRadius;
+    // Rayleigh density
+    float mHr;
+    // Mie density
+    float mHm;
+    // Mie phase function G variable
+    float mMiePhaseG;
+    float mBaseHeight;
+    float mDistScale;
+
+    int TRANSMITTANCE_TEXTURE_WIDTH;
+    int TRANSMITTANCE_TEXTURE_HEIGHT;
+
+    int SCATTERING_TEXTURE_R_SIZE;
+    int SCATTERING_TEXTURE_MU_SIZE;
+    int SCATTERING_TEXTURE_MU_S_SIZE;
+    int SCATTERING_TEXTURE_NU_SIZE;
+
+    int IRRADIANCE_TEXTURE_WIDTH;
+    int IRRADIANCE_TEXTURE_HEIGHT;
+};
 
 const float PI = 3.14159265358979323846;
 
@@ -2,21 +2,30 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
-layout (location = 4) in mat4 aTransform;
 
-uniform mat4 mProjView;
-uniform vec4 mClipPlane;
+layout (std140) uniform CommonUniforms
+{
+    mat4 mProjView;
+    vec4 mClipPlane;
+    vec3 mCamPos;
+    float mTime;
+    vec2 mCamPlanes;
+};
 
 out vec3 FragPos;
 out vec3 Normal;
 
+/* Decodes instance attributes (Shaders/Instance) */
+mat4 GetInstanceTransform();
+
 void main()
 {
-    vec4 worldTransform = aTransform * vec4(aPos, 1.0);
+    mat4 transform = GetInstanceTransform();
+    vec4 worldTransform = transform * vec4(aPos, 1.0);
     gl_Position = mProjView * worldTransform;
 
     gl_ClipDistance[0] = dot(worldTransform, mClipPlane);
 
     FragPos = worldTransform.xyz;
-    Normal = mat3(aTransform) * aNormal;
+    Normal = mat3(transform) * aNormal;
 }
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330 core
+
+layout (location = 4) in vec4 aRow0;
+layout (location = 5) in vec4 aRow1;
+layout (location = 6) in vec4 aRow2;
+
+mat4 GetInstanceTransform()
+{
+    return transpose(mat4(aRow0, aRow1, aRow2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
\ No newline at end of file
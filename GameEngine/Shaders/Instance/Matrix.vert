@@ -0,0 +1,8 @@
+#version 330 core
+
+layout (location = 4) in mat4 aTransform;
+
+mat4 GetInstanceTransform()
+{
+    return aTransform;
+}
\ No newline at end of file
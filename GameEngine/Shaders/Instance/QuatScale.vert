@@ -0,0 +1,22 @@
+#version 330 core
+
+layout (location = 4) in vec4 aPosScale;
+layout (location = 5) in vec4 aRotation;
+
+mat4 GetInstanceTransform()
+{
+    vec4 q = normalize(aRotation);
+    float s = aPosScale.w;
+
+    vec3 q2 = q.xyz * 2.0;
+    vec3 qq = q.xyz * q2;
+    vec3 qw = q.w * q2;
+    float xy = q.x * q2.y, xz = q.x * q2.z, yz = q.y * q2.z;
+
+    return mat4(
+        vec4(1.0 - qq.y - qq.z, xy + qw.z, xz - qw.y, 0.0) * s,
+        vec4(xy - qw.z, 1.0 - qq.x - qq.z, yz + qw.x, 0.0) * s,
+        vec4(xz + qw.y, yz - qw.x, 1.0 - qq.x - qq.y, 0.0) * s,
+        vec4(aPosScale.xyz, 1.0)
+    );
+}
\ No newline at end of file
@@ -11,9 +11,14 @@ struct Material
 
 ///////////////////////////////////////////////////////////////////////////////
 
-uniform vec3 mCamPos; 
-uniform vec2 mCamPlanes;
-uniform float mTime;
+layout (std140) uniform CommonUniforms
+{
+    mat4 mProjView;
+    vec4 mClipPlane;
+    vec3 mCamPos;
+    float mTime;
+    vec2 mCamPlanes;
+};
 
 uniform Material mMaterial;
 uniform sampler2D mReflectTex;
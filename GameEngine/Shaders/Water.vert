@@ -1,13 +1,15 @@
 #version 330 core
 
 layout (location = 0) in vec2 aPos;
-layout (location = 4) in mat4 aTransform;
 
 out vec2 Vertex;
 out mat4 Transform;
 
+/* Decodes instance attributes (Shaders/Instance) */
+mat4 GetInstanceTransform();
+
 void main()
 {
     Vertex = aPos;
-    Transform = aTransform;
+    Transform = GetInstanceTransform();
 }
\ No newline at end of file
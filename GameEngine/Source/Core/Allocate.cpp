@@ -2,6 +2,10 @@
 
 #include <cstdlib>
 
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void* Alloc(Uint32 size, Uint32 align)
@@ -11,7 +15,7 @@ void* Alloc(Uint32 size, Uint32 align)
 
 	void* ptr = malloc(size + offset);
 	// Calculate start of usable memory
-	void** start = (void**)(((Uint64)ptr + offset) & ~(align - 1));
+	void** start = (void**)(((Uint64)ptr + offset) & ~(Uint64)(align - 1));
 	// Mark start of allocated memory
 	start[-1] = ptr;
 
@@ -28,4 +32,28 @@ void Free(void* ptr)
 	free(((void**)ptr)[-1]);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+void* AllocAligned(Uint32 size, Uint32 align)
+{
+	if (align < sizeof(void*))
+		align = sizeof(void*);
+
+#ifdef _MSC_VER
+	return _aligned_malloc(size, align);
+#else
+	void* ptr = 0;
+	return posix_memalign(&ptr, align, size) == 0 ? ptr : 0;
+#endif
+}
+
+void FreeAligned(void* ptr)
+{
+#ifdef _MSC_VER
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
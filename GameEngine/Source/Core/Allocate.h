@@ -10,6 +10,23 @@ void* Alloc(Uint32 size, Uint32 align = 4);
 /* Free allocated memory */
 void Free(void* ptr);
 
+/* Allocate memory from the system allocator with a large power of two alignment (Doesn't pad size by the alignment like Alloc does) */
+void* AllocAligned(Uint32 size, Uint32 align);
+/* Free memory allocated with AllocAligned() */
+void FreeAligned(void* ptr);
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Default allocator for containers */
+class HeapAllocator
+{
+public:
+	/* Allocate memory */
+	static void* Alloc(Uint32 size, Uint32 align) { return ::Alloc(size, align); }
+	/* Free memory */
+	static void Free(void* ptr) { ::Free(ptr); }
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #endif
\ No newline at end of file
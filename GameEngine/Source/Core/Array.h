@@ -4,12 +4,13 @@
 #include <Core/DataTypes.h>
 #include <Core/Allocate.h>
 
+#include <new>
 #include <utility>
 
 ///////////////////////////////////////////////////////////////////////////////
 
-/* Array of fixed size */
-template <typename T>
+/* Array of fixed size (Allocator A needs static Alloc(size, align) and Free(ptr)) */
+template <typename T, typename A = HeapAllocator>
 class Array
 {
 public:
@@ -37,7 +38,7 @@ public:
 	}
 
 
-	Array(const Array<T>& other) :
+	Array(const Array<T, A>& other) :
 		mStart		(0),
 		mLast		(0),
 		mEnd		(0)
@@ -53,7 +54,7 @@ public:
 		mLast = mStart + size;
 	}
 
-	Array<T>& operator=(const Array<T>& other)
+	Array<T, A>& operator=(const Array<T, A>& other)
 	{
 		if (this != &other)
 		{
@@ -75,7 +76,7 @@ public:
 		return *this;
 	}
 
-	Array(Array<T>&& other) :
+	Array(Array<T, A>&& other) :
 		mStart		(0),
 		mLast		(0),
 		mEnd		(0)
@@ -89,7 +90,7 @@ public:
 		other.mEnd = 0;
 	}
 
-	Array<T>& operator=(Array<T>&& other)
+	Array<T, A>& operator=(Array<T, A>&& other)
 	{
 		if (this != &other)
 		{
@@ -108,6 +109,36 @@ public:
 		return *this;
 	}
 
+	/* Copy from array with a different allocator (Explicit so arrays aren't copied by accident) */
+	template <typename B>
+	explicit Array(const Array<T, B>& other) :
+		mStart		(0),
+		mLast		(0),
+		mEnd		(0)
+	{
+		*this = other;
+	}
+
+	/* Copy from array with a different allocator */
+	template <typename B>
+	Array<T, A>& operator=(const Array<T, B>& other)
+	{
+		// Call element destructors
+		Clear();
+
+		if (other.Size() > Capacity())
+			Reserve(other.Size());
+
+		// Copy all elements
+		Uint32 size = other.Size();
+		for (Uint32 i = 0; i < size; ++i)
+			new(mStart + i)T(other[i]);
+
+		mLast = mStart + size;
+
+		return *this;
+	}
+
 	/* Access array element */
 	T& operator[](Uint32 index) const
 	{
@@ -195,7 +226,7 @@ public:
 
 		if (Capacity() != size)
 		{
-			mStart = (T*)Alloc(size * sizeof(T), alignof(T));
+			mStart = (T*)A::Alloc(size * sizeof(T), alignof(T));
 			mLast = mStart + prevSize;
 			mEnd = mStart + size;
 
@@ -207,7 +238,7 @@ public:
 			}
 
 			// Free prev memory
-			::Free(start);
+			A::Free(start);
 		}
 	}
 
@@ -217,7 +248,7 @@ public:
 		// Free any previous data
 		if (mStart) Free();
 
-		mStart = (T*)Alloc(size * sizeof(T), alignof(T));
+		mStart = (T*)A::Alloc(size * sizeof(T), alignof(T));
 		mLast = mStart + size;
 		mEnd = mLast;
 
@@ -232,7 +263,7 @@ public:
 		// Free any previous data
 		if (mStart) Free();
 
-		mStart = (T*)Alloc(size * sizeof(T), alignof(T));
+		mStart = (T*)A::Alloc(size * sizeof(T), alignof(T));
 		mLast = mStart + size;
 		mEnd = mLast;
 
@@ -248,7 +279,7 @@ public:
 			ptr->~T();
 
 		// Free memory
-		::Free(mStart);
+		A::Free(mStart);
 
 		mStart = 0;
 		mLast = 0;
@@ -0,0 +1,125 @@
+#include <Core/FrameAllocator.h>
+#include <Core/Allocate.h>
+#include <Core/Array.h>
+#include <Core/Thread.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Per thread arena */
+	struct FrameArena
+	{
+		FrameArena() :
+			mBlock		(0),
+			mBlockSize	(0),
+			mOffset		(0)
+		{
+			mOldBlocks.Reserve(4);
+		}
+
+		/* Current memory block */
+		Uint8* mBlock;
+		/* Size of current block */
+		Uint32 mBlockSize;
+		/* Offset of next allocation in current block */
+		Uint32 mOffset;
+		/* Blocks that were filled up this frame */
+		Array<Uint8*> mOldBlocks;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	/* All arenas that have been created */
+	Array<FrameArena*> sArenas;
+	/* Protects arena list */
+	Mutex sArenaMutex;
+
+	/* Arena of current thread */
+	thread_local FrameArena* tArena = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void* FrameAllocator::Alloc(Uint32 size, Uint32 align)
+{
+	FrameArena* arena = tArena;
+
+	// Create arena for this thread
+	if (!arena)
+	{
+		arena = new FrameArena();
+		tArena = arena;
+
+		Lock lock(sArenaMutex);
+		if (!sArenas.Capacity())
+			sArenas.Reserve(16);
+		sArenas.Push(arena);
+	}
+
+	Uint64 start = ((Uint64)(arena->mBlock + arena->mOffset) + align - 1) & ~(Uint64)(align - 1);
+
+	// Get a bigger block if allocation doesn't fit
+	if (!arena->mBlock || start + size > (Uint64)(arena->mBlock + arena->mBlockSize))
+	{
+		if (arena->mBlock)
+			arena->mOldBlocks.Push(arena->mBlock);
+
+		Uint32 blockSize = arena->mBlockSize ? arena->mBlockSize * 2 : FRAME_ARENA_SIZE;
+		while (blockSize < size + align)
+			blockSize *= 2;
+
+		arena->mBlock = (Uint8*)::Alloc(blockSize, 16);
+		arena->mBlockSize = blockSize;
+		arena->mOffset = 0;
+
+		start = ((Uint64)arena->mBlock + align - 1) & ~(Uint64)(align - 1);
+	}
+
+	arena->mOffset = (Uint32)(start + size - (Uint64)arena->mBlock);
+
+	return (void*)start;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FrameAllocator::Reset()
+{
+	Lock lock(sArenaMutex);
+
+	for (Uint32 i = 0; i < sArenas.Size(); ++i)
+	{
+		FrameArena* arena = sArenas[i];
+
+		// Only keep the newest (biggest) block
+		for (Uint32 n = 0; n < arena->mOldBlocks.Size(); ++n)
+			::Free(arena->mOldBlocks[n]);
+		arena->mOldBlocks.Clear();
+
+		arena->mOffset = 0;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FrameAllocator::CleanUp()
+{
+	Lock lock(sArenaMutex);
+
+	for (Uint32 i = 0; i < sArenas.Size(); ++i)
+	{
+		FrameArena* arena = sArenas[i];
+
+		for (Uint32 n = 0; n < arena->mOldBlocks.Size(); ++n)
+			::Free(arena->mOldBlocks[n]);
+		::Free(arena->mBlock);
+
+		delete arena;
+	}
+
+	sArenas.Free();
+	tArena = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
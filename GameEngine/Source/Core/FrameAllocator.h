@@ -0,0 +1,32 @@
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include <Core/DataTypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Initial size of each thread's frame arena (in bytes) */
+#define FRAME_ARENA_SIZE 1024 * 1024
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Linear allocator for temporary memory that only lives until the end of the frame.
+   Each thread bumps through its own arena, so allocations never lock or call malloc
+   (Unless the arena runs out, then it grows and keeps the bigger size) */
+class FrameAllocator
+{
+public:
+	/* Allocate memory from the current thread's arena */
+	static void* Alloc(Uint32 size, Uint32 align);
+	/* Memory is freed all at once in Reset() */
+	static void Free(void* ptr) { }
+
+	/* Free all frame memory of all threads (Call at end of frame, when no jobs are running) */
+	static void Reset();
+	/* Free all arenas */
+	static void CleanUp();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
@@ -8,7 +8,28 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
-typedef Uint16 Handle;
+/* Handle to an element, low 32 bits are the slot index, the next 16 bits are the slot generation */
+typedef Uint64 Handle;
+
+/* Create handle from slot index and generation */
+inline Handle MakeHandle(Uint32 slot, Uint16 generation)
+{
+	return ((Uint64)generation << 32) | slot;
+}
+
+/* Get slot index of handle */
+inline Uint32 HandleSlot(Handle handle)
+{
+	return (Uint32)handle;
+}
+
+/* Get generation of handle */
+inline Uint16 HandleGeneration(Handle handle)
+{
+	return (Uint16)(handle >> 32);
+}
+
+///////////////////////////////////////////////////////////////////////////////
 
 template <typename T>
 class HandleArray
@@ -29,7 +50,7 @@ public:
 	/* Get object using handle */
 	T& operator[](Handle handle) const
 	{
-		return mData[mHandleToIndex[handle]];
+		return mData[mHandleToIndex[HandleSlot(handle)]];
 	}
 
 	/* Add object and return handle */
@@ -44,15 +65,15 @@ public:
 		mData.Push(object);
 
 		// Store current next free entry index
-		Handle handle = (Handle)mNextFree;
+		Uint32 slot = mNextFree;
 		// Update next free index
-		mNextFree = mHandleToIndex[mNextFree];
+		mNextFree = mHandleToIndex[slot];
 		// Map current free slot to added object
-		mHandleToIndex[handle] = index;
+		mHandleToIndex[slot] = index;
 		// Map data index to handle
-		mIndexToHandle[index] = handle;
+		mIndexToHandle[index] = slot;
 
-		return handle;
+		return MakeHandle(slot, mGenerations[slot]);
 	}
 
 	/* Add object and return handle */
@@ -67,40 +88,53 @@ public:
 		mData.Push(std::move(object));
 
 		// Store current next free entry index
-		Handle handle = (Handle)mNextFree;
+		Uint32 slot = mNextFree;
 		// Update next free index
-		mNextFree = mHandleToIndex[handle];
+		mNextFree = mHandleToIndex[slot];
 		// Map current free slot to added object
-		mHandleToIndex[handle] = index;
+		mHandleToIndex[slot] = index;
 		// Map data index to handle
-		mIndexToHandle[index] = handle;
+		mIndexToHandle[index] = slot;
 
-		return handle;
+		return MakeHandle(slot, mGenerations[slot]);
 	}
 
 	/* Remove object using handle */
 	void Remove(Handle handle)
 	{
+		Uint32 slot = HandleSlot(handle);
+
 		// Get index of the item that is being removed
-		Uint32 targetIndex = mHandleToIndex[handle];
+		Uint32 targetIndex = mHandleToIndex[slot];
 
 		// Remove item using a swap pop to avoid item shifting
 		mData.SwapPop(targetIndex);
 
 		// Find the handle of the item that was moved from the end to fill the item that was just removed
-		Handle movedHandle = mIndexToHandle[mData.Size()];
+		Uint32 movedSlot = mIndexToHandle[mData.Size()];
 
 		// Map the moved item's handle to its new index position
-		mHandleToIndex[movedHandle] = targetIndex;
+		mHandleToIndex[movedSlot] = targetIndex;
 
 		// Map the index position of the moved item to its handle
-		mIndexToHandle[targetIndex] = movedHandle;
+		mIndexToHandle[targetIndex] = movedSlot;
 
 		// Store next free handle in the handle position of the item that was removed
-		mHandleToIndex[handle] = mNextFree;
+		mHandleToIndex[slot] = mNextFree;
 
 		// Mark the handle that was removed as the next free
-		mNextFree = handle;
+		mNextFree = slot;
+
+		// Invalidate any handles to the removed item (Skip 0 so null handles are never valid)
+		if (!++mGenerations[slot])
+			mGenerations[slot] = 1;
+	}
+
+	/* Returns true if handle points to an object that hasn't been removed */
+	bool IsValid(Handle handle) const
+	{
+		Uint32 slot = HandleSlot(handle);
+		return slot < mGenerations.Size() && mGenerations[slot] == HandleGeneration(handle);
 	}
 
 	/* Reserve space for handle array */
@@ -112,6 +146,8 @@ public:
 			mData.Clear();
 			mHandleToIndex.Clear();
 			mIndexToHandle.Clear();
+			mGenerations.Clear();
+			mNextFree = 0;
 		}
 
 		// The end of free list will always point to one past the end of previous capacity,
@@ -124,6 +160,7 @@ public:
 		// Reserve mappings
 		mHandleToIndex.Reserve(size);
 		mIndexToHandle.Reserve(size);
+		mGenerations.Reserve(size);
 
 		// Create free list
 		for (Uint32 i = prevCap; i < mHandleToIndex.Capacity(); ++i)
@@ -131,6 +168,8 @@ public:
 			mHandleToIndex.Push(i + 1);
 			// Fill rest of index -> handle with 0s
 			mIndexToHandle.Push(0);
+			// Generations start at 1, so a zero handle is never valid
+			mGenerations.Push(1);
 		}
 	}
 
@@ -160,24 +199,33 @@ public:
 
 
 	/* Map handle to internal index */
-	Uint32 HandleToIndex(Handle handle)
+	Uint32 HandleToIndex(Handle handle) const
 	{
-		return mHandleToIndex[handle];
+		return mHandleToIndex[HandleSlot(handle)];
 	}
 
 	/* Map internal index to handle */
-	Handle IndexToHandle(Uint32 index)
+	Handle IndexToHandle(Uint32 index) const
+	{
+		Uint32 slot = mIndexToHandle[index];
+		return MakeHandle(slot, mGenerations[slot]);
+	}
+
+	/* Get current handle of a slot */
+	Handle SlotToHandle(Uint32 slot) const
 	{
-		return (Handle)mIndexToHandle[index];
+		return MakeHandle(slot, mGenerations[slot]);
 	}
 
 private:
 	/* Array for objects */
 	Array<T> mData;
-	/* Map handles to indices */
-	Array<Uint16> mHandleToIndex;
-	/* Map indices to handles */
-	Array<Uint16> mIndexToHandle;
+	/* Map handle slots to indices (Free slots store the next free slot) */
+	Array<Uint32> mHandleToIndex;
+	/* Map indices to handle slots */
+	Array<Uint32> mIndexToHandle;
+	/* Generation of each slot, incremented when the slot's object is removed */
+	Array<Uint16> mGenerations;
 	/* Index of next free slot */
 	Uint32 mNextFree;
 };
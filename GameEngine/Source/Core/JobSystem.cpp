@@ -0,0 +1,490 @@
+#include <Core/JobSystem.h>
+#include <Core/Thread.h>
+#include <Core/Allocate.h>
+
+#include <condition_variable>
+#include <new>
+#include <assert.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Lock-free work-stealing deque (Chase-Lev).
+	   The owner thread pushes and pops from the bottom, other threads steal from the top */
+	class JobQueue
+	{
+	public:
+		JobQueue() :
+			mJobs		(0),
+			mTop		(0),
+			mBottom		(0)
+		{
+			mJobs = new std::atomic<Job*>[JOB_POOL_SIZE];
+		}
+
+		/* Returns true if push would fail (owner only) */
+		bool IsFull() const
+		{
+			Int64 b = mBottom.load(std::memory_order_relaxed);
+			Int64 t = mTop.load(std::memory_order_acquire);
+			return b - t >= JOB_POOL_SIZE;
+		}
+
+		~JobQueue()
+		{
+			delete[] mJobs;
+		}
+
+		/* Push job (owner only), returns false if queue is full */
+		bool Push(Job* job)
+		{
+			Int64 b = mBottom.load(std::memory_order_relaxed);
+			Int64 t = mTop.load(std::memory_order_acquire);
+			if (b - t >= JOB_POOL_SIZE) return false;
+
+			mJobs[b & (JOB_POOL_SIZE - 1)].store(job, std::memory_order_relaxed);
+			mBottom.store(b + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		/* Pop job (owner only) */
+		Job* Pop()
+		{
+			Int64 b = mBottom.load(std::memory_order_relaxed) - 1;
+			mBottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			Int64 t = mTop.load(std::memory_order_relaxed);
+
+			// Queue is empty
+			if (t > b)
+			{
+				mBottom.store(b + 1, std::memory_order_relaxed);
+				return 0;
+			}
+
+			Job* job = mJobs[b & (JOB_POOL_SIZE - 1)].load(std::memory_order_relaxed);
+
+			// More than one job left, no race with stealers
+			if (t != b) return job;
+
+			// Last job, race against stealers for it
+			if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				job = 0;
+			mBottom.store(b + 1, std::memory_order_relaxed);
+
+			return job;
+		}
+
+		/* Steal job (any thread) */
+		Job* Steal()
+		{
+			Int64 t = mTop.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			Int64 b = mBottom.load(std::memory_order_acquire);
+
+			if (t >= b) return 0;
+
+			Job* job = mJobs[t & (JOB_POOL_SIZE - 1)].load(std::memory_order_acquire);
+			// Another thread got to it first
+			if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				return 0;
+
+			return job;
+		}
+
+	private:
+		/* Ring buffer of jobs */
+		std::atomic<Job*>* mJobs;
+		/* Index stealers take from */
+		std::atomic<Int64> mTop;
+		/* Index owner pushes to */
+		std::atomic<Int64> mBottom;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	/* Per thread data */
+	struct ThreadData
+	{
+		ThreadData() :
+			mJobPool		(0),
+			mNextJob		(0),
+			mNextVictim		(0)
+		{ }
+
+		/* Work queue */
+		JobQueue mQueue;
+		/* Ring buffer of job objects */
+		Job* mJobPool;
+		/* Next job object to allocate */
+		Uint32 mNextJob;
+		/* Next thread to steal from */
+		Uint32 mNextVictim;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	/* Worker threads */
+	Thread* sThreads = 0;
+	/* Data for each thread (Index 0 is main thread) */
+	ThreadData* sThreadData = 0;
+	/* Number of threads, including main thread */
+	Uint32 sNumThreads = 0;
+
+	/* Number of jobs waiting in queues */
+	std::atomic<Uint32> sNumQueued(0);
+	/* True while worker threads should keep running */
+	std::atomic<bool> sIsRunning(false);
+	/* Used to put idle workers to sleep */
+	std::mutex sSleepMutex;
+	std::condition_variable sSleepCondition;
+
+	/* Jobs queued by threads outside the job system */
+	Job** sInjected = 0;
+	/* Number of injected jobs (Checked without the lock before taking one) */
+	std::atomic<Uint32> sNumInjected(0);
+	/* Capacity of injected job list */
+	Uint32 sInjectedCapacity = 0;
+	/* Protects injected job list */
+	std::mutex sInjectMutex;
+
+	/* Index of current thread (Threads that never registered are foreign) */
+	thread_local Uint32 tThreadIndex = JOB_FOREIGN_THREAD;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+JobCounter::JobCounter() :
+	mValue		(0)
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool JobCounter::IsDone() const
+{
+	return mValue.load(std::memory_order_acquire) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Init(Uint32 numThreads)
+{
+	if (sNumThreads) return;
+
+	if (!numThreads)
+		numThreads = std::thread::hardware_concurrency();
+	if (!numThreads)
+		numThreads = 1;
+
+	sNumThreads = numThreads;
+	sThreadData = new ThreadData[sNumThreads];
+
+	for (Uint32 i = 0; i < sNumThreads; ++i)
+	{
+		Job* pool = (Job*)Alloc(JOB_POOL_SIZE * sizeof(Job), 64);
+		for (Uint32 n = 0; n < JOB_POOL_SIZE; ++n)
+			new(pool + n)Job();
+
+		sThreadData[i].mJobPool = pool;
+	}
+
+	// Calling thread is the main thread
+	tThreadIndex = 0;
+	sIsRunning = true;
+
+	// Start workers
+	if (sNumThreads > 1)
+	{
+		sThreads = new Thread[sNumThreads - 1];
+		for (Uint32 i = 1; i < sNumThreads; ++i)
+			sThreads[i - 1].Run(&JobSystem::WorkerLoop, i);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::CleanUp()
+{
+	if (!sNumThreads) return;
+
+	// Wake up and stop workers
+	{
+		std::lock_guard<std::mutex> lock(sSleepMutex);
+		sIsRunning = false;
+	}
+	sSleepCondition.notify_all();
+
+	delete[] sThreads;
+	sThreads = 0;
+
+	for (Uint32 i = 0; i < sNumThreads; ++i)
+		Free(sThreadData[i].mJobPool);
+
+	// Drop injected jobs nobody picked up
+	for (Uint32 i = 0; i < sNumInjected.load(); ++i)
+		delete sInjected[i];
+	delete[] sInjected;
+	sInjected = 0;
+	sNumInjected = 0;
+	sInjectedCapacity = 0;
+
+	delete[] sThreadData;
+	sThreadData = 0;
+	sNumThreads = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Run(JobFunc func, const void* data, Uint32 size, JobCounter* counter, JobCounter* dependency)
+{
+	assert(size <= JOB_DATA_SIZE);
+
+	if (counter)
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+	// Run immediately if job system isn't running
+	if (!sNumThreads)
+	{
+		if (dependency)
+			assert(dependency->IsDone());
+
+		func((void*)data);
+
+		if (counter)
+			counter->mValue.fetch_sub(1, std::memory_order_release);
+		return;
+	}
+
+	// Threads without their own queue can't push to one
+	if (tThreadIndex == JOB_FOREIGN_THREAD)
+	{
+		Inject(func, data, size, counter, dependency);
+		return;
+	}
+
+	ThreadData& thread = sThreadData[tThreadIndex];
+	Job* job = &thread.mJobPool[thread.mNextJob & (JOB_POOL_SIZE - 1)];
+
+	// If queue is full or the next slot is still queued or running, run job now from a stack copy
+	if (thread.mQueue.IsFull() || job->mInUse.load(std::memory_order_acquire))
+	{
+		Job local;
+		local.mFunc = func;
+		local.mCounter = counter;
+		local.mDependency = dependency;
+		local.mInUse.store(true, std::memory_order_relaxed);
+		local.mInjected = false;
+		if (size)
+			memcpy(local.mData, data, size);
+
+		Execute(&local);
+		return;
+	}
+
+	// Claim slot from ring buffer
+	++thread.mNextJob;
+	job->mFunc = func;
+	job->mCounter = counter;
+	job->mDependency = dependency;
+	job->mInUse.store(true, std::memory_order_relaxed);
+	job->mInjected = false;
+	if (size)
+		memcpy(job->mData, data, size);
+
+	// Only the owner pushes, so the queue can't have filled up since the check
+	sNumQueued.fetch_add(1, std::memory_order_release);
+	bool pushed = thread.mQueue.Push(job);
+	assert(pushed);
+	(void)pushed;
+
+	WakeWorker();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Inject(JobFunc func, const void* data, Uint32 size, JobCounter* counter, JobCounter* dependency)
+{
+	Job* job = new Job();
+	job->mFunc = func;
+	job->mCounter = counter;
+	job->mDependency = dependency;
+	job->mInUse.store(true, std::memory_order_relaxed);
+	job->mInjected = true;
+	if (size)
+		memcpy(job->mData, data, size);
+
+	{
+		std::lock_guard<std::mutex> lock(sInjectMutex);
+
+		Uint32 numInjected = sNumInjected.load(std::memory_order_relaxed);
+		if (numInjected == sInjectedCapacity)
+		{
+			Uint32 capacity = sInjectedCapacity ? sInjectedCapacity * 2 : 64;
+			Job** list = new Job*[capacity];
+			if (numInjected)
+				memcpy(list, sInjected, numInjected * sizeof(Job*));
+
+			delete[] sInjected;
+			sInjected = list;
+			sInjectedCapacity = capacity;
+		}
+
+		sInjected[sNumInjected.load(std::memory_order_relaxed)] = job;
+		sNumInjected.fetch_add(1, std::memory_order_release);
+	}
+
+	sNumQueued.fetch_add(1, std::memory_order_release);
+	WakeWorker();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::WakeWorker()
+{
+	// Lock so the wake up can't be missed by a worker about to sleep
+	{
+		std::lock_guard<std::mutex> lock(sSleepMutex);
+	}
+	sSleepCondition.notify_one();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	while (!counter->IsDone())
+	{
+		Job* job = GetJob();
+
+		if (job)
+			Execute(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool JobSystem::RunJob()
+{
+	if (!sNumThreads) return false;
+
+	Job* job = GetJob();
+	if (!job) return false;
+
+	Execute(job);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 JobSystem::GetNumThreads()
+{
+	return sNumThreads ? sNumThreads : 1;
+}
+
+Uint32 JobSystem::GetThreadIndex()
+{
+	return tThreadIndex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+Job* JobSystem::GetJob()
+{
+	Job* job = 0;
+
+	if (tThreadIndex != JOB_FOREIGN_THREAD)
+	{
+		ThreadData& thread = sThreadData[tThreadIndex];
+
+		// Try own queue first
+		job = thread.mQueue.Pop();
+
+		// Otherwise, steal from other threads
+		for (Uint32 i = 0; !job && i < sNumThreads; ++i)
+		{
+			Uint32 victim = thread.mNextVictim++ % sNumThreads;
+			if (victim != tThreadIndex)
+				job = sThreadData[victim].mQueue.Steal();
+		}
+	}
+	else
+	{
+		// Foreign threads have no queue of their own, only steal
+		for (Uint32 i = 0; !job && i < sNumThreads; ++i)
+			job = sThreadData[i].mQueue.Steal();
+	}
+
+	// Take jobs injected by foreign threads last
+	if (!job && sNumInjected.load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::mutex> lock(sInjectMutex);
+
+		Uint32 numInjected = sNumInjected.load(std::memory_order_relaxed);
+		if (numInjected)
+		{
+			job = sInjected[numInjected - 1];
+			sNumInjected.store(numInjected - 1, std::memory_order_relaxed);
+		}
+	}
+
+	if (job)
+		sNumQueued.fetch_sub(1, std::memory_order_relaxed);
+
+	return job;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::Execute(Job* job)
+{
+	// Wait for dependency to finish
+	if (job->mDependency)
+		Wait(job->mDependency);
+
+	job->mFunc(job->mData);
+
+	// Free slot before signalling, the job can't be touched once the counter is decremented
+	JobCounter* counter = job->mCounter;
+	if (job->mInjected)
+		delete job;
+	else
+		job->mInUse.store(false, std::memory_order_release);
+
+	// Mark job as finished
+	if (counter)
+		counter->mValue.fetch_sub(1, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void JobSystem::WorkerLoop(Uint32 index)
+{
+	tThreadIndex = index;
+
+	while (sIsRunning)
+	{
+		Job* job = GetJob();
+
+		if (job)
+			Execute(job);
+		else
+		{
+			// Sleep until more jobs are available
+			std::unique_lock<std::mutex> lock(sSleepMutex);
+			sSleepCondition.wait(lock, []() { return !sIsRunning || sNumQueued.load() > 0; });
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
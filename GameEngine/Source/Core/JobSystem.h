@@ -0,0 +1,154 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <Core/DataTypes.h>
+
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Max number of jobs that can be in flight per thread */
+#define JOB_POOL_SIZE 4096
+/* Size of job data buffer (in bytes) */
+#define JOB_DATA_SIZE 40
+/* Thread index of threads that aren't part of the job system */
+#define JOB_FOREIGN_THREAD 0xFFFFFFFF
+
+/* Job function, data points to a copy of the data passed to JobSystem::Run() */
+typedef void (*JobFunc)(void* data);
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Keeps track of how many jobs are still running */
+class JobCounter
+{
+	friend class JobSystem;
+
+public:
+	JobCounter();
+
+	/* Returns true if all jobs attached to counter are finished */
+	bool IsDone() const;
+
+private:
+	/* Number of unfinished jobs */
+	std::atomic<Uint32> mValue;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct Job
+{
+	/* Function to run */
+	JobFunc mFunc;
+	/* Counter that is decremented when job finishes */
+	JobCounter* mCounter;
+	/* Job won't start until this counter reaches zero */
+	JobCounter* mDependency;
+	/* True while a pooled job is queued or running (Its slot can't be reused until then) */
+	std::atomic<bool> mInUse;
+	/* True if job was allocated for a thread outside the job system (Deleted after it runs) */
+	bool mInjected;
+	/* Copy of job data */
+	Uint8 mData[JOB_DATA_SIZE];
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Fixed pool of worker threads with work-stealing queues */
+class JobSystem
+{
+public:
+	/* Start worker threads (0 uses one thread per hardware thread) */
+	static void Init(Uint32 numThreads = 0);
+	/* Stop all worker threads */
+	static void CleanUp();
+
+	/* Run job. Data is copied, so it doesn't have to stay alive after this call.
+	   Calls from threads outside the job system go through a locked queue, so they are slower */
+	static void Run(JobFunc func, const void* data, Uint32 size,
+		JobCounter* counter = 0, JobCounter* dependency = 0);
+	/* Wait for counter to reach zero (Runs other jobs while waiting) */
+	static void Wait(JobCounter* counter);
+	/* Run one queued job on the current thread, returns false if there were none */
+	static bool RunJob();
+
+	/* Split range into batches and run func(start, end) on each in parallel (Blocks until finished) */
+	template <typename Func>
+	static void ParallelFor(Uint32 start, Uint32 end, Uint32 batchSize, const Func& func);
+
+	/* Get number of threads (including main thread) */
+	static Uint32 GetNumThreads();
+	/* Get index of current thread (Main thread is 0, threads outside the job system get JOB_FOREIGN_THREAD) */
+	static Uint32 GetThreadIndex();
+
+private:
+	/* Runs a single batch of a parallel for */
+	template <typename Func>
+	static void ParallelForJob(void* data);
+
+	/* Get next job to run on current thread */
+	static Job* GetJob();
+	/* Run job and update counter */
+	static void Execute(Job* job);
+	/* Queue job from a thread outside the job system */
+	static void Inject(JobFunc func, const void* data, Uint32 size, JobCounter* counter, JobCounter* dependency);
+	/* Wake up a sleeping worker */
+	static void WakeWorker();
+	/* Worker thread loop */
+	static void WorkerLoop(Uint32 index);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename Func>
+struct ParallelForData
+{
+	/* Function to run */
+	const Func* mFunc;
+	/* Start of range */
+	Uint32 mStart;
+	/* End of range */
+	Uint32 mEnd;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename Func>
+inline void JobSystem::ParallelFor(Uint32 start, Uint32 end, Uint32 batchSize, const Func& func)
+{
+	if (start >= end) return;
+	if (!batchSize) batchSize = 1;
+
+	JobCounter counter;
+
+	// Submit all batches except the first
+	for (Uint32 i = start + batchSize; i < end && i > start; i += batchSize)
+	{
+		ParallelForData<Func> data;
+		data.mFunc = &func;
+		data.mStart = i;
+		data.mEnd = end - i > batchSize ? i + batchSize : end;
+
+		Run(&ParallelForJob<Func>, &data, sizeof(data), &counter);
+	}
+
+	// Run first batch on this thread
+	func(start, end - start > batchSize ? start + batchSize : end);
+
+	// Help out until all batches are done
+	Wait(&counter);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename Func>
+inline void JobSystem::ParallelForJob(void* data)
+{
+	ParallelForData<Func>* range = (ParallelForData<Func>*)data;
+	(*range->mFunc)(range->mStart, range->mEnd);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
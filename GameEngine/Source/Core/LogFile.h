@@ -3,11 +3,18 @@
 
 #include <iostream>
 #include <fstream>
+#include <mutex>
+
+///////////////////////////////////////////////////////////////////////////////
+
+class LogLine;
 
 ///////////////////////////////////////////////////////////////////////////////
 
 class LogFile
 {
+	friend class LogLine;
+
 public:
 	static LogFile gLogFile;
 
@@ -15,23 +22,67 @@ public:
 	LogFile(const char* fname);
 	~LogFile();
 
+	/* Start a log line, the log stays locked until the end of the statement */
+	template <typename T>
+	LogLine operator<<(T val);
+
+private:
 	template <typename T>
-	LogFile& operator<<(T val)
+	void Write(T val)
 	{
 		mFile << val;
 #if _DEBUG
 		std::cout << val;
 #endif
-		return *this;
 	}
 
 private:
 	/* Log file */
 	std::ofstream mFile;
+	/* Protects log file (Recursive so a value that logs while being written doesn't deadlock) */
+	std::recursive_mutex mMutex;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Temporary for a single log statement. Resources are loaded on I/O threads,
+   so the lock is held for the whole line instead of each value */
+class LogLine
+{
+public:
+	LogLine(LogFile& log) :
+		mLog		(log),
+		mLock		(log.mMutex)
+	{
+
+	}
+
+	template <typename T>
+	LogLine& operator<<(T val)
+	{
+		mLog.Write(val);
+		return *this;
+	}
+
+private:
+	/* Log being written to */
+	LogFile& mLog;
+	/* Held until the statement ends */
+	std::unique_lock<std::recursive_mutex> mLock;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+template <typename T>
+inline LogLine LogFile::operator<<(T val)
+{
+	LogLine line(*this);
+	line << val;
+	return line;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 #define LOG LogFile::gLogFile
 #define LOG_INFO LOG << "INFO : "
 #define LOG_WARNING LOG << "WARNING : "
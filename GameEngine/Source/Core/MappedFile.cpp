@@ -0,0 +1,163 @@
+#include <Core/MappedFile.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+MappedFile::MappedFile() :
+	mData			(0),
+	mSize			(0),
+#ifdef WIN32
+	mFile			(INVALID_HANDLE_VALUE),
+	mMapping		(0)
+#else
+	mFile			(-1)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef WIN32
+
+bool MappedFile::Open(const char* fname)
+{
+	Close();
+
+	mFile = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mFile == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || !size.QuadPart)
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mMapping)
+	{
+		Close();
+		return false;
+	}
+
+	mData = (const Uint8*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	mSize = size.QuadPart;
+
+	if (!mData)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MappedFile::Close()
+{
+	if (mData)
+		UnmapViewOfFile(mData);
+	if (mMapping)
+		CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+
+	mData = 0;
+	mSize = 0;
+	mMapping = 0;
+	mFile = INVALID_HANDLE_VALUE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Int64 MappedFile::GetModifiedTime(const char* fname)
+{
+	struct _stat64 info;
+	return _stat64(fname, &info) == 0 ? (Int64)info.st_mtime : 0;
+}
+
+#else
+
+bool MappedFile::Open(const char* fname)
+{
+	Close();
+
+	mFile = open(fname, O_RDONLY);
+	if (mFile < 0) return false;
+
+	struct stat info;
+	if (fstat(mFile, &info) != 0 || !info.st_size)
+	{
+		Close();
+		return false;
+	}
+
+	void* data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	mData = (const Uint8*)data;
+	mSize = info.st_size;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MappedFile::Close()
+{
+	if (mData)
+		munmap((void*)mData, mSize);
+	if (mFile >= 0)
+		close(mFile);
+
+	mData = 0;
+	mSize = 0;
+	mFile = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Int64 MappedFile::GetModifiedTime(const char* fname)
+{
+	struct stat info;
+	return stat(fname, &info) == 0 ? (Int64)info.st_mtime : 0;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+const Uint8* MappedFile::GetData() const
+{
+	return mData;
+}
+
+Uint64 MappedFile::GetSize() const
+{
+	return mSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
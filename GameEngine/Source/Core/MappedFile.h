@@ -0,0 +1,50 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <Core/DataTypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Read only memory mapped file */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+
+	/* Map file into memory */
+	bool Open(const char* fname);
+	/* Unmap file */
+	void Close();
+
+	/* Get mapped file contents */
+	const Uint8* GetData() const;
+	/* Get file size in bytes */
+	Uint64 GetSize() const;
+
+	/* Get last modification time of a file (0 if file doesn't exist) */
+	static Int64 GetModifiedTime(const char* fname);
+
+private:
+	/* Mapped file contents */
+	const Uint8* mData;
+	/* File size in bytes */
+	Uint64 mSize;
+
+#ifdef WIN32
+	/* File handle */
+	void* mFile;
+	/* File mapping handle */
+	void* mMapping;
+#else
+	/* File descriptor */
+	int mFile;
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
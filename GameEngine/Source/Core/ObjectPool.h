@@ -10,19 +10,34 @@
 
 namespace
 {
-	/* Page header (actually goes at end of page) */
+	/* Page header (goes at start of page, pages are aligned to their size) */
 	struct PageHeader
 	{
 		PageHeader() = default;
-		PageHeader(void* start) :
-			mNext		(0),
-			mNextFree	((void**)start)
+		PageHeader(void* pool, void* start) :
+			mPool			(pool),
+			mNext			(0),
+			mNextFreePage	(0),
+			mPrevFreePage	(0),
+			mNextFree		((void**)start),
+			mNumUsed		(0),
+			mHasFreeSlots	(false)
 		{ }
 
+		/* Pool that owns the page */
+		void* mPool;
 		/* Pointer to next page */
-		void* mNext;
+		PageHeader* mNext;
+		/* Next page with free slots */
+		PageHeader* mNextFreePage;
+		/* Previous page with free slots */
+		PageHeader* mPrevFreePage;
 		/* Free list */
 		void** mNextFree;
+		/* Number of used slots */
+		Uint32 mNumUsed;
+		/* True if page is in the list of pages with free slots */
+		bool mHasFreeSlots;
 	};
 }
 
@@ -32,10 +47,11 @@ class ObjectPool
 {
 public:
 	ObjectPool() :
-		mStart		(0),
-		mCurrent	(0),
-		mLast		(0),
-		mPageSize	(1024)
+		mStart			(0),
+		mFreePages		(0),
+		mPageSize		(1024),
+		mPageBytes		(0),
+		mDataOffset		(0)
 	{
 
 	}
@@ -49,18 +65,10 @@ public:
 	ObjectPool& operator=(const ObjectPool& other) = delete;
 
 	ObjectPool(ObjectPool&& other) :
-		mStart		(0),
-		mCurrent	(0)
+		mStart			(0),
+		mFreePages		(0)
 	{
-		mStart = other.mStart;
-		mCurrent = other.mCurrent;
-		mLast = other.mLast;
-		mPageSize = other.mPageSize;
-
-		other.mStart = 0;
-		other.mCurrent = 0;
-		other.mLast = 0;
-		other.mPageSize = 1024;
+		Move(other);
 	}
 
 	ObjectPool& operator=(ObjectPool&& other)
@@ -70,15 +78,7 @@ public:
 			if (mStart)
 				Free();
 
-			mStart = other.mStart;
-			mCurrent = other.mCurrent;
-			mLast = other.mLast;
-			mPageSize = other.mPageSize;
-
-			other.mStart = 0;
-			other.mCurrent = 0;
-			other.mLast = 0;
-			other.mPageSize = 1024;
+			Move(other);
 		}
 
 		return *this;
@@ -87,14 +87,14 @@ public:
 	/* Free (all) memory */
 	void Free()
 	{
-		std::vector<bool> filled(mPageSize, true);
+		Uint32 numPerPage = GetNumPerPage();
+		std::vector<bool> filled(numPerPage, true);
 
-		T* ptr = mStart;
-		while (ptr)
+		PageHeader* header = mStart;
+		while (header)
 		{
-			T* page = ptr;
-			PageHeader* header = (PageHeader*)(page + mPageSize);
-			ptr = (T*)header->mNext;
+			T* page = GetPageData(header);
+			PageHeader* next = header->mNext;
 
 			// Mark which slots were not used
 			T** nextFree = (T**)header->mNextFree;
@@ -105,7 +105,7 @@ public:
 			}
 
 			// Call destructors on ones that are being used
-			for (Uint32 i = 0; i < mPageSize; ++i)
+			for (Uint32 i = 0; i < numPerPage; ++i)
 			{
 				if (filled[i])
 					(page + i)->~T();
@@ -113,71 +113,33 @@ public:
 					filled[i] = true;
 			}
 
-			::Free(page);
+			FreeAligned(header);
+			header = next;
 		}
 
 		mStart = 0;
-		mCurrent = 0;
-		mLast = 0;
+		mFreePages = 0;
 	}
 
 	/* Create new object */
 	T* New()
 	{
-		if (!mStart || !mCurrent)
-		{
-			mStart = AllocPage(mPageSize);
-			mCurrent = mStart;
-			mLast = mCurrent;
-		}
-
-		// Get header of current page
-		PageHeader* header = (PageHeader*)(mCurrent + mPageSize);
-		
-		// If this page is filled up...
-		if (!header->mNextFree)
-		{
-			// Find first page with free slots
-			T* page = mStart;
-			// While current page exists...
-			while (page)
-			{
-				header = (PageHeader*)(page + mPageSize);
-				// If this page has open slots, break loop
-				if (header->mNextFree) break;
-
-				// Go to next page
-				page = (T*)header->mNext;
-			}
+		// Allocate new page if all pages are full
+		if (!mFreePages)
+			AllocPage();
 
-			// If a page with empty slots was found...
-			if (page)
-			{
-				// Make this page the current
-				mCurrent = page;
-			}
-
-			// Otherwise...
-			else
-			{
-				// Allocate new block
-				mCurrent = AllocPage(mPageSize);
-				// Make header of the last page point to new page
-				header = (PageHeader*)(mLast + mPageSize);
-				header->mNext = mCurrent;
-
-				// Update header
-				header = (PageHeader*)(mCurrent + mPageSize);
-				// Update last page
-				mLast = mCurrent;
-			}
-		}
+		PageHeader* header = mFreePages;
 
 		// Next free stores pointer to slot location
 		T* ptr = (T*)header->mNextFree;
 
 		// Update next free
 		header->mNextFree = (void**)(*header->mNextFree);
+		++header->mNumUsed;
+
+		// Page is full
+		if (!header->mNextFree)
+			RemoveFreePage(header);
 
 		// Initialize object
 		new(ptr)T();
@@ -188,39 +150,62 @@ public:
 	/* Free object */
 	void Free(T* ptr)
 	{
-		// Find which page pointer belongs to
-		T* page = mStart;
-		while (page)
-		{
-			// If pointer is inside block, then break from loop
-			if (ptr >= page && ptr < page + mPageSize) break;
-
-			// Go to next page
-			page = (T*)((PageHeader*)(page + mPageSize))->mNext;
-		}
+		if (!ptr || !mStart) return;
 
-		if (!page) return;
+		// Pages are aligned to their size, so the header is found by masking the pointer
+		PageHeader* header = (PageHeader*)((Uint64)ptr & ~(Uint64)(mPageBytes - 1));
+		if (header->mPool != this) return;
 
 		// Call destructor
 		ptr->~T();
 
 		// Update free list
-		PageHeader* header = (PageHeader*)(page + mPageSize);
 		*(void**)ptr = (void*)header->mNextFree;
 		header->mNextFree = (void**)ptr;
+		--header->mNumUsed;
+
+		// Page has free slots again
+		if (!header->mHasFreeSlots)
+			AddFreePage(header);
 	}
 
 	/* Set page size if nothing has been allocated yet */
 	void SetPageSize(Uint32 size)
 	{
-		mPageSize = size;
+		if (!mStart)
+			mPageSize = size;
 	}
 
 private:
-	/* Allocate page */
-	T* AllocPage(Uint32 size)
+	/* Get number of objects that fit in a page */
+	Uint32 GetNumPerPage() const
+	{
+		return mPageBytes ? (mPageBytes - mDataOffset) / sizeof(T) : 0;
+	}
+
+	/* Get pointer to first object in page */
+	T* GetPageData(PageHeader* header) const
+	{
+		return (T*)((Uint8*)header + mDataOffset);
+	}
+
+	/* Allocate page and add it to the list of pages with free slots */
+	void AllocPage()
 	{
-		T* ptr = (T*)Alloc(size * sizeof(T) + sizeof(PageHeader), alignof(T));
+		if (!mPageBytes)
+		{
+			// Objects start after header
+			mDataOffset = (sizeof(PageHeader) + alignof(T) - 1) & ~(Uint32)(alignof(T) - 1);
+
+			// Round page up to power of two so it can be aligned to its size
+			Uint32 size = mDataOffset + (mPageSize ? mPageSize : 1) * sizeof(T);
+			for (mPageBytes = 64; mPageBytes < size; mPageBytes <<= 1);
+		}
+
+		// Alloc() pads by the alignment, which would nearly double every page
+		PageHeader* header = (PageHeader*)AllocAligned(mPageBytes, mPageBytes);
+		T* ptr = GetPageData(header);
+		Uint32 size = GetNumPerPage();
 
 		// Initialize free list
 		T* end = ptr + size;
@@ -228,20 +213,74 @@ private:
 			*(void**)start = start + 1;
 		*(void**)(ptr + size - 1) = 0;
 
-		*(PageHeader*)(ptr + size) = PageHeader(ptr);
+		*header = PageHeader(this, ptr);
 
-		return ptr;
+		// Add to list of all pages
+		header->mNext = mStart;
+		mStart = header;
+
+		AddFreePage(header);
+	}
+
+	/* Add page to list of pages with free slots */
+	void AddFreePage(PageHeader* header)
+	{
+		header->mPrevFreePage = 0;
+		header->mNextFreePage = mFreePages;
+		if (mFreePages)
+			mFreePages->mPrevFreePage = header;
+
+		mFreePages = header;
+		header->mHasFreeSlots = true;
+	}
+
+	/* Remove page from list of pages with free slots */
+	void RemoveFreePage(PageHeader* header)
+	{
+		if (header->mPrevFreePage)
+			header->mPrevFreePage->mNextFreePage = header->mNextFreePage;
+		else
+			mFreePages = header->mNextFreePage;
+
+		if (header->mNextFreePage)
+			header->mNextFreePage->mPrevFreePage = header->mPrevFreePage;
+
+		header->mNextFreePage = 0;
+		header->mPrevFreePage = 0;
+		header->mHasFreeSlots = false;
+	}
+
+	/* Take pages from other pool */
+	void Move(ObjectPool& other)
+	{
+		mStart = other.mStart;
+		mFreePages = other.mFreePages;
+		mPageSize = other.mPageSize;
+		mPageBytes = other.mPageBytes;
+		mDataOffset = other.mDataOffset;
+
+		// Update page owners
+		for (PageHeader* header = mStart; header; header = header->mNext)
+			header->mPool = this;
+
+		other.mStart = 0;
+		other.mFreePages = 0;
+		other.mPageSize = 1024;
+		other.mPageBytes = 0;
+		other.mDataOffset = 0;
 	}
 
 private:
-	/* Ptr to data */
-	T* mStart;
-	/* Current page */
-	T* mCurrent;
-	/* Last page */
-	T* mLast;
-	/* Page size */
+	/* List of all pages */
+	PageHeader* mStart;
+	/* List of pages with free slots */
+	PageHeader* mFreePages;
+	/* Minimum number of objects per page */
 	Uint32 mPageSize;
+	/* Size of each page in bytes (Power of two) */
+	Uint32 mPageBytes;
+	/* Offset of first object from page start */
+	Uint32 mDataOffset;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
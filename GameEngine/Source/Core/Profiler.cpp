@@ -4,27 +4,56 @@
 
 #include <fstream>
 
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Per thread event buffer */
+	struct ProfilerThreadData
+	{
+		ProfilerThreadData(Uint32 index) :
+			mNumEvents		(0),
+			mDepth			(0),
+			mIndex			(index)
+		{
+			mEvents.Resize(PROFILER_BUFFER_SIZE);
+		}
+
+		/* Ring buffer of finished events */
+		Array<ProfilerEvent> mEvents;
+		/* Total number of events recorded */
+		Uint32 mNumEvents;
+		/* Current nesting depth */
+		Uint32 mDepth;
+		/* Index of thread (In order of first marker) */
+		Uint32 mIndex;
+	};
+
+	///////////////////////////////////////////////////////////////////////////
+
+	/* All thread buffers */
+	Array<ProfilerThreadData*> sThreads;
+
+	/* Buffer of current thread */
+	thread_local ProfilerThreadData* tThread = 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-ProfilerMarker::ProfilerMarker(const char* name, const char* fname, Uint32 lineNum, Uint32 id) :
+ProfilerMarker::ProfilerMarker(const char* name, Uint32 id) :
 	mName			(name),
-	mFileName		(fname),
-	mLineNum		(lineNum),
 	mID				(id),
 	mStartTime		(ClockImpl()),
-	mTotalTime		(0),
 	mIsActive		(true)
 {
-
+	Profiler::PushMarker();
 }
 
 ProfilerMarker::~ProfilerMarker()
 {
 	// Stop profiler when it is destroyed
 	Stop();
-	// Record data before destruction
-	Profiler::RecordMarker(*this);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -33,7 +62,7 @@ void ProfilerMarker::Stop()
 {
 	if (mIsActive)
 	{
-		mTotalTime += ClockImpl() - mStartTime;
+		Profiler::RecordMarker(mName, mID, mStartTime, ClockImpl());
 		mIsActive = false;
 	}
 }
@@ -45,70 +74,66 @@ const char* ProfilerMarker::GetName() const
 	return mName;
 }
 
-const char* ProfilerMarker::GetFileName() const
-{
-	return mFileName;
-}
-
-Uint32 ProfilerMarker::GetLineNum() const
-{
-	return mLineNum;
-}
-
 Uint32 ProfilerMarker::GetID() const
 {
 	return mID;
 }
 
-Uint64 ProfilerMarker::GetTotalTime() const
-{
-	return mTotalTime;
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-std::map<std::string, ProfilerData> Profiler::mData;
+Uint64 Profiler::mFrameTimes[PROFILER_MAX_FRAMES];
+Uint32 Profiler::mNumFrames = 0;
+Mutex Profiler::mMutex;
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Profiler::RecordMarker(const ProfilerMarker& marker)
+void Profiler::BeginFrame()
 {
-	// Get marker data
-	ProfilerData& data = mData[marker.GetName()];
+	mFrameTimes[mNumFrames++ % PROFILER_MAX_FRAMES] = ClockImpl();
+}
+
+///////////////////////////////////////////////////////////////////////////////
 
-	// Create data object if needed
-	if (!data.mTotalTimes.Capacity())
+void Profiler::PushMarker()
+{
+	// Create buffer first time a thread uses the profiler
+	if (!tThread)
 	{
-		data.mTotalTimes.Reserve(1);
-		data.mNumRuns.Reserve(1);
+		Lock lock(mMutex);
 
-		data.mName = marker.GetName();
-		data.mFileName = marker.GetFileName();
-		data.mLineNum = marker.GetLineNum();
-	}
+		if (!sThreads.Capacity())
+			sThreads.Reserve(16);
 
-	// Create new data objects to fit ID
-	Uint32 id = marker.GetID();
-	if (id >= data.mTotalTimes.Size())
-	{
-		for (Uint32 i = data.mTotalTimes.Size(); i <= id; ++i)
-		{
-			data.mTotalTimes.Push(0);
-			data.mNumRuns.Push(0);
-		}
+		tThread = new ProfilerThreadData(sThreads.Size());
+		sThreads.Push(tThread);
 	}
 
-	// Update values
-	data.mTotalTimes[id] += marker.GetTotalTime();
-	++data.mNumRuns[id];
+	++tThread->mDepth;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
+
+void Profiler::RecordMarker(const char* name, Uint32 id, Uint64 start, Uint64 end)
+{
+	ProfilerThreadData* thread = tThread;
+	ProfilerEvent& e = thread->mEvents[thread->mNumEvents++ & (PROFILER_BUFFER_SIZE - 1)];
+
+	e.mName = name;
+	e.mStartTime = start;
+	e.mEndTime = end;
+	e.mID = id;
+	e.mDepth = --thread->mDepth;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
-void Profiler::Log(const char* fname)
+void Profiler::ExportTrace(const char* fname, Uint32 numFrames)
 {
+	Lock lock(mMutex);
+
+	if (!mNumFrames) return;
+
 	// Open file
 	std::ofstream f(fname);
 	if (!f.is_open())
@@ -117,27 +142,57 @@ void Profiler::Log(const char* fname)
 		return;
 	}
 
-	for (auto it = mData.begin(); it != mData.end(); ++it)
+	if (numFrames > mNumFrames)
+		numFrames = mNumFrames;
+	if (numFrames > PROFILER_MAX_FRAMES)
+		numFrames = PROFILER_MAX_FRAMES;
+
+	// Only export events after the start of the first exported frame
+	Uint32 firstFrame = mNumFrames - numFrames;
+	Uint64 startTime = mFrameTimes[firstFrame % PROFILER_MAX_FRAMES];
+	Uint64 endTime = ClockImpl();
+
+	f << "{\"traceEvents\":[\n";
+
+	// Frames (On their own track after all threads)
+	Uint32 frameTrack = sThreads.Size();
+	f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << frameTrack
+		<< ",\"args\":{\"name\":\"Frames\"}},\n";
+
+	for (Uint32 i = firstFrame; i < mNumFrames; ++i)
+	{
+		Uint64 start = mFrameTimes[i % PROFILER_MAX_FRAMES];
+		Uint64 end = i + 1 < mNumFrames ? mFrameTimes[(i + 1) % PROFILER_MAX_FRAMES] : endTime;
+
+		f << "{\"name\":\"Frame " << i << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << frameTrack
+			<< ",\"ts\":" << start - startTime << ",\"dur\":" << end - start << "},\n";
+	}
+
+	// Events of each thread
+	for (Uint32 i = 0; i < sThreads.Size(); ++i)
 	{
-		const ProfilerData& data = it->second;
+		ProfilerThreadData* thread = sThreads[i];
+
+		f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->mIndex
+			<< ",\"args\":{\"name\":\"Thread " << thread->mIndex << "\"}},\n";
 
-		// Loop IDs
-		for (Uint32 i = 0; i < data.mTotalTimes.Size(); ++i)
+		// Oldest event still in ring buffer
+		Uint32 first = thread->mNumEvents > PROFILER_BUFFER_SIZE ? thread->mNumEvents - PROFILER_BUFFER_SIZE : 0;
+
+		for (Uint32 n = first; n < thread->mNumEvents; ++n)
 		{
-			// Seperator
-			f << "==================================\n";
-			// Title
-			f << data.mName << " - " << i << "\n";
-			// Location info
-			f << data.mFileName << " - Line " << data.mLineNum << "\n";
-
-			// Data
-			double mean = (double)(data.mTotalTimes[i] / data.mNumRuns[i]) / 1000.0;
-			f << "Mean - " << mean << " ms\n";
-
-			f << "\n";
+			const ProfilerEvent& e = thread->mEvents[n & (PROFILER_BUFFER_SIZE - 1)];
+			if (e.mStartTime < startTime) continue;
+
+			f << "{\"name\":\"" << e.mName << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread->mIndex
+				<< ",\"ts\":" << e.mStartTime - startTime << ",\"dur\":" << e.mEndTime - e.mStartTime
+				<< ",\"args\":{\"id\":" << e.mID << ",\"depth\":" << e.mDepth << "}},\n";
 		}
 	}
+
+	// Process name last, so the list doesn't end with a comma
+	f << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"GameEngine\"}}\n";
+	f << "]}\n";
 }
 
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -3,16 +3,38 @@
 
 #include <Core/DataTypes.h>
 #include <Core/Array.h>
+#include <Core/Thread.h>
 
-#include <string>
-#include <map>
+///////////////////////////////////////////////////////////////////////////////
+
+/* Number of events each thread keeps (Power of two) */
+#define PROFILER_BUFFER_SIZE 65536
+/* Number of frames that are kept for export */
+#define PROFILER_MAX_FRAMES 256
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Single timed region */
+struct ProfilerEvent
+{
+	/* Name of the marker (Points to a string literal, so names are never copied or compared) */
+	const char* mName;
+	/* Start time (microseconds) */
+	Uint64 mStartTime;
+	/* End time (microseconds) */
+	Uint64 mEndTime;
+	/* Marker ID */
+	Uint32 mID;
+	/* Number of markers this one is nested in */
+	Uint32 mDepth;
+};
 
 ///////////////////////////////////////////////////////////////////////////////
 
 class ProfilerMarker
 {
 public:
-	ProfilerMarker(const char* name, const char* fname, Uint32 lineNum, Uint32 id);
+	ProfilerMarker(const char* name, Uint32 id = 0);
 	~ProfilerMarker();
 
 	/* Stop recording time */
@@ -20,81 +42,62 @@ public:
 
 	/* Get name */
 	const char* GetName() const;
-	/* Get file name marker is in */
-	const char* GetFileName() const;
-	/* Get line number of marker */
-	Uint32 GetLineNum() const;
 	/* Get marker ID */
 	Uint32 GetID() const;
-	/* Get total runtime */
-	Uint64 GetTotalTime() const;
 
 private:
 	/* Name of the marker */
 	const char* mName;
-	/* File that marker was put in */
-	const char* mFileName;
-	/* Line of code of the marker */
-	Uint32 mLineNum;
-
 	/* Marker ID */
 	Uint32 mID;
 
 	/* Start time */
 	Uint64 mStartTime;
-	/* Total time */
-	Uint64 mTotalTime;
 	/* True if profiler is active for this marker */
 	bool mIsActive;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
-/* Keeps track of data for each profiler marker */
-struct ProfilerData
-{
-	/* List of total times */
-	Array<Uint64> mTotalTimes;
-	/* List of number of times each marker has run */
-	Array<Uint32> mNumRuns;
-
-	/* Name of the marker */
-	const char* mName;
-	/* File that marker was put in */
-	const char* mFileName;
-	/* Line of code of the marker */
-	Uint32 mLineNum;
-};
-
-///////////////////////////////////////////////////////////////////////////////
-
+/* Records nested timed regions into per-thread ring buffers */
 class Profiler
 {
+	friend ProfilerMarker;
+
 public:
-	/* Record data from marker */
-	static void RecordMarker(const ProfilerMarker& marker);
+	/* Mark start of a new frame (Call from main thread) */
+	static void BeginFrame();
 
-	/* Log data to file */
-	static void Log(const char* fname);
+	/* Export the last few frames in Chrome trace event format (chrome://tracing).
+	   Call between frames, while no other threads are recording */
+	static void ExportTrace(const char* fname, Uint32 numFrames = PROFILER_MAX_FRAMES);
+
+private:
+	/* Start of a marker on the current thread */
+	static void PushMarker();
+	/* Record a finished marker on the current thread */
+	static void RecordMarker(const char* name, Uint32 id, Uint64 start, Uint64 end);
 
 private:
-	/* Profiler data */
-	static std::map<std::string, ProfilerData> mData;
+	/* Start time of recent frames (Ring buffer) */
+	static Uint64 mFrameTimes[PROFILER_MAX_FRAMES];
+	/* Number of frames that have started */
+	static Uint32 mNumFrames;
+	/* Protects list of thread buffers */
+	static Mutex mMutex;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <Core/Macros.h>
 
-#define _PROFILE_NO_ID(name) ProfilerMarker CONCAT(Profiler_, name)(STR(name), FILE_NAME, __LINE__, 0);
-#define _PROFILE_ID(name, id) ProfilerMarker CONCAT(Profiler_, name)(STR(name), FILE_NAME, __LINE__, id);
+#define _PROFILE_NO_ID(name) ProfilerMarker CONCAT(Profiler_, name)(STR(name));
+#define _PROFILE_ID(name, id) ProfilerMarker CONCAT(Profiler_, name)(STR(name), id);
 
 #define _CHOOSE_PROFILER_FUNC(a, b, x, ...) x
 #define START_PROFILER(...) EXPAND(_CHOOSE_PROFILER_FUNC(__VA_ARGS__, _PROFILE_ID, _PROFILE_NO_ID)(__VA_ARGS__))
 
-#define STOP_PROFILER(name) \
-CONCAT(Profiler_, name).Stop(); \
-Profiler::RecordMarker(CONCAT(Profiler_, name));
+#define STOP_PROFILER(name) CONCAT(Profiler_, name).Stop();
 
 ///////////////////////////////////////////////////////////////////////////////
 
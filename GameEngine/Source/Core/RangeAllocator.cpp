@@ -0,0 +1,111 @@
+#include <Core/RangeAllocator.h>
+
+#include <assert.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+RangeAllocator::RangeAllocator() :
+	mSize			(0)
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::Init(Uint32 size)
+{
+	mFreeRanges.Clear();
+	if (!mFreeRanges.Capacity())
+		mFreeRanges.Reserve(16);
+
+	mSize = size;
+	if (size)
+		mFreeRanges.Push(Range{ 0, size });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::Grow(Uint32 size)
+{
+	if (size <= mSize) return;
+
+	Uint32 end = mSize;
+	mSize = size;
+
+	Free(end, size - end);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool RangeAllocator::Allocate(Uint32 size, Uint32& offset)
+{
+	for (Uint32 i = 0; i < mFreeRanges.Size(); ++i)
+	{
+		Range& range = mFreeRanges[i];
+		if (range.mSize < size) continue;
+
+		// Take from the start of the first range that fits
+		offset = range.mOffset;
+		range.mOffset += size;
+		range.mSize -= size;
+
+		if (!range.mSize)
+			mFreeRanges.Remove(i);
+
+		return true;
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void RangeAllocator::Free(Uint32 offset, Uint32 size)
+{
+	if (!size) return;
+	assert(offset + size <= mSize);
+
+	if (!mFreeRanges.Capacity())
+		mFreeRanges.Reserve(16);
+
+	// Find first free range after the freed one
+	Uint32 index = 0;
+	for (; index < mFreeRanges.Size() && mFreeRanges[index].mOffset < offset; ++index);
+
+	bool mergePrev = index > 0 && mFreeRanges[index - 1].mOffset + mFreeRanges[index - 1].mSize == offset;
+	bool mergeNext = index < mFreeRanges.Size() && offset + size == mFreeRanges[index].mOffset;
+
+	if (mergePrev && mergeNext)
+	{
+		// Fills the gap between two free ranges
+		mFreeRanges[index - 1].mSize += size + mFreeRanges[index].mSize;
+		mFreeRanges.Remove(index);
+	}
+	else if (mergePrev)
+		mFreeRanges[index - 1].mSize += size;
+	else if (mergeNext)
+	{
+		mFreeRanges[index].mOffset = offset;
+		mFreeRanges[index].mSize += size;
+	}
+	else
+	{
+		// Insert new range, shifting the rest up
+		mFreeRanges.Push(Range{ offset, size });
+		for (Uint32 i = mFreeRanges.Size() - 1; i > index; --i)
+			mFreeRanges[i] = mFreeRanges[i - 1];
+		mFreeRanges[index] = Range{ offset, size };
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 RangeAllocator::GetSize() const
+{
+	return mSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
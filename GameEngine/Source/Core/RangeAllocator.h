@@ -0,0 +1,46 @@
+#ifndef RANGE_ALLOCATOR_H
+#define RANGE_ALLOCATOR_H
+
+#include <Core/DataTypes.h>
+#include <Core/Array.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Suballocates ranges of a fixed size space (i.e. a buffer) using a first fit free list.
+   Units are up to the user, the allocator never touches the underlying memory */
+class RangeAllocator
+{
+public:
+	RangeAllocator();
+
+	/* Reset allocator to a single free range of the given size */
+	void Init(Uint32 size);
+	/* Extend space at the end (Existing ranges keep their offsets) */
+	void Grow(Uint32 size);
+
+	/* Allocate a range, returns false if no free range is large enough */
+	bool Allocate(Uint32 size, Uint32& offset);
+	/* Free a range (Merges with neighbouring free ranges) */
+	void Free(Uint32 offset, Uint32 size);
+
+	/* Get total size of space */
+	Uint32 GetSize() const;
+
+private:
+	struct Range
+	{
+		/* Start of range */
+		Uint32 mOffset;
+		/* Size of range */
+		Uint32 mSize;
+	};
+
+	/* Free ranges sorted by offset */
+	Array<Range> mFreeRanges;
+	/* Total size of space */
+	Uint32 mSize;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
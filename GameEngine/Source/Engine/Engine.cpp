@@ -4,6 +4,10 @@
 #include <Core/Sleep.h>
 #include <Core/LogFile.h>
 #include <Core/Profiler.h>
+#include <Core/JobSystem.h>
+#include <Core/FrameAllocator.h>
+
+#include <Resource/AsyncLoader.h>
 
 #include <Scene/Scene.h>
 
@@ -22,6 +26,11 @@ Engine::Engine() :
 
 bool Engine::Init(const Engine::Params& params)
 {
+	// Start worker threads
+	JobSystem::Init();
+	// Start file loading threads
+	AsyncLoader::Init();
+
 	// Create window
 	bool success = mWindow.Create(
 		params.mWindowWidth,
@@ -52,10 +61,16 @@ void Engine::Start()
 
 	while (mWindow.IsOpen())
 	{
+		Profiler::BeginFrame();
 		START_PROFILER(GameLoop);
 
 		float elapsed = clock.Restart();
 
+		// Finish resources loaded in the background
+		START_PROFILER(ResourceUploads);
+		AsyncLoader::ProcessMain();
+		STOP_PROFILER(ResourceUploads);
+
 		// Game logic
 		mWindow.PollEvents();
 		mScene->Update(elapsed);
@@ -67,6 +82,9 @@ void Engine::Start()
 
 		STOP_PROFILER(GameLoop);
 
+		// Free temporary memory used this frame
+		FrameAllocator::Reset();
+
 		// Get work time
 		float workTime = clock.GetElapsedTime();
 		float sleepTime = mLoopDuration - workTime;
@@ -87,10 +105,17 @@ void Engine::Stop()
 		delete mScene;
 	}
 
+	// Stop file loading threads while the GL context still exists
+	AsyncLoader::CleanUp();
+
 	mWindow.CleanUp();
 
-	// Print profiler log
-	Profiler::Log("profiler.log");
+	// Stop worker threads
+	JobSystem::CleanUp();
+	FrameAllocator::CleanUp();
+
+	// Save timeline of the last frames (Open in chrome://tracing)
+	Profiler::ExportTrace("profiler.json");
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -136,8 +161,7 @@ float Engine::GetLoopDuration() const
 
 void Engine::SetScene(Scene* scene)
 {
-	/* TODO : multithread */
-	// For now, single-threaded scene loading
+	// Scenes can start loads with Resource<T>::LoadAsync() so file reads and decoding don't block here
 	scene->Create(this);
 
 	// Clean up previous scene
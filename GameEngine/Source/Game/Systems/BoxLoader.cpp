@@ -8,17 +8,21 @@
 #include <Graphics/Model.h>
 #include <Graphics/Material.h>
 #include <Graphics/Shader.h>
+#include <Graphics/Terrain.h>
 
 #include <Game/Objects/PlayerObject.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-BoxLoader::BoxLoader()
+BoxLoader::BoxLoader() :
+	mModel			(0),
+	mTerrain		(0)
 {
 	mLoadRange = 100.0f;
 	mUnloadRange = 120.0f;
 	mChunkSize = 8.0f;
+	mStreaming = true;
 }
 
 BoxLoader::~BoxLoader()
@@ -48,24 +52,38 @@ void BoxLoader::OnInit()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void BoxLoader::OnChunkEnter(ObjectChunk& chunk)
+void BoxLoader::SetTerrain(Terrain* terrain)
+{
+	mTerrain = terrain;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BoxLoader::OnChunkPrepare(ObjectChunk& chunk)
 {
-	ComponentMap components;
-	Array<GameObjectID> objects = mScene->CreateObjects<PlayerObject>(4, &components);
 	Vector3f s = chunk.GetBoundingBox().mMin;
 
-	TransformComponent* t = components.Get<TransformComponent>();
-	RenderComponent* r = components.Get<RenderComponent>();
+	Vector2f points[4];
+	for (Uint32 i = 0; i < 4; ++i)
+		points[i] = Vector2f(s.x + 5.0f, s.z + (i * 1.5f) + 1.0f);
 
-	for (Uint32 i = 0; i < objects.Size(); ++i)
+	// Place boxes on the terrain (Fixed height without one)
+	float heights[4] = { 10.0f, 10.0f, 10.0f, 10.0f };
+	if (mTerrain)
+		mTerrain->GetHeights(points, 4, heights);
+
+	for (Uint32 i = 0; i < 4; ++i)
 	{
-		t[i].mPosition = Vector3f(s.x + 5.0f, 10.0f, s.z + (i * 1.5f) + 1.0f);
-		t[i].mScale = 0.5f;
-		r[i].mModel = mModel;
+		Vector3f pos(points[i].x, heights[i], points[i].y);
+		chunk.AddPlacement(pos, Vector3f(0.0f), 0.5f, mModel);
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
 
-	// Add to chunk
-	chunk.AddRenderables(mRenderer, objects, components);
+void BoxLoader::OnChunkEnter(ObjectChunk& chunk)
+{
+	CommitPlacements<PlayerObject>(chunk);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 
 class Renderer;
 class Model;
+class Terrain;
 
 class BoxLoader : public ObjectLoader
 {
@@ -16,9 +17,14 @@ public:
 	BoxLoader();
 	~BoxLoader();
 
+	/* Set terrain boxes are placed on */
+	void SetTerrain(Terrain* terrain);
+
 private:
 	/* Called during inialization */
 	void OnInit() override;
+	/* Called on a worker thread before chunk enters range */
+	void OnChunkPrepare(ObjectChunk& chunk) override;
 	/* Called when chunk enters range */
 	void OnChunkEnter(ObjectChunk& chunk) override;
 	/* Called when chunk leaves range */
@@ -26,7 +32,8 @@ private:
 
 private:
 	Model* mModel;
-
+	/* Terrain boxes are placed on */
+	Terrain* mTerrain;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -40,6 +40,9 @@ void InputSystem::OnInit()
 
 	// Set cursor disabled
 	mInput->SetCursorMode(Input::Disabled);
+
+	// Input and camera can only be used on the main thread
+	SetMainThread(true);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1,26 +1,54 @@
 #include <Game/Terrain/BiomeMap.h>
 
+#include <Core/JobSystem.h>
+
 #include <Resource/Resource.h>
 
 #include <Graphics/Image.h>
 #include <Graphics/Texture.h>
+#include <Graphics/TiledHeightMap.h>
 
-#include <SimplexNoise.h>
-
+#include <algorithm>
+#include <cstdlib>
 #include <assert.h>
 
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Get number of tiles each job should generate */
+	Uint32 GetTileBatchSize(Uint32 num)
+	{
+		// A few batches per thread so uneven tiles balance out
+		Uint32 batchSize = num / (JobSystem::GetNumThreads() * 4);
+		return batchSize ? batchSize : 1;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
 BiomeMap::BiomeMap() :
+	mNumTilesX		(0),
+	mNumTilesY		(0),
 	mImage			(0),
-	mHeightMap		(0)
+	mHeightMap		(0),
+	mTiledHeightMap	(0),
+	mRegionSize		(0.0f),
+	mRegionRes		(0),
+	mRegionHeights	(0),
+	mHeights		(0)
 {
 	mImage = Resource<Image>::Create();
 }
 
 BiomeMap::~BiomeMap()
 {
+	for (Uint32 i = 0; i < mFilters.Size(); ++i)
+		free(mFilters[i].mNoise);
+
+	free(mRegionHeights);
+
 	if (mImage)
 		Resource<Image>::Free(mImage);
 }
@@ -31,11 +59,32 @@ BiomeMap::~BiomeMap()
 void BiomeMap::SetHeightMap(Texture* map)
 {
 	mHeightMap = map;
+	mTiledHeightMap = 0;
+	mTiles.Clear();
+}
+
+void BiomeMap::SetHeightMap(TiledHeightMap* map, float size, Uint32 res)
+{
+	mHeightMap = 0;
+	mTiledHeightMap = map;
+	mRegionSize = size;
+	mRegionRes = res;
+	mTiles.Clear();
+
+	// Region is sampled again on the next generate
+	free(mRegionHeights);
+	mRegionHeights = 0;
 }
 
 void BiomeMap::AddColor(const Vector3f& color, float h)
 {
 	mBiomes[h] = color;
+
+	// Heights above the previous level now use this biome, and so do all heights above it if it is the last level
+	auto it = mBiomes.find(h);
+	float min = it == mBiomes.begin() ? -1.0f : std::prev(it)->first;
+	float max = std::next(it) == mBiomes.end() ? 2.0f : h;
+	MarkDirty(min, max);
 }
 
 void BiomeMap::AddColorFilter(const Vector3f& color, Uint32 octaves, float freq, float amp)
@@ -54,79 +103,260 @@ void BiomeMap::AddColorFilter(const Vector3f& color, Uint32 octaves, float freq,
 	filter.mOctaves = octaves;
 	filter.mFreq = freq;
 	filter.mAmp = amp;
+	filter.mGenerator = FractalNoise(freq);
+	filter.mNoise = 0;
+	filter.mNoiseReady = false;
+
+	// Filters affect every texel
+	for (Uint32 i = 0; i < mTiles.Size(); ++i)
+		mTiles[i].mDirty = true;
+}
+
+void BiomeMap::SetColorFilter(Uint32 index, const Vector3f& color, float amp)
+{
+	ColorFilter& filter = mFilters[index];
+	filter.mColor = color;
+	filter.mAmp = amp;
+
+	for (Uint32 i = 0; i < mTiles.Size(); ++i)
+		mTiles[i].mDirty = true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-struct Biome
+void BiomeMap::MarkDirty(const Recti& rect)
+{
+	for (Uint32 i = 0; i < mTiles.Size(); ++i)
+	{
+		if (GetTileRect(i).Contains(rect))
+			mTiles[i].mDirty = true;
+	}
+}
+
+void BiomeMap::MarkDirty(float min, float max)
 {
-	Vector3f mColor;
-	float mHeight;
-};
+	// Heights are rounded to the nearest lookup table entry, so widen the range by half an entry
+	float margin = 0.5f / (BIOME_LUT_SIZE - 1);
+
+	for (Uint32 i = 0; i < mTiles.Size(); ++i)
+	{
+		Tile& tile = mTiles[i];
+		if (tile.mMaxHeight > min - margin && tile.mMinHeight <= max + margin)
+			tile.mDirty = true;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
 
 void BiomeMap::Generate()
 {
-	assert(mHeightMap);
+	assert(mHeightMap || mTiledHeightMap);
+
+	Uint32 w, h;
+	if (mTiledHeightMap)
+	{
+		if (!mRegionHeights)
+			SampleRegion();
 
-	// For quicker access while making map
-	Array<Biome> biomes(mBiomes.size());
-	for (auto it : mBiomes)
-		biomes.Push(Biome{ it.second, it.first });
+		w = mRegionRes;
+		h = mRegionRes;
+		mHeights = mRegionHeights;
+	}
+	else
+	{
+		Image* img = mHeightMap->GetImage();
+		w = img->GetWidth();
+		h = img->GetHeight();
+		mHeights = (const float*)img->GetData();
+	}
 
-	Image* img = mHeightMap->GetImage();
-	Uint32 w = img->GetWidth();
-	Uint32 h = img->GetHeight();
-	Uint32 size = w * h;
+	// Everything is generated on first use and when the height map changes size
+	bool fullUpdate = !mTiles.Size() || mImage->GetWidth() != w || mImage->GetHeight() != h;
+	if (fullUpdate)
+		Reset(w, h);
 
-	// Create noise generators
-	Array<SimplexNoise> generators(mFilters.Size());
+	UpdateLut();
+
+	// Allocate noise of new filters (Every tile is dirty when a filter is added)
 	for (Uint32 i = 0; i < mFilters.Size(); ++i)
-		generators.Push(SimplexNoise(mFilters[i].mFreq));
+	{
+		if (!mFilters[i].mNoise)
+			mFilters[i].mNoise = (float*)malloc(w * h * sizeof(float));
+	}
 
+	Array<Uint32> dirty(mTiles.Size());
+	for (Uint32 i = 0; i < mTiles.Size(); ++i)
+	{
+		if (mTiles[i].mDirty)
+			dirty.Push(i);
+	}
 
-	// Generate data
-	float* src = (float*)img->GetData();
-	Uint8* dst = (Uint8*)malloc(size * 3);
+	if (!dirty.Size()) return;
 
-	for (Uint32 i = 0, r = 0; r < h; ++r)
+	// Tiles write separate texels, so they can be generated in parallel
+	JobSystem::ParallelFor(0, dirty.Size(), GetTileBatchSize(dirty.Size()), [&](Uint32 start, Uint32 end)
 	{
-		for (Uint32 c = 0; c < w; ++c, ++i)
+		for (Uint32 i = start; i < end; ++i)
+			GenerateTile(dirty[i]);
+	});
+
+	for (Uint32 i = 0; i < mFilters.Size(); ++i)
+		mFilters[i].mNoiseReady = true;
+
+	// Set texture
+	Bind();
+	if (fullUpdate)
+		SetImage(mImage);
+	else
+	{
+		for (Uint32 i = 0; i < dirty.Size(); ++i)
 		{
-			float h = src[i];
+			Recti rect = GetTileRect(dirty[i]);
+			UpdateRegion(rect.x, rect.y, rect.w, rect.h);
+		}
+	}
 
-			// Find biome level
-			Uint32 lvl = 0;
-			while (lvl < biomes.Size() && h > biomes[lvl].mHeight) ++lvl;
+	for (Uint32 i = 0; i < dirty.Size(); ++i)
+		mTiles[dirty[i]].mDirty = false;
+}
 
-			// Set color
-			Uint32 idx = 3 * i;
-			lvl -= lvl < biomes.Size() ? 0 : 1;
+///////////////////////////////////////////////////////////////////////////////
 
-			Vector3f color = biomes[lvl].mColor;
+void BiomeMap::UpdateLut()
+{
+	if (!mLut.Size())
+		mLut.Resize(BIOME_LUT_SIZE);
+
+	// Biome of each entry is the first level above its height, or the last level
+	auto it = mBiomes.begin();
+	for (Uint32 i = 0; i < BIOME_LUT_SIZE; ++i)
+	{
+		float h = (float)i / (BIOME_LUT_SIZE - 1);
+		while (it != mBiomes.end() && h > it->first && std::next(it) != mBiomes.end()) ++it;
+
+		mLut[i] = it == mBiomes.end() ? Vector3f(0.0f) : it->second;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BiomeMap::Reset(Uint32 w, Uint32 h)
+{
+	mNumTilesX = (w + BIOME_TILE_SIZE - 1) / BIOME_TILE_SIZE;
+	mNumTilesY = (h + BIOME_TILE_SIZE - 1) / BIOME_TILE_SIZE;
+
+	Tile tile;
+	tile.mMinHeight = 0.0f;
+	tile.mMaxHeight = 0.0f;
+	tile.mDirty = true;
+	mTiles.Resize(mNumTilesX * mNumTilesY, tile);
+
+	// Noise has to be regenerated for the new size
+	for (Uint32 i = 0; i < mFilters.Size(); ++i)
+	{
+		free(mFilters[i].mNoise);
+		mFilters[i].mNoise = 0;
+		mFilters[i].mNoiseReady = false;
+	}
+
+	mImage->FreeData();
+	mImage->SetData(malloc(w * h * 3), w, h, 3);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BiomeMap::SampleRegion()
+{
+	Uint32 res = mRegionRes;
+	mRegionHeights = (float*)malloc(res * res * sizeof(float));
+
+	Array<float> x, z;
+	x.Resize(res);
+	z.Resize(res);
+
+	// Texel centers, mapped the same way the terrain shader maps positions to the color map
+	for (Uint32 c = 0; c < res; ++c)
+		x[c] = ((c + 0.5f) / res * 2.0f - 1.0f) * mRegionSize;
+
+	for (Uint32 r = 0; r < res; ++r)
+	{
+		float pz = ((r + 0.5f) / res * 2.0f - 1.0f) * mRegionSize;
+		for (Uint32 c = 0; c < res; ++c)
+			z[c] = pz;
+
+		mTiledHeightMap->GetHeights(&x[0], &z[0], res, mRegionHeights + r * res, true);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BiomeMap::GenerateTile(Uint32 index)
+{
+	Recti rect = GetTileRect(index);
+	Uint32 w = mImage->GetWidth();
+
+	const float* src = mHeights;
+	Uint8* dst = (Uint8*)mImage->GetData();
+
+	// Evaluate noise of filters that don't have it cached, a row at a time
+	for (Uint32 f = 0; f < mFilters.Size(); ++f)
+	{
+		const ColorFilter& filter = mFilters[f];
+		if (filter.mNoiseReady) continue;
+
+		for (Int32 r = rect.y; r < rect.y + rect.h; ++r)
+		{
+			filter.mGenerator.EvaluateRow(filter.mOctaves,
+				rect.x + filter.mSeed.x, r + filter.mSeed.y, 1.0f, rect.w,
+				filter.mNoise + r * w + rect.x);
+		}
+	}
+
+	float minHeight = 1.0f;
+	float maxHeight = 0.0f;
+
+	for (Int32 r = rect.y; r < rect.y + rect.h; ++r)
+	{
+		for (Int32 c = rect.x; c < rect.x + rect.w; ++c)
+		{
+			Uint32 i = r * w + c;
+			float h = src[i];
+
+			minHeight = std::min(minHeight, h);
+			maxHeight = std::max(maxHeight, h);
+
+			// Look up biome color
+			Int32 entry = (Int32)(h * (BIOME_LUT_SIZE - 1) + 0.5f);
+			Vector3f color = mLut[std::min(std::max(entry, 0), BIOME_LUT_SIZE - 1)];
 
 			// Apply color filters
 			for (Uint32 f = 0; f < mFilters.Size(); ++f)
 			{
 				const ColorFilter& filter = mFilters[f];
-
-				// Calculate color factor
-				float d = 1.0f + generators[f].fractal(filter.mOctaves, c + filter.mSeed.x, r + filter.mSeed.y) * filter.mAmp;
-				// Apply color adjustment
-				color += filter.mColor * d;
+				color += filter.mColor * (1.0f + filter.mNoise[i] * filter.mAmp);
 			}
 
-			dst[idx + 0] = (Uint8)(color.x * 255.0f);
-			dst[idx + 1] = (Uint8)(color.y * 255.0f);
-			dst[idx + 2] = (Uint8)(color.z * 255.0f);
+			Uint8* texel = dst + 3 * i;
+			texel[0] = (Uint8)(std::min(std::max(color.x, 0.0f), 1.0f) * 255.0f);
+			texel[1] = (Uint8)(std::min(std::max(color.y, 0.0f), 1.0f) * 255.0f);
+			texel[2] = (Uint8)(std::min(std::max(color.z, 0.0f), 1.0f) * 255.0f);
 		}
 	}
 
-	// Set image
-	mImage->SetData(dst, w, h, 3);
+	mTiles[index].mMinHeight = minHeight;
+	mTiles[index].mMaxHeight = maxHeight;
+}
 
-	// Set texture
-	Bind();
-	SetImage(mImage);
+///////////////////////////////////////////////////////////////////////////////
+
+Recti BiomeMap::GetTileRect(Uint32 index) const
+{
+	Int32 x = (index % mNumTilesX) * BIOME_TILE_SIZE;
+	Int32 y = (index / mNumTilesX) * BIOME_TILE_SIZE;
+
+	return Recti(x, y,
+		std::min(BIOME_TILE_SIZE, (Int32)mImage->GetWidth() - x),
+		std::min(BIOME_TILE_SIZE, (Int32)mImage->GetHeight() - y));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -6,12 +6,20 @@
 #include <Graphics/Texture.h>
 
 #include <Math/Vector3.h>
+#include <Math/Noise.h>
+#include <Math/Rect.h>
 
 #include <map>
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Number of entries in the height to color lookup table */
+#define BIOME_LUT_SIZE 1024
+/* Number of texels along each side of a generation tile */
+#define BIOME_TILE_SIZE 64
+
 class Image;
+class TiledHeightMap;
 
 class BiomeMap : public Texture
 {
@@ -23,12 +31,18 @@ public:
 
 	/* Set base height map */
 	void SetHeightMap(Texture* map);
-	/* Add biome at height level */
+	/* Set tiled base height map, colors are generated from a res x res sampling of the region [-size, size] (The terrain repeats it outside) */
+	void SetHeightMap(TiledHeightMap* map, float size, Uint32 res);
+	/* Add biome at height level (Replaces the color if the level exists) */
 	void AddColor(const Vector3f& color, float h);
 	/* Add color filter */
 	void AddColorFilter(const Vector3f& color, Uint32 octaves, float freq, float amp = 0.1f);
+	/* Change color and amplitude of a color filter (Filter noise is reused) */
+	void SetColorFilter(Uint32 index, const Vector3f& color, float amp);
+	/* Mark a region of texels for regeneration (i.e. after the height map is edited) */
+	void MarkDirty(const Recti& rect);
 
-	/* Generate biome map (With parameters for discoloration map) */
+	/* Generate biome map (Only dirty tiles are regenerated after the first call) */
 	void Generate();
 
 private:
@@ -46,18 +60,67 @@ private:
 
 		/* Random seed */
 		Vector2f mSeed;
+		/* Noise generator */
+		FractalNoise mGenerator;
+		/* Cached noise value of every texel */
+		float* mNoise;
+		/* True if cached noise has been generated */
+		bool mNoiseReady;
+	};
+
+	/* Square block of texels that is generated by one job */
+	struct Tile
+	{
+		/* Minimum height in tile */
+		float mMinHeight;
+		/* Maximum height in tile */
+		float mMaxHeight;
+		/* True if tile needs to be regenerated */
+		bool mDirty;
 	};
 
+	/* Rebuild height to color lookup table */
+	void UpdateLut();
+	/* Set up tiles and filter noise for the current height map size */
+	void Reset(Uint32 w, Uint32 h);
+	/* Sample heights of the tiled height map region (Waits for tiles to generate) */
+	void SampleRegion();
+	/* Generate colors of a tile */
+	void GenerateTile(Uint32 index);
+	/* Mark tiles that have heights in range (min, max] */
+	void MarkDirty(float min, float max);
+	/* Get texel area of a tile */
+	Recti GetTileRect(Uint32 index) const;
+
 private:
 	/* List of color filters to apply */
 	Array<ColorFilter> mFilters;
 	/* Sorted map of biomes */
 	std::map<float, Vector3f> mBiomes;
+	/* Biome color for evenly spaced heights in range [0, 1] */
+	Array<Vector3f> mLut;
+
+	/* Generation tiles */
+	Array<Tile> mTiles;
+	/* Number of tiles along x */
+	Uint32 mNumTilesX;
+	/* Number of tiles along y */
+	Uint32 mNumTilesY;
 
 	/* Source image */
 	Image* mImage;
 	/* Height map */
 	Texture* mHeightMap;
+	/* Tiled height map */
+	TiledHeightMap* mTiledHeightMap;
+	/* Size of the sampled tiled height map region */
+	float mRegionSize;
+	/* Number of samples along each side of the tiled height map region */
+	Uint32 mRegionRes;
+	/* Sampled heights of the tiled height map region */
+	float* mRegionHeights;
+	/* Heights colors are generated from (Height map image data or the sampled region) */
+	const float* mHeights;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,86 @@
+#include <Game/Terrain/MapGenerator.h>
+
+#include <Core/JobSystem.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 MapGenerator::GetRowBatchSize(Uint32 h)
+{
+	// A few batches per thread so uneven rows balance out
+	Uint32 batchSize = h / (JobSystem::GetNumThreads() * 4);
+	return batchSize ? batchSize : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MapGenerator::Noise(const FractalNoise& noise, Uint32 octaves, const Vector2f& seed, Uint32 w, Uint32 h, float* out)
+{
+	JobSystem::ParallelFor(0, h, GetRowBatchSize(h), [&](Uint32 start, Uint32 end)
+	{
+		for (Uint32 r = start; r < end; ++r)
+		{
+			float* row = out + r * w;
+			noise.EvaluateRow(octaves, seed.x, r + seed.y, 1.0f, w, row);
+
+			for (Uint32 c = 0; c < w; ++c)
+				row[c] = row[c] * 0.5f + 0.5f;
+		}
+	});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MapGenerator::Normals(const float* heights, Uint32 w, Uint32 h, float amp, Vector3f* out)
+{
+	JobSystem::ParallelFor(0, h, GetRowBatchSize(h), [&](Uint32 start, Uint32 end)
+	{
+		for (Uint32 r = start; r < end; ++r)
+		{
+			for (Uint32 c = 0; c < w; ++c)
+			{
+				Uint32 _t = (r == 0 ? r : r - 1) * w + c;
+				Uint32 _b = (r == h - 1 ? r : r + 1) * w + c;
+				Uint32 _l = r * w + (c == 0 ? c : c - 1);
+				Uint32 _r = r * w + (c == w - 1 ? c : c + 1);
+
+				float h_t = heights[_t] * amp;
+				float h_b = heights[_b] * amp;
+				float h_l = heights[_l] * amp;
+				float h_r = heights[_r] * amp;
+
+				Vector3f va = Normalize(Vector3f(1.0f, h_t - h_b, 0.0f));
+				Vector3f vb = Normalize(Vector3f(0.0f, h_l - h_r, 1.0f));
+				Vector3f n = Cross(vb, va);
+
+				out[r * w + c] = n;
+			}
+		}
+	});
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MapGenerator::DuDv(const Vector3f* normals, Uint32 w, Uint32 h, float scale, Vector3f* out)
+{
+	JobSystem::ParallelFor(0, h, GetRowBatchSize(h), [&](Uint32 start, Uint32 end)
+	{
+		for (Uint32 r = start; r < end; ++r)
+		{
+			for (Uint32 c = 0; c < w; ++c)
+			{
+				Uint32 _t = (r == 0 ? r : r - 1) * w + c;
+				Uint32 _b = (r == h - 1 ? r : r + 1) * w + c;
+				Uint32 _l = r * w + (c == 0 ? c : c - 1);
+				Uint32 _r = r * w + (c == w - 1 ? c : c + 1);
+
+				Vector3f du = normals[_r] * scale - normals[_l] * scale;
+				Vector3f dv = normals[_t] * scale - normals[_b] * scale;
+
+				out[r * w + c] = (du + dv) * 0.5f;
+			}
+		}
+	});
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef MAP_GENERATOR_H
+#define MAP_GENERATOR_H
+
+#include <Math/Vector2.h>
+#include <Math/Vector3.h>
+#include <Math/Noise.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* CPU side generation of terrain and water maps (Rows are generated in parallel on the job system).
+   Kept apart from the textures that upload the results so it can run without a GL context */
+class MapGenerator
+{
+public:
+	/* Get number of rows each job should generate */
+	static Uint32 GetRowBatchSize(Uint32 h);
+
+	/* Generate w * h noise heights in range [0, 1], sampled one noise unit apart starting at seed */
+	static void Noise(const FractalNoise& noise, Uint32 octaves, const Vector2f& seed, Uint32 w, Uint32 h, float* out);
+	/* Generate normals of a height map with heights scaled by amp */
+	static void Normals(const float* heights, Uint32 w, Uint32 h, float amp, Vector3f* out);
+	/* Generate du/dv offsets from the slopes of a normal map */
+	static void DuDv(const Vector3f* normals, Uint32 w, Uint32 h, float scale, Vector3f* out);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <Game/Terrain/NoiseMap.h>
 
+#include <Game/Terrain/MapGenerator.h>
+
 #include <Resource/Resource.h>
 
 #include <Graphics/Image.h>
@@ -7,6 +9,7 @@
 #include <cstdlib>
 
 ///////////////////////////////////////////////////////////////////////////////
+
 ///////////////////////////////////////////////////////////////////////////////
 
 NoiseMap::NoiseMap(float f, float a, float l, float p) :
@@ -33,14 +36,7 @@ void NoiseMap::Generate(Uint32 octaves, Uint32 w, Uint32 h)
 	float* data = (float*)malloc(w * h * sizeof(float));
 
 	// Generate image
-	for (int r = 0; r < h; ++r)
-	{
-		for (int c = 0; c < w; ++c)
-		{
-			float h = mGenerator.fractal(octaves, c + mSeed.x, r + mSeed.y) * 0.5f + 0.5f;
-			data[r * w + c] = h;
-		}
-	}
+	MapGenerator::Noise(mGenerator, octaves, mSeed, w, h, data);
 
 	mImage->SetData(data, w, h, 1, Image::Float);
 
@@ -76,27 +72,7 @@ void NormalMap::Generate(const NoiseMap& img, float amp)
 	// Allocate data
 	Vector3f* data = (Vector3f*)malloc(3 * w * h * sizeof(float));
 
-	for (Uint32 r = 0; r < h; ++r)
-	{
-		for (Uint32 c = 0; c < w; ++c)
-		{
-			Uint32 _t = (r == 0 ? r : r - 1) * w + c;
-			Uint32 _b = (r == h - 1 ? r : r + 1) * w + c;
-			Uint32 _l = r * w + (c == 0 ? c : c - 1);
-			Uint32 _r = r * w + (c == w - 1 ? c : c + 1);
-
-			float h_t = heights[_t] * amp;
-			float h_b = heights[_b] * amp;
-			float h_l = heights[_l] * amp;
-			float h_r = heights[_r] * amp;
-
-			Vector3f va = Normalize(Vector3f(1.0f, h_t - h_b, 0.0f));
-			Vector3f vb = Normalize(Vector3f(0.0f, h_l - h_r, 1.0f));
-			Vector3f n = Cross(vb, va);
-
-			data[r * w + c] = n;
-		}
-	}
+	MapGenerator::Normals(heights, w, h, amp, data);
 
 	mImage->SetData(data, w, h, 3, Image::Float);
 
@@ -132,21 +108,7 @@ void DuDvMap::Generate(const NormalMap& img, float scale)
 	// Allocate data
 	Vector3f* data = (Vector3f*)malloc(3 * w * h * sizeof(float));
 
-	for (Uint32 r = 0; r < h; ++r)
-	{
-		for (Uint32 c = 0; c < w; ++c)
-		{
-			Uint32 _t = (r == 0 ? r : r - 1) * w + c;
-			Uint32 _b = (r == h - 1 ? r : r + 1) * w + c;
-			Uint32 _l = r * w + (c == 0 ? c : c - 1);
-			Uint32 _r = r * w + (c == w - 1 ? c : c + 1);
-
-			Vector3f du = normals[_r] * scale - normals[_l] * scale;
-			Vector3f dv = normals[_t] * scale - normals[_b] * scale;
-
-			data[r * w + c] = (du + dv) * 0.5f;
-		}
-	}
+	MapGenerator::DuDv(normals, w, h, scale, data);
 
 	mImage->SetData(data, w, h, 3, Image::Float);
 
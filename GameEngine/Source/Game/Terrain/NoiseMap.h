@@ -4,9 +4,9 @@
 #include <Math/Vector2.h>
 #include <Math/Vector3.h>
 
-#include <Graphics/Texture.h>
+#include <Math/Noise.h>
 
-#include <SimplexNoise.h>
+#include <Graphics/Texture.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -22,12 +22,12 @@ public:
 		float persistence = 0.5f);
 	~NoiseMap();
 
-	/* Generate noise map and upload */
+	/* Generate noise map and upload (Rows are generated in parallel) */
 	void Generate(Uint32 octaves, Uint32 w, Uint32 h);
 
 private:
 	/* Noise generator */
-	SimplexNoise mGenerator;
+	FractalNoise mGenerator;
 
 	/* Float seed */
 	Vector2f mSeed;
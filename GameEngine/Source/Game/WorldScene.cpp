@@ -18,7 +18,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 WorldScene::WorldScene() :
-	mHeightMap		(0.01f)
+	mHeightMap		(0.01f),
+	mTiledHeightMap	(0.01f)
 {
 
 }
@@ -98,11 +99,22 @@ void WorldScene::CreateMainPlayer()
 
 void WorldScene::CreateTerrain()
 {
+#if WORLD_TILED_TERRAIN
+	// Create tiled height map (Same texel spacing as the single map, tiles around the camera are streamed in by the system)
+	mTiledHeightMap.SetOctaves(5);
+	mTiledHeightMap.SetTileSize(129, 500.0f);
+	mTiledHeightMap.Create();
+	RegisterSystem<TiledHeightMapSystem>()->SetHeightMap(&mTiledHeightMap);
+
+	// Create biome map from the region the single map would cover
+	mBiomeMap.SetHeightMap(&mTiledHeightMap, 1000.0f, 513);
+#else
 	// Create height map
 	mHeightMap.Generate(5, 513, 513);
 
 	// Create biome map
 	mBiomeMap.SetHeightMap(&mHeightMap);
+#endif
 	mBiomeMap.AddColor(Vector3f(0.651f, 0.616f, 0.325f), 0.2f);
 	mBiomeMap.AddColor(Vector3f(0.169f, 0.431f, 0.188f), 1.0f);
 	mBiomeMap.AddColorFilter(Vector3f(1.0f, 0.0f, 0.0f), 1, 0.05f, 0.015f);
@@ -120,7 +132,11 @@ void WorldScene::CreateTerrain()
 	mTerrain.SetSquareSize(3.0f);
 	mTerrain.Create(this);
 
+#if WORLD_TILED_TERRAIN
+	mTerrain.SetHeightMap(&mTiledHeightMap);
+#else
 	mTerrain.SetHeightMap(&mHeightMap);
+#endif
 	mTerrain.SetColorMap(&mBiomeMap);
 
 
@@ -5,11 +5,17 @@
 
 #include <Graphics/Terrain.h>
 #include <Graphics/Water.h>
+#include <Graphics/TiledHeightMap.h>
 #include <Game/Terrain/NoiseMap.h>
 #include <Game/Terrain/BiomeMap.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Set to 0 to use a single fixed size height map instead of streaming height tiles */
+#define WORLD_TILED_TERRAIN 1
+
+///////////////////////////////////////////////////////////////////////////////
+
 class WorldScene : public Scene
 {
 public:
@@ -30,6 +36,7 @@ private:
 private:
 	Terrain mTerrain;
 	NoiseMap mHeightMap;
+	TiledHeightMap mTiledHeightMap;
 	BiomeMap mBiomeMap;
 
 	Water mWater;
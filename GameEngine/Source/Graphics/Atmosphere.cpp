@@ -7,15 +7,19 @@
 #include <Graphics/VertexBuffer.h>
 #include <Graphics/Shader.h>
 #include <Graphics/FrameBuffer.h>
+#include <Graphics/UniformBlock.h>
 
 #include <Scene/Scene.h>
 
+#include <assert.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
 Atmosphere::Atmosphere(Scene* scene) :
 	LightingPass				(scene),
 
+	mUniformBuffer				(0),
 	mInitialized				(false),
 
 	mSolarIntensity				(10.0f),
@@ -54,10 +58,13 @@ Atmosphere::~Atmosphere()
 		Resource<FrameBuffer>::Free(mScatteringBuffer);
 	if (mIrradianceBuffer)
 		Resource<FrameBuffer>::Free(mIrradianceBuffer);
+	if (mUniformBuffer)
+		Resource<VertexBuffer>::Free(mUniformBuffer);
 
 	mTransmittanceBuffer = 0;
 	mScatteringBuffer = 0;
 	mIrradianceBuffer = 0;
+	mUniformBuffer = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -91,6 +98,15 @@ void Atmosphere::Init()
 	Shader* irradianceShader = Resource<Shader>::Load("Shaders/Atmosphere/Irradiance.xml");
 	mShader = Resource<Shader>::Load("Shaders/Atmosphere/Render.xml");
 
+	// Constants are uploaded once and shared by all atmosphere shaders (Layout is checked in every build, mismatches are logged as errors and stop debug builds)
+	if (!AtmosphereUniforms::ValidateLayout())
+		assert(!"AtmosphereUniforms doesn't match the std140 block layout");
+
+	mUniformBuffer = Resource<VertexBuffer>::Create();
+	mUniformBuffer->Bind(VertexBuffer::Uniform);
+	mUniformBuffer->BufferData(NULL, sizeof(AtmosphereUniforms), VertexBuffer::Static);
+	UpdateUniforms();
+
 
 	// Create framebuffers
 	FrameBuffer::TextureOptions options;
@@ -219,6 +235,8 @@ void Atmosphere::RenderSetup(FrameBuffer* gbuffer)
 	mScatteringBuffer->GetColorTexture()->Bind(6);
 	mIrradianceBuffer->GetColorTexture()->Bind(7);
 
+	mUniformBuffer->Bind(VertexBuffer::Uniform, ATMOSPHERE_UNIFORMS_BINDING);
+
 	mShader->SetUniform("mInvProjView", invProjView);
 	mShader->SetUniform("mCamPos", cam.GetPosition());
 	mShader->SetUniform("mSunDir", -mScene->GetDirLight().GetDirection());
@@ -230,28 +248,43 @@ void Atmosphere::RenderSetup(FrameBuffer* gbuffer)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Atmosphere::SetUniforms(Shader* shader)
+void Atmosphere::UpdateUniforms()
 {
-	shader->SetUniform("TRANSMITTANCE_TEXTURE_WIDTH", mTransmittanceTexture_W);
-	shader->SetUniform("TRANSMITTANCE_TEXTURE_HEIGHT", mTransmittanceTexture_H);
-	shader->SetUniform("SCATTERING_TEXTURE_R_SIZE", mScatteringTexture_R);
-	shader->SetUniform("SCATTERING_TEXTURE_MU_SIZE", mScatteringTexture_Mu);
-	shader->SetUniform("SCATTERING_TEXTURE_MU_S_SIZE", mScatteringTexture_MuS);
-	shader->SetUniform("SCATTERING_TEXTURE_NU_SIZE", mScatteringTexture_Nu);
-	shader->SetUniform("IRRADIANCE_TEXTURE_WIDTH", mIrradianceTexture_W);
-	shader->SetUniform("IRRADIANCE_TEXTURE_HEIGHT", mIrradianceTexture_H);
-
-	shader->SetUniform("mSolarIntensity", mSolarIntensity);
-	shader->SetUniform("mSolarIrradiance", mSolarIrradiance);
-	shader->SetUniform("mSunAngularRadius", mSunAngularRadius);
-	shader->SetUniform("mTopRadius", mTopRadius);
-	shader->SetUniform("mBotRadius", mBotRadius);
-	shader->SetUniform("mHr", mScaleHeight_R);
-	shader->SetUniform("mHm", mScaleHeight_M);
-	shader->SetUniform("mBr", mScattering_R);
-	shader->SetUniform("mBm", mScattering_M);
-	shader->SetUniform("mMiePhaseG", mMiePhase_G);
+	mSunSize.x = tan(mSunAngularRadius);
+	mSunSize.y = cos(mSunAngularRadius);
 
+	AtmosphereUniforms uniforms;
+	uniforms.mSolarIrradiance = mSolarIrradiance;
+	uniforms.mSolarIntensity = mSolarIntensity;
+	uniforms.mScattering_R = mScattering_R;
+	uniforms.mTopRadius = mTopRadius;
+	uniforms.mScattering_M = mScattering_M;
+	uniforms.mBotRadius = mBotRadius;
+	uniforms.mSunSize = mSunSize;
+	uniforms.mSunAngularRadius = mSunAngularRadius;
+	uniforms.mScaleHeight_R = mScaleHeight_R;
+	uniforms.mScaleHeight_M = mScaleHeight_M;
+	uniforms.mMiePhase_G = mMiePhase_G;
+	uniforms.mBaseHeight = mBaseHeight;
+	uniforms.mDistScale = mDistScale;
+
+	uniforms.mTransmittanceTexture_W = mTransmittanceTexture_W;
+	uniforms.mTransmittanceTexture_H = mTransmittanceTexture_H;
+	uniforms.mScatteringTexture_R = mScatteringTexture_R;
+	uniforms.mScatteringTexture_Mu = mScatteringTexture_Mu;
+	uniforms.mScatteringTexture_MuS = mScatteringTexture_MuS;
+	uniforms.mScatteringTexture_Nu = mScatteringTexture_Nu;
+	uniforms.mIrradianceTexture_W = mIrradianceTexture_W;
+	uniforms.mIrradianceTexture_H = mIrradianceTexture_H;
+
+	mUniformBuffer->Bind(VertexBuffer::Uniform, ATMOSPHERE_UNIFORMS_BINDING);
+	mUniformBuffer->UpdateData(&uniforms, sizeof(AtmosphereUniforms));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Atmosphere::SetUniforms(Shader* shader)
+{
 	// Bind textures
 	shader->SetUniform("mNormalSpec", 1);
 	shader->SetUniform("mAlbedo", 2);
@@ -261,11 +294,6 @@ void Atmosphere::SetUniforms(Shader* shader)
 	shader->SetUniform("mTransmittanceTexture", 5);
 	shader->SetUniform("mScatteringTexture", 6);
 	shader->SetUniform("mIrradianceTexture", 7);
-
-	// Other unchanging uniforms
-	shader->SetUniform("mSunSize", mSunSize);
-	shader->SetUniform("mBaseHeight", mBaseHeight);
-	shader->SetUniform("mDistScale", mDistScale);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
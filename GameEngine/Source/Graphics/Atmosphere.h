@@ -1,6 +1,7 @@
 #ifndef ATMOSPHERE_H
 #define ATMOSPHERE_H
 
+#include <Math/Vector2.h>
 #include <Math/Vector3.h>
 
 #include <Graphics/RenderPass.h>
@@ -8,6 +9,59 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 class Scene;
+class VertexBuffer;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Constants shared by all atmosphere shaders (Matches the std140 AtmosphereUniforms block) */
+struct AtmosphereUniforms
+{
+	/* Color of sunlight */
+	Vector3f mSolarIrradiance;
+	/* Intensity of sunlight */
+	float mSolarIntensity;
+	/* Rayleigh scattering factor */
+	Vector3f mScattering_R;
+	/* Altitude of top of atmosphere */
+	float mTopRadius;
+	/* Mie scattering factor */
+	Vector3f mScattering_M;
+	/* Altitude of bottom of atmosphere */
+	float mBotRadius;
+	/* Tangent and cosine of sun angular radius */
+	Vector2f mSunSize;
+	/* Radius of sun in radians */
+	float mSunAngularRadius;
+	/* Scale height for rayleigh scattering */
+	float mScaleHeight_R;
+	/* Scale height for mie scattering */
+	float mScaleHeight_M;
+	/* G-constant for Mie phase function */
+	float mMiePhase_G;
+	/* Base altitude (km) */
+	float mBaseHeight;
+	/* Distance multiplier */
+	float mDistScale;
+
+	/* Transmittance texture sizes */
+	int mTransmittanceTexture_W;
+	int mTransmittanceTexture_H;
+
+	/* Scattering texture sizes */
+	int mScatteringTexture_R;
+	int mScatteringTexture_Mu;
+	int mScatteringTexture_MuS;
+	int mScatteringTexture_Nu;
+
+	/* Irradiance texture sizes */
+	int mIrradianceTexture_W;
+	int mIrradianceTexture_H;
+
+	/* Returns true if struct packing matches the std140 block layout */
+	static bool ValidateLayout();
+};
+
+///////////////////////////////////////////////////////////////////////////////
 
 class Atmosphere : public LightingPass
 {
@@ -21,7 +75,9 @@ public:
 	/* Render as lighting effect */
 	void RenderSetup(FrameBuffer* gbuffer) override;
 
-	/* Set uniforms needed for atmosphere shaders */
+	/* Upload atmosphere constants to the uniform buffer (Call after changing parameters) */
+	void UpdateUniforms();
+	/* Set texture uniforms needed for atmosphere shaders */
 	void SetUniforms(Shader* shader);
 
 	/* Get transmittance buffer */
@@ -89,6 +145,8 @@ private:
 	FrameBuffer* mScatteringBuffer;
 	/* Precomputed irradiance table */
 	FrameBuffer* mIrradianceBuffer;
+	/* Atmosphere constants uniform buffer */
+	VertexBuffer* mUniformBuffer;
 	/* Flag so only initialized once */
 	bool mInitialized;
 
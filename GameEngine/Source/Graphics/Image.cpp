@@ -25,6 +25,13 @@ Image::~Image()
 ///////////////////////////////////////////////////////////////////////////////
 
 bool Image::Load(const char* fname, DataType type)
+{
+	return LoadData(fname, type) && Upload();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Image::LoadData(const char* fname, DataType type)
 {
 	mFileHash = fname;
 
@@ -56,6 +63,11 @@ bool Image::Load(const char* fname, DataType type)
 	return true;
 }
 
+bool Image::Upload()
+{
+	return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void Image::SetData(void* data, Uint32 w, Uint32 h, Uint32 c, DataType type)
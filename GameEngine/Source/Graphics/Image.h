@@ -25,6 +25,10 @@ public:
 
 	/* Load image from file */
 	bool Load(const char* fname, DataType type = Ubyte);
+	/* Read and decode image file (Thread safe) */
+	bool LoadData(const char* fname, DataType type = Ubyte);
+	/* Images have no GPU data, so there is nothing to upload */
+	bool Upload();
 
 	/* Set image data (Data should be allocated with malloc) */
 	void SetData(void* data, Uint32 w, Uint32 h, Uint32 c, DataType type = Ubyte);
@@ -0,0 +1,260 @@
+#include <Graphics/InstanceFormat.h>
+#include <Graphics/VertexArray.h>
+#include <Graphics/OpenGL.h>
+
+#include <Math/Vector4.h>
+
+#include <math.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Position and uniform scale followed by a rotation quaternion */
+	struct QuatScaleInstance
+	{
+		float mPosScale[4];
+		float mRotation[4];
+	};
+
+	/* Position and uniform scale followed by a half float rotation quaternion */
+	struct QuatScaleHalfInstance
+	{
+		float mPosScale[4];
+		Uint16 mRotation[4];
+	};
+
+	/* Convert float to half float (Round to nearest even) */
+	Uint16 ToHalf(float f)
+	{
+		Uint32 bits;
+		memcpy(&bits, &f, sizeof(bits));
+
+		Uint32 sign = (bits >> 16) & 0x8000;
+		int exp = (int)((bits >> 23) & 0xFF) - 127 + 15;
+		Uint32 mantissa = bits & 0x7FFFFF;
+
+		// Too small for a normal half, flush to zero (Quaternion components never need denormals)
+		if (exp <= 0)
+			return (Uint16)sign;
+
+		// Overflow (and infinity, NaN isn't expected)
+		if (exp >= 31)
+			return (Uint16)(sign | 0x7C00);
+
+		Uint32 half = sign | (exp << 10) | (mantissa >> 13);
+		Uint32 rest = mantissa & 0x1FFF;
+
+		// Rounding can carry into the exponent, which is still correct
+		if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+			++half;
+
+		return (Uint16)half;
+	}
+
+	/* Get rotation quaternion and uniform scale of an affine transform */
+	void ToQuatScale(const Matrix4f& m, float* q, float& scale)
+	{
+		scale = sqrt(m.x.x * m.x.x + m.x.y * m.x.y + m.x.z * m.x.z);
+		float inv = scale > 0.0f ? 1.0f / scale : 0.0f;
+
+		// Rotation matrix elements (Row, column)
+		float r00 = m.x.x * inv, r01 = m.y.x * inv, r02 = m.z.x * inv;
+		float r10 = m.x.y * inv, r11 = m.y.y * inv, r12 = m.z.y * inv;
+		float r20 = m.x.z * inv, r21 = m.y.z * inv, r22 = m.z.z * inv;
+
+		// Use the largest diagonal term to keep precision
+		float trace = r00 + r11 + r22;
+		if (trace > 0.0f)
+		{
+			float s = 0.5f / sqrt(trace + 1.0f);
+			q[3] = 0.25f / s;
+			q[0] = (r21 - r12) * s;
+			q[1] = (r02 - r20) * s;
+			q[2] = (r10 - r01) * s;
+		}
+		else if (r00 > r11 && r00 > r22)
+		{
+			float s = 2.0f * sqrt(1.0f + r00 - r11 - r22);
+			q[3] = (r21 - r12) / s;
+			q[0] = 0.25f * s;
+			q[1] = (r01 + r10) / s;
+			q[2] = (r02 + r20) / s;
+		}
+		else if (r11 > r22)
+		{
+			float s = 2.0f * sqrt(1.0f + r11 - r00 - r22);
+			q[3] = (r02 - r20) / s;
+			q[0] = (r01 + r10) / s;
+			q[1] = 0.25f * s;
+			q[2] = (r12 + r21) / s;
+		}
+		else
+		{
+			float s = 2.0f * sqrt(1.0f + r22 - r00 - r11);
+			q[3] = (r10 - r01) / s;
+			q[0] = (r02 + r20) / s;
+			q[1] = (r12 + r21) / s;
+			q[2] = 0.25f * s;
+		}
+	}
+
+	/* Get source matrix i */
+	inline const Matrix4f& GetMatrix(const Matrix4f* src, Uint32 stride, const Uint32* indices, Uint32 i)
+	{
+		return *(const Matrix4f*)((const Uint8*)src + (indices ? indices[i] : i) * stride);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 InstanceFormat::GetSize(Type type)
+{
+	switch (type)
+	{
+	case Affine:
+		return 3 * sizeof(Vector4f);
+	case QuatScale:
+		return sizeof(QuatScaleInstance);
+	case QuatScaleHalf:
+		return sizeof(QuatScaleHalfInstance);
+	default:
+		return sizeof(Matrix4f);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void InstanceFormat::Pack(Type type, const Matrix4f* src, Uint32 stride, const Uint32* indices, Uint32 num, void* dst)
+{
+	switch (type)
+	{
+	case Matrix:
+	{
+		Matrix4f* out = (Matrix4f*)dst;
+		for (Uint32 i = 0; i < num; ++i)
+			out[i] = GetMatrix(src, stride, indices, i);
+		break;
+	}
+
+	case Affine:
+	{
+		// Store rows, the last row is always (0, 0, 0, 1)
+		Vector4f* out = (Vector4f*)dst;
+		for (Uint32 i = 0; i < num; ++i, out += 3)
+		{
+			const Matrix4f& m = GetMatrix(src, stride, indices, i);
+			out[0] = Vector4f(m.x.x, m.y.x, m.z.x, m.w.x);
+			out[1] = Vector4f(m.x.y, m.y.y, m.z.y, m.w.y);
+			out[2] = Vector4f(m.x.z, m.y.z, m.z.z, m.w.z);
+		}
+		break;
+	}
+
+	case QuatScale:
+	{
+		QuatScaleInstance* out = (QuatScaleInstance*)dst;
+		for (Uint32 i = 0; i < num; ++i)
+		{
+			const Matrix4f& m = GetMatrix(src, stride, indices, i);
+			out[i].mPosScale[0] = m.w.x;
+			out[i].mPosScale[1] = m.w.y;
+			out[i].mPosScale[2] = m.w.z;
+			ToQuatScale(m, out[i].mRotation, out[i].mPosScale[3]);
+		}
+		break;
+	}
+
+	case QuatScaleHalf:
+	{
+		// Position stays full precision, half floats are only accurate enough for unit values
+		QuatScaleHalfInstance* out = (QuatScaleHalfInstance*)dst;
+		for (Uint32 i = 0; i < num; ++i)
+		{
+			const Matrix4f& m = GetMatrix(src, stride, indices, i);
+			float q[4];
+
+			out[i].mPosScale[0] = m.w.x;
+			out[i].mPosScale[1] = m.w.y;
+			out[i].mPosScale[2] = m.w.z;
+			ToQuatScale(m, q, out[i].mPosScale[3]);
+
+			out[i].mRotation[0] = ToHalf(q[0]);
+			out[i].mRotation[1] = ToHalf(q[1]);
+			out[i].mRotation[2] = ToHalf(q[2]);
+			out[i].mRotation[3] = ToHalf(q[3]);
+		}
+		break;
+	}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void InstanceFormat::SetAttribs(Type type, VertexArray* vao, Uint32 offset)
+{
+	Uint32 size = GetSize(type);
+	Uint32 numAttribs = 4;
+
+	switch (type)
+	{
+	case Matrix:
+		vao->VertexAttrib(4, 4, size, offset + 0 * sizeof(Vector4f), 1);
+		vao->VertexAttrib(5, 4, size, offset + 1 * sizeof(Vector4f), 1);
+		vao->VertexAttrib(6, 4, size, offset + 2 * sizeof(Vector4f), 1);
+		vao->VertexAttrib(7, 4, size, offset + 3 * sizeof(Vector4f), 1);
+		break;
+
+	case Affine:
+		vao->VertexAttrib(4, 4, size, offset + 0 * sizeof(Vector4f), 1);
+		vao->VertexAttrib(5, 4, size, offset + 1 * sizeof(Vector4f), 1);
+		vao->VertexAttrib(6, 4, size, offset + 2 * sizeof(Vector4f), 1);
+		numAttribs = 3;
+		break;
+
+	case QuatScale:
+		vao->VertexAttrib(4, 4, size, offset, 1);
+		vao->VertexAttrib(5, 4, size, offset + sizeof(Vector4f), 1);
+		numAttribs = 2;
+		break;
+
+	case QuatScaleHalf:
+		vao->VertexAttrib(4, 4, size, offset, 1);
+		vao->VertexAttrib(5, 4, VertexArray::HalfFloat, size, offset + sizeof(Vector4f), 1);
+		numAttribs = 2;
+		break;
+	}
+
+	// Attributes left enabled by a larger format would read past the end of the instance buffer
+	for (Uint32 i = 4 + numAttribs; i < 8; ++i)
+		vao->DisableAttrib(i);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Int32 InstanceFormat::FromProgram(Uint32 program)
+{
+	// Each Shaders/Instance file declares a differently named first attribute
+	if (glGetAttribLocation(program, "aTransform") >= 0)
+		return Matrix;
+	if (glGetAttribLocation(program, "aRow0") >= 0)
+		return Affine;
+	if (glGetAttribLocation(program, "aPosScale") >= 0)
+		return QuatScale;
+
+	return -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool InstanceFormat::IsCompatible(Type type, Int32 programFormat)
+{
+	if (type == QuatScaleHalf)
+		return programFormat == QuatScale;
+
+	return programFormat == (Int32)type;
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
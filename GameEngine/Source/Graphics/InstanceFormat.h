@@ -0,0 +1,49 @@
+#ifndef INSTANCE_FORMAT_H
+#define INSTANCE_FORMAT_H
+
+#include <Math/Matrix4.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+class VertexArray;
+
+/* Encoding of per instance transforms in instance buffers (Attribute locations 4 to 7).
+   Shaders decode with GetInstanceTransform(), linked from the matching Shaders/Instance file
+   (Default.xml, DefaultAffine.xml and DefaultQuatScale.xml, likewise for Water) */
+class InstanceFormat
+{
+public:
+	enum Type
+	{
+		/* Full 4x4 matrix (64 bytes, Instance/Matrix.vert) */
+		Matrix,
+		/* Top three rows of an affine matrix (48 bytes, Instance/Affine.vert) */
+		Affine,
+		/* Position, uniform scale and rotation quaternion (32 bytes, Instance/QuatScale.vert) */
+		QuatScale,
+		/* Same as QuatScale with a half float quaternion (24 bytes, Instance/QuatScale.vert) */
+		QuatScaleHalf
+	};
+
+public:
+	/* Get size of an encoded instance in bytes */
+	static Uint32 GetSize(Type type);
+
+	/* Encode transforms into dst (Stride is the distance between source matrices in bytes,
+	   indices select which matrices are encoded, or all of them in order if null).
+	   Quaternion formats assume transforms have uniform scale and no shear */
+	static void Pack(Type type, const Matrix4f* src, Uint32 stride, const Uint32* indices, Uint32 num, void* dst);
+
+	/* Set instance attributes of the bound vertex array (Offset in bytes into the bound array buffer).
+	   Instance attributes the format doesn't use are disabled */
+	static void SetAttribs(Type type, VertexArray* vao, Uint32 offset);
+
+	/* Get format a linked program decodes, from the instance attributes it declares (-1 if it has none) */
+	static Int32 FromProgram(Uint32 program);
+	/* Check if instances of a format can be drawn by a program that decodes another (Half floats are converted) */
+	static bool IsCompatible(Type type, Int32 programFormat);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
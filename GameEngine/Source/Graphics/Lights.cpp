@@ -24,9 +24,13 @@ DirLight::DirLight() :
 
 void DirLight::Use(Shader* shader)
 {
-	shader->SetUniform("mDirLight.mDiffuse", mDiffuse);
-	shader->SetUniform("mDirLight.mSpecular", mSpecular);
-	shader->SetUniform("mDirLight.mDirection", mDirection);
+	static const UniformHandle diffuse = Shader::GetUniformHandle("mDirLight.mDiffuse");
+	static const UniformHandle specular = Shader::GetUniformHandle("mDirLight.mSpecular");
+	static const UniformHandle direction = Shader::GetUniformHandle("mDirLight.mDirection");
+
+	shader->SetUniform(diffuse, mDiffuse);
+	shader->SetUniform(specular, mSpecular);
+	shader->SetUniform(direction, mDirection);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
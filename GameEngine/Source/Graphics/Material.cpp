@@ -19,9 +19,14 @@ Material::Material() :
 
 void Material::Use()
 {
-	mShader->SetUniform("mMaterial.mDiffuse", mDiffuse);
-	mShader->SetUniform("mMaterial.mSpecular", mSpecular);
-	mShader->SetUniform("mMaterial.mSpecFactor", mSpecFactor);
+	// Handles are shared by all shaders, so they only need to be resolved once
+	static const UniformHandle diffuse = Shader::GetUniformHandle("mMaterial.mDiffuse");
+	static const UniformHandle specular = Shader::GetUniformHandle("mMaterial.mSpecular");
+	static const UniformHandle specFactor = Shader::GetUniformHandle("mMaterial.mSpecFactor");
+
+	mShader->SetUniform(diffuse, mDiffuse);
+	mShader->SetUniform(specular, mSpecular);
+	mShader->SetUniform(specFactor, mSpecFactor);
 
 	// Apply all textures
 	for (Uint32 i = 0; i < mTextures.Size(); ++i)
@@ -38,7 +43,7 @@ void Material::AddTexture(Texture* texture, const char* uniform)
 	if (!mTextures.Capacity())
 		mTextures.Reserve(4);
 
-	mTextures.Push(MaterialTexture{ texture, uniform });
+	mTextures.Push(MaterialTexture{ texture, Shader::GetUniformHandle(uniform) });
 }
 
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -6,10 +6,10 @@
 #include <Math/Vector3.h>
 
 #include <Graphics/RenderPass.h>
+#include <Graphics/Shader.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 
-class Shader;
 class Texture;
 
 class Material
@@ -39,7 +39,7 @@ private:
 	struct MaterialTexture
 	{
 		Texture* mTexture;
-		const char* mUniform;
+		UniformHandle mUniform;
 	};
 
 private:
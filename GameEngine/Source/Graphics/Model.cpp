@@ -11,6 +11,11 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <fstream>
+#include <string>
+#include <string.h>
+#include <assert.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -32,35 +37,136 @@ Model::~Model()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene)
+namespace
 {
-	Array<float> data;
+	/* Cooked file identifier */
+	const Uint32 COOKED_MAGIC = 0x4853454D;
+	/* Cooked file version, increment when the layout changes */
+	const Uint32 COOKED_VERSION = 1;
+	/* Alignment of vertex data in cooked files */
+	const Uint32 COOKED_ALIGN = 16;
+
+	/* Cooked file header */
+	struct CookedHeader
+	{
+		/* File identifier */
+		Uint32 mMagic;
+		/* File version */
+		Uint32 mVersion;
+		/* Number of meshes */
+		Uint32 mNumMeshes;
+		/* Unused */
+		Uint32 mPadding;
+	};
+
+	/* Cooked mesh entry, entries follow the header */
+	struct CookedMesh
+	{
+		/* Offset of vertex data from start of file */
+		Uint64 mDataOffset;
+		/* Number of vertices */
+		Uint32 mNumVertices;
+		/* Size of a vertex in bytes */
+		Uint32 mStride;
+		/* Number of vertex attributes */
+		Uint32 mNumAttribs;
+		/* Vertex attribute layout */
+		MeshAttrib mAttribs[MESH_MAX_ATTRIBS];
+		/* Bounding box min */
+		float mMin[3];
+		/* Bounding box max */
+		float mMax[3];
+	};
+
+	/* Add attribute to layout */
+	void AddAttrib(MeshData& m, Uint32 index, Uint32 size)
+	{
+		MeshAttrib& attrib = m.mAttribs[m.mNumAttribs++];
+		attrib.mIndex = index;
+		attrib.mSize = size;
+		attrib.mOffset = m.mStride;
+
+		m.mStride += size * sizeof(float);
+	}
+
+	/* Check that a cooked mesh entry describes vertex data inside a file of the given size (Sizes are untrusted, so nothing can overflow) */
+	bool IsValidEntry(const CookedMesh& entry, Uint64 fileSize)
+	{
+		if (entry.mNumAttribs > MESH_MAX_ATTRIBS || entry.mDataOffset > fileSize)
+			return false;
 
-	// Calculate data size
-	Uint32 vertexSize = 6;
-	if (mesh->HasTextureCoords(0))
-		vertexSize += 2;
-	if (mesh->HasVertexColors(0))
-		vertexSize += 3;
+		// 32 bit count times 32 bit stride always fits in 64 bits
+		if ((Uint64)entry.mNumVertices * entry.mStride > fileSize - entry.mDataOffset)
+			return false;
 
-	data.Reserve(mesh->mNumVertices * vertexSize);
+		for (Uint32 i = 0; i < entry.mNumAttribs; ++i)
+		{
+			const MeshAttrib& attrib = entry.mAttribs[i];
+
+			// Vertex attributes use locations below the instance attributes, and each must fit inside a vertex
+			if (attrib.mIndex >= MESH_MAX_ATTRIBS || attrib.mSize < 1 || attrib.mSize > 4)
+				return false;
+			if ((Uint64)attrib.mOffset + attrib.mSize * sizeof(float) > entry.mStride)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ProcessMesh(MeshData& m, aiMesh* mesh, const aiScene* scene)
+{
+	bool hasTexCoords = mesh->HasTextureCoords(0);
+	bool hasColors = mesh->HasVertexColors(0);
+
+	// Vertex layout
+	m.mStride = 0;
+	m.mNumAttribs = 0;
+	AddAttrib(m, 0, 3);
+	AddAttrib(m, 1, 3);
+	if (hasTexCoords)
+		AddAttrib(m, 2, 2);
+	if (hasColors)
+		AddAttrib(m, 3, 3);
+
+	Uint32 vertexSize = m.mStride / sizeof(float);
+	m.mNumVertices = mesh->mNumVertices;
+	m.mVertices.Resize(mesh->mNumVertices * vertexSize);
 
 	// Keep track of min and max for bounding box
 	aiVector3D& first = mesh->mVertices[0];
 	Vector3f min(first.x, first.y, first.z);
 	Vector3f max(min);
 
-	for (Uint32 i = 0; i < mesh->mNumVertices; ++i)
+	float* data = &m.mVertices.Front();
+	for (Uint32 i = 0; i < mesh->mNumVertices; ++i, data += vertexSize)
 	{
 		aiVector3D& v = mesh->mVertices[i];
 		aiVector3D& n = mesh->mNormals[i];
 
-		data.Push(v.x);
-		data.Push(v.y);
-		data.Push(v.z);
-		data.Push(n.x);
-		data.Push(n.y);
-		data.Push(n.z);
+		data[0] = v.x;
+		data[1] = v.y;
+		data[2] = v.z;
+		data[3] = n.x;
+		data[4] = n.y;
+		data[5] = n.z;
+
+		float* attrib = data + 6;
+		if (hasTexCoords)
+		{
+			aiVector3D& t = mesh->mTextureCoords[0][i];
+			*attrib++ = t.x;
+			*attrib++ = t.y;
+		}
+		if (hasColors)
+		{
+			aiColor4D& c = mesh->mColors[0][i];
+			*attrib++ = c.r;
+			*attrib++ = c.g;
+			*attrib++ = c.b;
+		}
 
 		if (v.x < min.x)
 			min.x = v.x;
@@ -78,48 +184,18 @@ Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene)
 			max.z = v.z;
 	}
 
-	// Push data to vertex buffer
-	VertexBuffer* vbo = Resource<VertexBuffer>::Create();
-	vbo->Bind(VertexBuffer::Array);
-	vbo->BufferData(&data.Front(), data.Size() * sizeof(float), VertexBuffer::Static);
-
-	// Set up vertex array
-	VertexArray* vao = Resource<VertexArray>::Create();
-	vao->Bind();
-
-	vertexSize *= sizeof(float);
-	vao->VertexAttrib(0, 3, vertexSize, 0);
-	vao->VertexAttrib(1, 3, vertexSize, 12);
-
-	Uint32 offset = 24;
-	if (mesh->HasTextureCoords(0))
-	{
-		vao->VertexAttrib(2, 2, vertexSize, offset);
-		offset += 2 * sizeof(float);
-	}
-	if (mesh->HasVertexColors(0))
-	{
-		vao->VertexAttrib(3, 3, vertexSize, offset);
-	}
-
-
-	// Add all data to mesh
-	Mesh m;
-	m.mNumVertices = mesh->mNumVertices;
-	m.mVertexArray = vao;
 	m.mBoundingBox = BoundingBox(min, max);
-
-	return m;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void ProcessNode(Array<Mesh>& meshes, aiNode* node, const aiScene* scene)
+void ProcessNode(Array<MeshData>& meshes, aiNode* node, const aiScene* scene)
 {
 	for (Uint32 i = 0; i < node->mNumMeshes; ++i)
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.Push(ProcessMesh(mesh, scene));
+		meshes.Push(MeshData());
+		ProcessMesh(meshes.Back(), mesh, scene);
 	}
 
 	// Process children
@@ -130,6 +206,42 @@ void ProcessNode(Array<Mesh>& meshes, aiNode* node, const aiScene* scene)
 ///////////////////////////////////////////////////////////////////////////////
 
 bool Model::Load(const char* fname)
+{
+	return LoadData(fname) && Upload();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Model::LoadData(const char* fname)
+{
+	std::string cooked = std::string(fname) + COOKED_MODEL_EXT;
+	Int64 cookedTime = MappedFile::GetModifiedTime(cooked.c_str());
+
+	// Cooked file is used if it is at least as new as the source (Or if only the cooked file exists)
+	if (cookedTime && cookedTime >= MappedFile::GetModifiedTime(fname) && LoadCooked(cooked.c_str()))
+	{
+		mFileHash = fname;
+
+		LOG_INFO << "Loaded cooked model file " << cooked << "\n";
+		return true;
+	}
+
+	if (!Import(fname))
+		return false;
+
+	// Cook so the next load skips importing
+	if (!Cook(cooked.c_str()))
+		LOG_WARNING << "Failed to write cooked model file " << cooked << "\n";
+
+	mFileHash = fname;
+
+	LOG_INFO << "Loaded model file " << fname << "\n";
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Model::Import(const char* fname)
 {
 	Assimp::Importer importer;
 	const aiScene* scene = importer.ReadFile(fname, aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -140,22 +252,171 @@ bool Model::Load(const char* fname)
 		return false;
 	}
 
+	// Process nodes
+	mMeshData.Reserve(scene->mNumMeshes > 4 ? scene->mNumMeshes : 4);
+	ProcessNode(mMeshData, scene->mRootNode, scene);
+
+	// Vertex arrays don't move anymore
+	for (Uint32 i = 0; i < mMeshData.Size(); ++i)
+		mMeshData[i].mData = &mMeshData[i].mVertices.Front();
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Model::LoadCooked(const char* fname)
+{
+	if (!mCookedFile.Open(fname)) return false;
+
+	const Uint8* file = mCookedFile.GetData();
+	Uint64 size = mCookedFile.GetSize();
+
+	const CookedHeader* header = (const CookedHeader*)file;
+	bool valid =
+		size >= sizeof(CookedHeader) &&
+		header->mMagic == COOKED_MAGIC &&
+		header->mVersion == COOKED_VERSION &&
+		(Uint64)header->mNumMeshes * sizeof(CookedMesh) <= size - sizeof(CookedHeader);
+
+	if (valid)
+	{
+		const CookedMesh* meshes = (const CookedMesh*)(file + sizeof(CookedHeader));
+		mMeshData.Reserve(header->mNumMeshes > 4 ? header->mNumMeshes : 4);
+
+		for (Uint32 i = 0; i < header->mNumMeshes && valid; ++i)
+		{
+			const CookedMesh& entry = meshes[i];
+
+			// Vertex data and layout must be inside the file
+			valid = IsValidEntry(entry, size);
+			if (!valid) break;
+
+			MeshData m;
+			m.mData = file + entry.mDataOffset;
+			m.mNumVertices = entry.mNumVertices;
+			m.mStride = entry.mStride;
+			m.mNumAttribs = entry.mNumAttribs;
+			memcpy(m.mAttribs, entry.mAttribs, sizeof(entry.mAttribs));
+			m.mBoundingBox = BoundingBox(
+				Vector3f(entry.mMin[0], entry.mMin[1], entry.mMin[2]),
+				Vector3f(entry.mMax[0], entry.mMax[1], entry.mMax[2]));
+
+			mMeshData.Push(std::move(m));
+		}
+	}
+
+	if (!valid)
+	{
+		LOG_WARNING << "Invalid cooked model file " << fname << "\n";
+
+		mMeshData = Array<MeshData>();
+		mCookedFile.Close();
+		return false;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Model::Cook(const char* fname)
+{
+	std::ofstream file(fname, std::ios::binary);
+	if (!file.is_open()) return false;
+
+	CookedHeader header;
+	header.mMagic = COOKED_MAGIC;
+	header.mVersion = COOKED_VERSION;
+	header.mNumMeshes = mMeshData.Size();
+	header.mPadding = 0;
+	file.write((const char*)&header, sizeof(header));
+
+	// Vertex data starts after the mesh table
+	Uint64 offset = sizeof(CookedHeader) + mMeshData.Size() * sizeof(CookedMesh);
+
+	for (Uint32 i = 0; i < mMeshData.Size(); ++i)
+	{
+		const MeshData& m = mMeshData[i];
+		offset = (offset + COOKED_ALIGN - 1) & ~(Uint64)(COOKED_ALIGN - 1);
+
+		CookedMesh entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.mDataOffset = offset;
+		entry.mNumVertices = m.mNumVertices;
+		entry.mStride = m.mStride;
+		entry.mNumAttribs = m.mNumAttribs;
+		memcpy(entry.mAttribs, m.mAttribs, sizeof(m.mAttribs));
+		entry.mMin[0] = m.mBoundingBox.mMin.x;
+		entry.mMin[1] = m.mBoundingBox.mMin.y;
+		entry.mMin[2] = m.mBoundingBox.mMin.z;
+		entry.mMax[0] = m.mBoundingBox.mMax.x;
+		entry.mMax[1] = m.mBoundingBox.mMax.y;
+		entry.mMax[2] = m.mBoundingBox.mMax.z;
+		file.write((const char*)&entry, sizeof(entry));
+
+		offset += (Uint64)m.mNumVertices * m.mStride;
+	}
+
+	// Vertex data
+	offset = sizeof(CookedHeader) + mMeshData.Size() * sizeof(CookedMesh);
+	for (Uint32 i = 0; i < mMeshData.Size(); ++i)
+	{
+		const MeshData& m = mMeshData[i];
+
+		// Padding
+		Uint64 aligned = (offset + COOKED_ALIGN - 1) & ~(Uint64)(COOKED_ALIGN - 1);
+		const char zeros[COOKED_ALIGN] = { 0 };
+		file.write(zeros, aligned - offset);
+
+		Uint64 size = (Uint64)m.mNumVertices * m.mStride;
+		file.write((const char*)m.mData, size);
+		offset = aligned + size;
+	}
+
+	return file.good();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Model::Upload()
+{
 	// Reserve mesh array
-	mMeshes.Reserve(scene->mNumMeshes > 4 ? scene->mNumMeshes : 4);
-	// Temporary array
-	Array<Mesh> meshes(mMeshes.Capacity());
+	mMeshes.Reserve(mMeshData.Size() > 4 ? mMeshData.Size() : 4);
 
-	// Process nodes
-	ProcessNode(meshes, scene->mRootNode, scene);
+	for (Uint32 i = 0; i < mMeshData.Size(); ++i)
+	{
+		const MeshData& data = mMeshData[i];
 
-	// Add meshes
-	for (Uint32 i = 0; i < meshes.Size(); ++i)
-		AddMesh(meshes[i]);
+		// Push data to vertex buffer (Straight from the mapped file for cooked models)
+		VertexBuffer* vbo = Resource<VertexBuffer>::Create();
+		vbo->Bind(VertexBuffer::Array);
+		vbo->BufferData(data.mData, data.mNumVertices * data.mStride, VertexBuffer::Static);
 
+		// Set up vertex array
+		VertexArray* vao = Resource<VertexArray>::Create();
+		vao->Bind();
 
-	mFileHash = fname;
+		for (Uint32 a = 0; a < data.mNumAttribs; ++a)
+		{
+			const MeshAttrib& attrib = data.mAttribs[a];
+			vao->VertexAttrib(attrib.mIndex, attrib.mSize, data.mStride, attrib.mOffset);
+		}
+
+
+		// Add all data to mesh
+		Mesh m;
+		m.mNumVertices = data.mNumVertices;
+		m.mVertexArray = vao;
+		m.mBoundingBox = data.mBoundingBox;
+
+		AddMesh(m);
+	}
+
+	// Vertex data is on the GPU now
+	mMeshData = Array<MeshData>();
+	mCookedFile.Close();
 
-	LOG_INFO << "Loaded model file " << fname << "\n";
 	return true;
 }
 
@@ -204,6 +465,23 @@ void Model::AddMesh(const Mesh& mesh)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void Model::AddLod(Model* model, float distance)
+{
+	assert(mLods.Size() + 1 < MODEL_MAX_LODS);
+	assert(!mLodDistances.Size() || distance > mLodDistances.Back());
+
+	if (!mLods.Capacity())
+	{
+		mLods.Reserve(MODEL_MAX_LODS - 1);
+		mLodDistances.Reserve(MODEL_MAX_LODS - 1);
+	}
+
+	mLods.Push(model);
+	mLodDistances.Push(distance);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 Uint32 Model::GetNumMeshes() const
 {
 	return mMeshes.Size();
@@ -219,4 +497,21 @@ const BoundingBox& Model::GetBoundingBox() const
 	return mBoundingBox;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Model::GetNumLods() const
+{
+	return mLods.Size() + 1;
+}
+
+Model* Model::GetLod(Uint32 level)
+{
+	return level ? mLods[level - 1] : this;
+}
+
+float Model::GetLodDistance(Uint32 level) const
+{
+	return level ? mLodDistances[level - 1] : 0.0f;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <Core/TypeInfo.h>
 #include <Core/Array.h>
+#include <Core/MappedFile.h>
 
 #include <Math/BoundingBox.h>
 #include <Graphics/Mesh.h>
@@ -11,6 +12,45 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Maximum number of vertex attributes in a mesh */
+#define MESH_MAX_ATTRIBS 4
+/* Added to model file names to get the name of their cooked file */
+#define COOKED_MODEL_EXT ".mesh"
+/* Maximum number of detail levels in a model (Including the model itself) */
+#define MODEL_MAX_LODS 4
+
+/* Layout of a vertex attribute */
+struct MeshAttrib
+{
+	/* Attribute index */
+	Uint32 mIndex;
+	/* Number of floats */
+	Uint32 mSize;
+	/* Offset from start of vertex in bytes */
+	Uint32 mOffset;
+};
+
+/* Mesh vertex data read from a model file, before it is uploaded */
+struct MeshData
+{
+	/* Interleaved vertex data (Points into mVertices or a mapped cooked file) */
+	const void* mData;
+	/* Vertex data imported from a source file */
+	Array<float> mVertices;
+	/* Number of vertices */
+	Uint32 mNumVertices;
+	/* Size of a vertex in bytes */
+	Uint32 mStride;
+	/* Vertex attribute layout */
+	MeshAttrib mAttribs[MESH_MAX_ATTRIBS];
+	/* Number of vertex attributes */
+	Uint32 mNumAttribs;
+	/* Mesh bounding box */
+	BoundingBox mBoundingBox;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 class Model : public Loadable
 {
 	TYPE_INFO(Model);
@@ -21,11 +61,19 @@ public:
 
 	/* Load model from file */
 	bool Load(const char* fname);
+	/* Read model file without creating GPU buffers (Thread safe).
+	   Uses the cooked file if it isn't older than the source, otherwise imports the source and cooks it */
+	bool LoadData(const char* fname);
+	/* Create GPU buffers from loaded data (Main thread only) */
+	bool Upload();
 
 	/* Set max number of meshes (Default: 4 or however many meshes th model file contains) */
 	void SetMaxMeshes(Uint32 max);
 	/* Add mesh (Make sure mesh bounding box has been set) */
 	void AddMesh(const Mesh& mesh);
+	/* Add a lower detail level used beyond the given camera distance (Add levels in order of increasing distance,
+	   before the model is registered with the renderer. The model doesn't own its levels) */
+	void AddLod(Model* model, float distance);
 
 	/* Get number of meshes in model */
 	Uint32 GetNumMeshes() const;
@@ -34,11 +82,35 @@ public:
 	/* Get bounding box */
 	const BoundingBox& GetBoundingBox() const;
 
+	/* Get number of detail levels (At least 1, the model itself is level 0) */
+	Uint32 GetNumLods() const;
+	/* Get model used for a detail level */
+	Model* GetLod(Uint32 level);
+	/* Get camera distance a detail level starts at */
+	float GetLodDistance(Uint32 level) const;
+
+private:
+	/* Import model from source file */
+	bool Import(const char* fname);
+	/* Map cooked model file */
+	bool LoadCooked(const char* fname);
+	/* Write loaded mesh data to a cooked model file */
+	bool Cook(const char* fname);
+
 private:
 	/* List of meshes */
 	Array<Mesh> mMeshes;
 	/* Model bounding box */
 	BoundingBox mBoundingBox;
+	/* Loaded mesh data that hasn't been uploaded */
+	Array<MeshData> mMeshData;
+	/* Cooked file mapped until mesh data is uploaded */
+	MappedFile mCookedFile;
+
+	/* Lower detail levels (Level 1 onwards) */
+	Array<Model*> mLods;
+	/* Camera distance each lower detail level starts at */
+	Array<float> mLodDistances;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
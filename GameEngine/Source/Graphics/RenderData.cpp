@@ -0,0 +1,73 @@
+#include <Graphics/Renderer.h>
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void StaticRenderData::BuildDrawCommands()
+{
+	Array<RenderChunk>& chunks = mRenderChunks.GetData();
+
+	for (Uint32 lod = 0; lod < mNumLods; ++lod)
+		mDrawCommands[lod].Clear();
+
+	// One command per visible chunk, bucketed by detail level
+	for (Uint32 i = 0; i < mVisibleChunks.Size(); ++i)
+	{
+		const RenderChunk& chunk = chunks[mVisibleChunks[i]];
+		if (!chunk.mTransforms.Size()) continue;
+
+		mDrawCommands[chunk.mLod].Push(DrawCommand{ chunk.mOffset, chunk.mTransforms.Size() });
+	}
+
+	for (Uint32 lod = 0; lod < mNumLods; ++lod)
+	{
+		Array<DrawCommand>& commands = mDrawCommands[lod];
+		if (commands.Size() < 2) continue;
+
+		// Order by buffer position so neighbouring ranges are next to each other
+		std::sort(&commands.Front(), &commands.Front() + commands.Size(),
+			[](const DrawCommand& a, const DrawCommand& b) { return a.mBaseInstance < b.mBaseInstance; });
+
+		// Merge commands whose ranges touch
+		Uint32 num = 1;
+		for (Uint32 i = 1; i < commands.Size(); ++i)
+		{
+			DrawCommand& prev = commands[num - 1];
+			const DrawCommand& command = commands[i];
+
+			if (prev.mBaseInstance + prev.mInstanceCount == command.mBaseInstance)
+				prev.mInstanceCount += command.mInstanceCount;
+			else
+				commands[num++] = command;
+		}
+
+		while (commands.Size() > num)
+			commands.Pop();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StaticRenderData::UpdateLods(const Vector3f& camPos)
+{
+	Array<RenderChunk>& chunks = mRenderChunks.GetData();
+
+	for (Uint32 i = 0; i < mVisibleChunks.Size(); ++i)
+	{
+		RenderChunk& chunk = chunks[mVisibleChunks[i]];
+		float dist = Distance(chunk.mBoundingBox.GetPosition(), camPos);
+		Uint32 lod = chunk.mLod;
+
+		// Only drop detail once well past the switch distance, and only regain it once well inside
+		while (lod + 1 < mNumLods && dist > mLodDistances[lod + 1] * (1.0f + LOD_HYSTERESIS))
+			++lod;
+		while (lod > 0 && dist < mLodDistances[lod] * (1.0f - LOD_HYSTERESIS))
+			--lod;
+
+		chunk.mLod = lod;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -159,8 +159,11 @@ void DefaultLighting::RenderSetup(FrameBuffer* gbuffer)
 	// Lights
 	mScene->GetDirLight().Use(mShader);
 
-	mShader->SetUniform("mCamPos", mScene->GetCamera().GetPosition());
-	mShader->SetUniform("mAmbient", mScene->GetAmbient());
+	static const UniformHandle camPos = Shader::GetUniformHandle("mCamPos");
+	static const UniformHandle ambient = Shader::GetUniformHandle("mAmbient");
+
+	mShader->SetUniform(camPos, mScene->GetCamera().GetPosition());
+	mShader->SetUniform(ambient, mScene->GetAmbient());
 
 	// Apply uniforms
 	mShader->ApplyUniforms();
@@ -12,16 +12,77 @@
 #include <Graphics/Model.h>
 #include <Graphics/Material.h>
 #include <Graphics/Shader.h>
+#include <Graphics/UniformBlock.h>
 
 #include <Resource/Resource.h>
 
 #include <Scene/Scene.h>
 
+#include <algorithm>
+
+#include <assert.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Sort commands by key (Least significant digit radix sort, scratch must fit all commands) */
+	void RadixSort(RenderCommand* commands, RenderCommand* scratch, Uint32 num)
+	{
+		// Count all digits in one pass
+		Uint32 counts[8][256];
+		memset(counts, 0, sizeof(counts));
+
+		for (Uint32 i = 0; i < num; ++i)
+		{
+			Uint64 key = commands[i].mKey;
+			for (Uint32 d = 0; d < 8; ++d)
+				++counts[d][(key >> (d * 8)) & 0xFF];
+		}
+
+		RenderCommand* src = commands;
+		RenderCommand* dst = scratch;
+
+		for (Uint32 d = 0; d < 8; ++d)
+		{
+			Uint32* count = counts[d];
+			Uint32 shift = d * 8;
+
+			// Skip digits that are the same for every key (Most of them, since IDs are small)
+			if (count[(src[0].mKey >> shift) & 0xFF] == num) continue;
+
+			// Convert counts to offsets
+			Uint32 offset = 0;
+			for (Uint32 i = 0; i < 256; ++i)
+			{
+				Uint32 n = count[i];
+				count[i] = offset;
+				offset += n;
+			}
+
+			// Stable scatter
+			for (Uint32 i = 0; i < num; ++i)
+				dst[count[(src[i].mKey >> shift) & 0xFF]++] = src[i];
+
+			RenderCommand* temp = src;
+			src = dst;
+			dst = temp;
+		}
+
+		// Copy back if the sorted list ended up in scratch space
+		if (src != commands)
+			memcpy(commands, src, num * sizeof(RenderCommand));
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
 Renderer::Renderer() :
 	mLightingMethod		(0),
+	mNumChunksDrawn		(0),
+	mNumChunksCulled	(0),
 	mValidRenderSeq		(false)
 {
 
@@ -38,17 +99,10 @@ Renderer::~Renderer()
 	Resource<FrameBuffer>::Free(mGBuffer);
 	Resource<VertexArray>::Free(mQuadVao);
 	Resource<VertexBuffer>::Free(mQuadVbo);
-	Resource<VertexBuffer>::Free(mDynamicBuffer);
 
-	// Free chunk instance buffers
+	// Free model instance buffers
 	for (Uint32 i = 0; i < mStaticRenderData.Size(); ++i)
-	{
-		StaticRenderData& data = mStaticRenderData[i];
-		Array<RenderChunk>& chunks = data.mRenderChunks.GetData();
-
-		for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
-			Resource<VertexBuffer>::Free(chunks[chunk_n].mInstanceBuffer);
-	}
+		Resource<VertexBuffer>::Free(mStaticRenderData[i].mInstanceBuffer);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -61,8 +115,8 @@ void Renderer::Init(Scene* scene)
 	// Containers
 	mStaticRenderData.Reserve(32);
 	mDynamicRenderData.Reserve(32);
-	mStaticQueue.Reserve(32);
-	mDynamicQueue.Reserve(32);
+	mRenderData.Reserve(64);
+	mCommands.Reserve(256);
 	mRenderPasses.Reserve(4);
 
 
@@ -119,12 +173,17 @@ void Renderer::Init(Scene* scene)
 	mQuadVao->VertexAttrib(0, 2);
 
 
+	// Create common uniform buffer (Layout is checked in every build, mismatches are logged as errors and stop debug builds)
+	if (!CommonUniforms::ValidateLayout())
+		assert(!"CommonUniforms doesn't match the std140 block layout");
+
+	mUniformBuffer.Init(VertexBuffer::Uniform, COMMON_UNIFORM_BUFFER_SIZE);
+
 	// Create dynamic instance buffer
-	mDynamicBuffer = Resource<VertexBuffer>::Create();
-	mDynamicBuffer->Bind(VertexBuffer::Array);
-	mDynamicBuffer->BufferData(NULL, DYNAMIC_INSTANCE_BUFFER_SIZE, VertexBuffer::Stream);
-	mDynBufferSize = DYNAMIC_INSTANCE_BUFFER_SIZE / sizeof(Matrix4f);
-	mDynBufferOffset = 0;
+	mDynamicBuffer.Init(VertexBuffer::Array, DYNAMIC_INSTANCE_BUFFER_SIZE);
+
+	// Create static instance staging buffer
+	mStagingBuffer.Init(VertexBuffer::CopyRead, STATIC_INSTANCE_STAGING_SIZE);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -153,6 +212,9 @@ void Renderer::PostInit()
 
 RenderPass* Renderer::AddRenderPass(RenderPass::Type type)
 {
+	// Pass index is stored in command sort keys
+	assert(mRenderPasses.Size() < MAX_RENDER_PASSES);
+
 	RenderPass* pass = new RenderPass(type);
 	pass->SetLightingPass(mLightingMethod);
 	mRenderPasses.Push(pass);
@@ -163,22 +225,40 @@ RenderPass* Renderer::AddRenderPass(RenderPass::Type type)
 	return pass;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Renderer::GetNumChunksDrawn() const
+{
+	return mNumChunksDrawn;
+}
+
+Uint32 Renderer::GetNumChunksCulled() const
+{
+	return mNumChunksCulled;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
 void Renderer::Update()
 {
 	// Get camera frustum
-	Frustum frustum = mScene->GetCamera().GetFrustum();
+	Camera& camera = mScene->GetCamera();
+	Frustum frustum = camera.GetFrustum();
 
-	UpdateStatic(frustum);
-	UpdateDynamic(frustum);
+	UpdateStatic(frustum, camera.GetPosition());
+	UpdateDynamic(frustum, camera.GetPosition());
+	UpdateCommands();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Renderer::UpdateStatic(const Frustum& frustum)
+void Renderer::UpdateStatic(const Frustum& frustum, const Vector3f& camPos)
 {
+	// Reset chunk counters
+	mNumChunksDrawn = 0;
+	mNumChunksCulled = 0;
+
 	for (Uint32 i = 0; i < mStaticRenderData.Size(); ++i)
 	{
 		StaticRenderData& data = mStaticRenderData[i];
@@ -186,135 +266,295 @@ void Renderer::UpdateStatic(const Frustum& frustum)
 
 		// Clear list of visible chunks
 		data.mVisibleChunks.Clear();
+		for (Uint32 lod = 0; lod < data.mNumLods; ++lod)
+			data.mDrawCommands[lod].Clear();
 
-		for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
+		// Update instance buffer if needed
+		UpdateInstanceBuffer(data);
+
+		if (!chunks.Size()) continue;
+
+		if (data.mCullable)
 		{
-			RenderChunk& chunk = chunks[chunk_n];
+			// Cull all chunks in one batch
+			if (mCullIndices.Size() < chunks.Size())
+				mCullIndices.Resize(chunks.Size());
 
-			// Update instance buffer if needed
-			if (chunk.mUpdated)
-			{
-				Uint32 size = chunk.mTransforms.Size();
-
-				// If there is not enough space in instance buffer
-				if (size > chunk.mBufferSize)
-				{
-					// Recreate (allocate new) buffer
-					chunk.mInstanceBuffer->Bind(VertexBuffer::Array);
-					chunk.mInstanceBuffer->BufferData(
-						&chunk.mTransforms.GetData().Front(),
-						size * sizeof(Matrix4f),
-						VertexBuffer::Static
-					);
-
-					chunk.mBufferSize = size;
-				}
-				else
-				{
-					// Otherwise, just update the buffer
-					chunk.mInstanceBuffer->Bind(VertexBuffer::Array);
-					chunk.mInstanceBuffer->UpdateData(
-						&chunk.mTransforms.GetData().Front(),
-						size * sizeof(Matrix4f)
-					);
-				}
-
-				chunk.mUpdated = false;
-			}
+			Uint32 numVisible = frustum.ContainsBatch(
+				&chunks.Front().mBoundingBox, chunks.Size(), &mCullIndices.Front(), sizeof(RenderChunk));
 
+			// Add visible chunks to the list
+			for (Uint32 n = 0; n < numVisible; ++n)
+				data.mVisibleChunks.Push(mCullIndices[n]);
 
-			// If chunk is visible, add it to the list
-			if (true)
+			mNumChunksDrawn += numVisible;
+			mNumChunksCulled += chunks.Size() - numVisible;
+		}
+		else
+		{
+			// All chunks are visible
+			for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
 				data.mVisibleChunks.Push(chunk_n);
+
+			mNumChunksDrawn += chunks.Size();
+		}
+
+		// Find nearest visible chunk for depth sorting
+		float depth = -1.0f;
+		for (Uint32 n = 0; n < data.mVisibleChunks.Size(); ++n)
+		{
+			float dist = DistanceSquared(chunks[data.mVisibleChunks[n]].mBoundingBox.GetPosition(), camPos);
+			if (depth < 0.0f || dist < depth)
+				depth = dist;
 		}
+
+		data.mDepth = depth > 0.0f ? sqrt(depth) : 0.0f;
+
+		// Pick detail levels, then merge visible chunks into as few draws as possible
+		if (data.mNumLods > 1)
+			data.UpdateLods(camPos);
+		data.BuildDrawCommands();
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Renderer::UpdateDynamic(const Frustum& frustum)
+void Renderer::UpdateInstanceBuffer(StaticRenderData& data)
 {
-	// Count number of dynamic instances
-	Array<ComponentList<RenderComponent>> rs(mDynamicRenderData.Size());
-	Uint32 numInstances = 0;
+	Array<RenderChunk>& chunks = data.mRenderChunks.GetData();
+	bool updated = false;
+	bool resized = false;
 
-	for (Uint32 i = 0; i < mDynamicRenderData.Size(); ++i)
+	// Allocate ranges for chunks that outgrew theirs
+	for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
 	{
-		DynamicRenderData& data = mDynamicRenderData[i];
+		RenderChunk& chunk = chunks[chunk_n];
+		if (!chunk.mUpdated) continue;
+
+		updated = true;
+
+		Uint32 size = chunk.mTransforms.Size();
+		if (size <= chunk.mCapacity) continue;
 
-		// Create component list
-		const Array<RenderComponent>& list = ComponentData<RenderComponent>::GetData(data.mTypeID);
-		ComponentList<RenderComponent> components;
-		components.mData = &list.Front();
-		components.mSize = list.Size();
-		rs.Push(components);
+		// Chunks are usually filled once, so the first range fits exactly, growing ranges double
+		Uint32 capacity = chunk.mCapacity ? 2 * chunk.mCapacity : size;
+		if (capacity < size)
+			capacity = size;
 
-		// Add number of instances;
-		numInstances += components.mSize;
+		if (chunk.mCapacity)
+			data.mAllocator.Free(chunk.mOffset, chunk.mCapacity);
+
+		if (!data.mAllocator.Allocate(capacity, chunk.mOffset))
+		{
+			// Grow buffer, the new free space is at the end so the allocation can't fail again
+			Uint32 bufferSize = 2 * data.mAllocator.GetSize();
+			if (bufferSize < data.mAllocator.GetSize() + capacity)
+				bufferSize = data.mAllocator.GetSize() + capacity;
+			if (bufferSize < STATIC_INSTANCE_BUFFER_MIN_SIZE)
+				bufferSize = STATIC_INSTANCE_BUFFER_MIN_SIZE;
+
+			data.mAllocator.Grow(bufferSize);
+			data.mAllocator.Allocate(capacity, chunk.mOffset);
+			resized = true;
+		}
+
+		chunk.mCapacity = capacity;
 	}
 
-	// Map instance buffer
-	mDynamicBuffer->Bind(VertexBuffer::Array);
-	Matrix4f* buffer = 0;
-	if (mDynBufferOffset + numInstances > mDynBufferSize)
+	if (!updated) return;
+
+	Uint32 instanceSize = InstanceFormat::GetSize(data.mFormat);
+	data.mInstanceBuffer->Bind(VertexBuffer::Array);
+
+	if (resized)
 	{
-		// Reset buffer
-		buffer = (Matrix4f*)mDynamicBuffer->MapWrite(
-			numInstances * sizeof(Matrix4f),
-			VertexBuffer::InvalidateBuffer,
-			0);
-		mDynBufferOffset = 0;
+		// Reallocating loses the old contents, so every chunk is uploaded again in one mapping
+		Uint32 bytes = data.mAllocator.GetSize() * instanceSize;
+		data.mInstanceBuffer->BufferData(NULL, bytes, VertexBuffer::Static);
+		Uint8* buffer = (Uint8*)data.mInstanceBuffer->MapWrite(bytes, VertexBuffer::InvalidateBuffer);
+
+		for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
+		{
+			RenderChunk& chunk = chunks[chunk_n];
+			Uint32 size = chunk.mTransforms.Size();
+
+			if (size)
+				InstanceFormat::Pack(data.mFormat, &chunk.mTransforms.GetData().Front(), sizeof(Matrix4f), 0, size,
+					buffer + chunk.mOffset * instanceSize);
+
+			chunk.mUpdated = false;
+		}
+
+		data.mInstanceBuffer->Unmap();
 	}
 	else
 	{
-		// Unsynchronized for speed
-		buffer = (Matrix4f*)mDynamicBuffer->MapWrite(
-			numInstances * sizeof(Matrix4f),
-			VertexBuffer::Unsynchronized,
-			mDynBufferOffset * sizeof(Matrix4f));
+		// The instance buffer may still be in use by the GPU, so updated chunks are packed into the staging buffer
+		// (Which never waits on the GPU) and copied into their ranges on the GPU
+		Uint32 bytes = 0;
+		for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
+		{
+			if (chunks[chunk_n].mUpdated)
+				bytes += chunks[chunk_n].mTransforms.Size() * instanceSize;
+		}
+
+		Uint32 offset = 0;
+		Uint8* buffer = bytes ? (Uint8*)mStagingBuffer.Map(bytes, offset) : 0;
+		Uint8* ptr = buffer;
+
+		for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
+		{
+			RenderChunk& chunk = chunks[chunk_n];
+			Uint32 size = chunk.mTransforms.Size();
+			if (!chunk.mUpdated || !size) continue;
+
+			InstanceFormat::Pack(data.mFormat, &chunk.mTransforms.GetData().Front(), sizeof(Matrix4f), 0, size, ptr);
+			ptr += size * instanceSize;
+		}
+
+		if (buffer)
+			mStagingBuffer.Unmap();
+
+		for (Uint32 chunk_n = 0; chunk_n < chunks.Size(); ++chunk_n)
+		{
+			RenderChunk& chunk = chunks[chunk_n];
+			if (!chunk.mUpdated) continue;
+
+			Uint32 size = chunk.mTransforms.Size() * instanceSize;
+			if (size)
+			{
+				data.mInstanceBuffer->CopyData(mStagingBuffer.GetBuffer(), size, offset, chunk.mOffset * instanceSize);
+				offset += size;
+			}
+
+			chunk.mUpdated = false;
+		}
 	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Renderer::UpdateDynamic(const Frustum& frustum, const Vector3f& camPos)
+{
+	// Count size of dynamic instances
+	Uint32 numBytes = 0;
+	for (Uint32 i = 0; i < mDynamicRenderData.Size(); ++i)
+	{
+		DynamicRenderData& data = mDynamicRenderData[i];
+		numBytes += ComponentData<RenderComponent>::GetData(data.mTypeID).Size() * InstanceFormat::GetSize(data.mFormat);
+	}
+
+	if (!numBytes)
+	{
+		for (Uint32 i = 0; i < mDynamicRenderData.Size(); ++i)
+			mDynamicRenderData[i].mNumVisible = 0;
+		return;
+	}
+
+	// Map space for all instances in this frame's region
+	Uint32 offset = 0;
+	Uint8* buffer = (Uint8*)mDynamicBuffer.Map(numBytes, offset);
 
 
 	// Iterate dynamic render data
 	for (Uint32 i = 0; i < mDynamicRenderData.Size(); ++i)
 	{
 		DynamicRenderData& data = mDynamicRenderData[i];
-		ComponentList<RenderComponent>& r = rs[i];
+		ComponentGroup<RenderComponent>& group = ComponentData<RenderComponent>::GetData(data.mTypeID);
 		Uint32 numVisible = 0;
+		Uint32 instanceSize = InstanceFormat::GetSize(data.mFormat);
+		float depth = -1.0f;
 
 		// Set data offset
-		data.mInstanceOffset = mDynBufferOffset;
+		data.mInstanceOffset = offset;
+
+		if (group.Size() && mCullIndices.Size() < group.GetChunkCapacity())
+			mCullIndices.Resize(group.GetChunkCapacity());
 
-		// Iterate renderables
-		for (Uint32 n = 0; n < r.mSize; ++n)
+		// Cull renderables one chunk at a time
+		for (Uint32 c = 0; c < group.GetNumChunks(); ++c)
 		{
-			// If visible, add transform
-			if (frustum.Contains(r[n].mBoundingSphere))
-				buffer[numVisible++] = r[n].mTransform;
+			RenderComponent* r = group.GetChunk(c);
+			Uint32 numInChunk = frustum.ContainsBatch(
+				&r[0].mBoundingSphere, group.GetChunkSize(c), &mCullIndices.Front(), sizeof(RenderComponent));
+
+			// Encode transforms of visible renderables
+			InstanceFormat::Pack(data.mFormat, &r[0].mTransform, sizeof(RenderComponent),
+				&mCullIndices.Front(), numInChunk, buffer + numVisible * instanceSize);
+
+			// Find nearest visible renderable for depth sorting
+			for (Uint32 n = 0; n < numInChunk; ++n)
+			{
+				float dist = DistanceSquared(r[mCullIndices[n]].mBoundingSphere.p, camPos);
+				if (depth < 0.0f || dist < depth)
+					depth = dist;
+			}
+
+			numVisible += numInChunk;
 		}
 
 		// Set number of visible instances
 		data.mNumVisible = numVisible;
+		data.mDepth = depth > 0.0f ? sqrt(depth) : 0.0f;
 
 		// Update buffer offset
-		mDynBufferOffset += numVisible;
-		buffer += numVisible;
+		offset += numVisible * instanceSize;
+		buffer += numVisible * instanceSize;
 	}
 
 	// Unbind buffer
-	mDynamicBuffer->Unmap();
+	mDynamicBuffer.Unmap();
 }
 
-///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void CommonUniforms::ApplyToShader(Shader* shader)
+void Renderer::UpdateCommands()
 {
-	shader->SetUniform("mProjView", mProjView);
-	shader->SetUniform("mCamPos", mCamera->GetPosition());
-	shader->SetUniform("mCamPlanes", Vector2f(mCamera->GetNear(), mCamera->GetFar()));
-	shader->SetUniform("mClipPlane", mClipPlane);
-	shader->SetUniform("mTime", mTime);
+	mCommands.Clear();
+
+	// Depth is bucketed over the view distance
+	float depthScale = 65535.0f / mScene->GetCamera().GetFar();
+
+	for (Uint32 i = 0; i < mRenderData.Size(); ++i)
+	{
+		RenderData& renderData = mRenderData[i];
+
+		// Skip meshes with nothing visible
+		float depth = 0.0f;
+		if (renderData.mDynamic)
+		{
+			DynamicRenderData& data = mDynamicRenderData[renderData.mDataIndex];
+			if (!data.mNumVisible) continue;
+			depth = data.mDepth;
+		}
+		else
+		{
+			StaticRenderData& data = mStaticRenderData[renderData.mDataIndex];
+			if (!data.mDrawCommands[renderData.mLod].Size()) continue;
+			depth = data.mDepth;
+		}
+
+		Uint64 depthBits = (Uint64)(depth * depthScale < 65535.0f ? depth * depthScale : 65535.0f);
+
+		// Add a command for every pass the material is visible in
+		for (Uint32 p = 0; p < mRenderPasses.Size(); ++p)
+		{
+			if (!(mRenderPasses[p]->GetType() & renderData.mMaterial->mViewMask)) continue;
+
+			RenderCommand command;
+			command.mKey = ((Uint64)p << SORT_KEY_PASS_SHIFT) | renderData.mStateKey | depthBits;
+			command.mRenderData = i;
+			mCommands.Push(command);
+		}
+	}
+
+	if (!mCommands.Size()) return;
+
+	// Sort commands by pass, then state, then front to back
+	if (mSortBuffer.Size() < mCommands.Size())
+		mSortBuffer.Resize(mCommands.Capacity());
+
+	RadixSort(&mCommands.Front(), &mSortBuffer.Front(), mCommands.Size());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -326,10 +566,16 @@ void Renderer::Render(FrameBuffer* target)
 	// Update stuff
 	Update();
 
+	// Commands are sorted by pass first, so each pass takes the next range
+	Uint32 command = 0;
+
 	for (Uint32 i = 0; i < mRenderPasses.Size(); ++i)
 	{
 		START_PROFILER(RenderPass, i);
 
+		Uint32 start = command;
+		for (; command < mCommands.Size() && (mCommands[command].mKey >> SORT_KEY_PASS_SHIFT) == i; ++command);
+
 		RenderPass* pass = mRenderPasses[i];
 		FrameBuffer* fbuffer = pass->GetTarget();
 		if (i == mRenderPasses.Size() - 1)
@@ -340,13 +586,20 @@ void Renderer::Render(FrameBuffer* target)
 				fbuffer = &FrameBuffer::Default;
 		}
 
-		DoRenderPass(pass, fbuffer);
+		// Passes still run without commands (Clearing and lighting), but Front() of an empty list isn't valid
+		const RenderCommand* commands = command > start ? &mCommands[start] : 0;
+		DoRenderPass(pass, fbuffer, commands, command - start);
 	}
+
+	// All draws using this frame's instances and uniforms have been submitted
+	mDynamicBuffer.EndFrame();
+	mUniformBuffer.EndFrame();
+	mStagingBuffer.EndFrame();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Renderer::DoRenderPass(RenderPass* pass, FrameBuffer* target)
+void Renderer::DoRenderPass(RenderPass* pass, FrameBuffer* target, const RenderCommand* commands, Uint32 numCommands)
 {
 	// Bind G-buffer
 	mGBuffer->Bind();
@@ -376,25 +629,29 @@ void Renderer::DoRenderPass(RenderPass* pass, FrameBuffer* target)
 		camera->SetDirection(plane.ReflectVector(origDir));
 	}
 
-	// Get all common uniforms
+	// Upload common uniforms once for every shader in the pass
 	CommonUniforms uniforms;
-	uniforms.mCamera = camera;
 	uniforms.mProjView = camera->GetProjection() * camera->GetView();
 	uniforms.mClipPlane = Vector4f(plane.n, plane.d);
+	uniforms.mCamPos = camera->GetPosition();
 	uniforms.mTime = mClock.GetElapsedTime();
+	uniforms.mCamPlanes = Vector2f(camera->GetNear(), camera->GetFar());
+	uniforms.mPadding[0] = uniforms.mPadding[1] = 0.0f;
+
+	Uint32 offset = mUniformBuffer.Write(&uniforms, sizeof(CommonUniforms));
+	mUniformBuffer.Bind(COMMON_UNIFORMS_BINDING, offset, sizeof(CommonUniforms));
 
 
-	// Render static objects
-	RenderStatic(pass, uniforms);
-	// Render dynamic objects
-	RenderDynamic(pass, uniforms);
+	// Render static and dynamic objects
+	SubmitCommands(commands, numCommands);
 
 
 	// Combine into final image
 
 	// Setup lighting pass
+	static const UniformHandle colorMultiplier = Shader::GetUniformHandle("mColorMultiplier");
 	float multiplier = pass->GetType() == RenderPass::Normal ? 0.0f : 1.0f;
-	pass->GetLightingPass()->GetShader()->SetUniform("mColorMultiplier", multiplier);
+	pass->GetLightingPass()->GetShader()->SetUniform(colorMultiplier, multiplier);
 	pass->GetLightingPass()->RenderSetup(mGBuffer);
 
 	// Disable depth test for quad render
@@ -431,105 +688,75 @@ void Renderer::DoRenderPass(RenderPass* pass, FrameBuffer* target)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Renderer::RenderStatic(RenderPass* pass, CommonUniforms& uniforms)
+void Renderer::SubmitCommands(const RenderCommand* commands, Uint32 numCommands)
 {
-	if (!mStaticQueue.Size()) return;
-
-	// Get first shader
-	Shader* shader = mStaticQueue.Front().mShader;
-	shader->Bind();
-	uniforms.ApplyToShader(shader);
+	// Currently bound state (Reset every pass, the lighting pass changes it)
+	Shader* shader = 0;
+	Material* material = 0;
+	VertexArray* vertexArray = 0;
+	bool dynamicBound = false;
 
-	// Iterate static queue
-	for (Uint32 i = 0; i < mStaticQueue.Size(); ++i)
+	for (Uint32 i = 0; i < numCommands; ++i)
 	{
-		RenderData& renderData = mStaticQueue[i];
+		RenderData& renderData = mRenderData[commands[i].mRenderData];
 
 		// Change shaders if needed
 		if (renderData.mShader != shader)
 		{
 			shader = renderData.mShader;
 			shader->Bind();
-			uniforms.ApplyToShader(shader);
 		}
 
-		// Test view mask and skip render if necessary
-		if (pass->GetType() & renderData.mMaterial->mViewMask)
+		// Apply material if needed
+		if (renderData.mMaterial != material)
 		{
-			// Apply material
-			renderData.mMaterial->Use();
+			material = renderData.mMaterial;
+			material->Use();
 			shader->ApplyUniforms();
+		}
 
-			// Bind vertex array
-			renderData.mVertexArray->Bind();
+		// Bind vertex array if needed
+		if (renderData.mVertexArray != vertexArray)
+		{
+			vertexArray = renderData.mVertexArray;
+			vertexArray->Bind();
+		}
 
-			// Render all visible chunks
-			StaticRenderData& data = mStaticRenderData[renderData.mDataIndex];
-			Array<RenderChunk>& chunks = data.mRenderChunks.GetData();
+		if (renderData.mDynamic)
+		{
+			DynamicRenderData& data = mDynamicRenderData[renderData.mDataIndex];
+			assert(InstanceFormat::IsCompatible(data.mFormat, shader->GetInstanceFormat()));
 
-			for (Uint32 chunk_n = 0; chunk_n < data.mVisibleChunks.Size(); ++chunk_n)
+			// Bind instance buffer
+			if (!dynamicBound)
 			{
-				RenderChunk& chunk = chunks[data.mVisibleChunks[chunk_n]];
-
-				// Bind instance buffer
-				chunk.mInstanceBuffer->Bind(VertexBuffer::Array);
-				renderData.mVertexArray->VertexAttrib(4, 4, sizeof(Matrix4f), 0 * sizeof(Vector4f), 1);
-				renderData.mVertexArray->VertexAttrib(5, 4, sizeof(Matrix4f), 1 * sizeof(Vector4f), 1);
-				renderData.mVertexArray->VertexAttrib(6, 4, sizeof(Matrix4f), 2 * sizeof(Vector4f), 1);
-				renderData.mVertexArray->VertexAttrib(7, 4, sizeof(Matrix4f), 3 * sizeof(Vector4f), 1);
-
-				// Draw objects
-				renderData.mVertexArray->DrawArrays(renderData.mNumVertices, chunk.mBufferSize);
+				mDynamicBuffer.Bind();
+				dynamicBound = true;
 			}
-		}
-	}
-}
-
-///////////////////////////////////////////////////////////////////////////////
-
-void Renderer::RenderDynamic(RenderPass* pass, CommonUniforms& uniforms)
-{
-	if (!mDynamicQueue.Size()) return;
-
-	mDynamicBuffer->Bind(VertexBuffer::Array);
+			InstanceFormat::SetAttribs(data.mFormat, vertexArray, data.mInstanceOffset);
 
-	// Get first shader
-	Shader* shader = mDynamicQueue.Front().mShader;
-	shader->Bind();
-	uniforms.ApplyToShader(shader);
-
-	// Iterate dynamic queue
-	for (Uint32 i = 0; i < mDynamicQueue.Size(); ++i)
-	{
-		RenderData& renderData = mDynamicQueue[i];
-
-		// Change shaders if needed
-		if (renderData.mShader != shader)
-		{
-			shader = renderData.mShader;
-			shader->Bind();
-			uniforms.ApplyToShader(shader);
+			// Render instances
+			vertexArray->DrawArrays(renderData.mNumVertices, data.mNumVisible);
 		}
-
-		// Test view mask and skip render if necessary
-		if (pass->GetType() & renderData.mMaterial->mViewMask)
+		else
 		{
-			// Apply material
-			renderData.mMaterial->Use();
-			shader->ApplyUniforms();
+			StaticRenderData& data = mStaticRenderData[renderData.mDataIndex];
+			Uint32 instanceSize = InstanceFormat::GetSize(data.mFormat);
+			assert(InstanceFormat::IsCompatible(data.mFormat, shader->GetInstanceFormat()));
 
-			// Bind vertex array
-			DynamicRenderData& data = mDynamicRenderData[renderData.mDataIndex];
-			Uint32 offset = data.mInstanceOffset * sizeof(Matrix4f);
+			// Bind instance buffer (Shared by all chunks of the model)
+			data.mInstanceBuffer->Bind(VertexBuffer::Array);
+			dynamicBound = false;
 
-			renderData.mVertexArray->Bind();
-			renderData.mVertexArray->VertexAttrib(4, 4, sizeof(Matrix4f), offset + 0 * sizeof(Vector4f), 1);
-			renderData.mVertexArray->VertexAttrib(5, 4, sizeof(Matrix4f), offset + 1 * sizeof(Vector4f), 1);
-			renderData.mVertexArray->VertexAttrib(6, 4, sizeof(Matrix4f), offset + 2 * sizeof(Vector4f), 1);
-			renderData.mVertexArray->VertexAttrib(7, 4, sizeof(Matrix4f), offset + 3 * sizeof(Vector4f), 1);
+			// Draw merged ranges of visible chunks at the mesh's detail level
+			const Array<DrawCommand>& commands = data.mDrawCommands[renderData.mLod];
+			for (Uint32 n = 0; n < commands.Size(); ++n)
+			{
+				const DrawCommand& command = commands[n];
 
-			// Render instances
-			renderData.mVertexArray->DrawArrays(renderData.mNumVertices, data.mNumVisible);
+				InstanceFormat::SetAttribs(data.mFormat, vertexArray, command.mBaseInstance * instanceSize);
+				vertexArray->DrawArrays(renderData.mNumVertices, command.mInstanceCount);
+			}
 		}
 	}
 }
@@ -537,44 +764,37 @@ void Renderer::RenderDynamic(RenderPass* pass, CommonUniforms& uniforms)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void Renderer::AddRenderData(const RenderData& data, Array<RenderData>& queue)
+void Renderer::AddRenderData(const RenderData& data)
 {
-	// Add data to end of queue
-	queue.Push(data);
-
-	// Return if this is the first data item
-	if (queue.Size() == 1) return;
-
-	// Start with second to last item
-	int dst = queue.Size() - 1;
-	int src = queue.Size() - 2;
-	Shader* shader = queue[src].mShader;
-
-	while (src > 0)
-	{
-		// If target shader group has been found, quit
-		if (shader == data.mShader) break;
+	// Order of IDs doesn't matter, only that equal state gets equal bits
+	Uint32 shaderID = GetSortID(mShaderIDs, data.mShader);
+	Uint32 materialID = GetSortID(mMaterialIDs, data.mMaterial);
+	Uint32 vertexArrayID = GetSortID(mVertexArrayIDs, data.mVertexArray);
+	assert(shaderID < 4096 && materialID < 65536 && vertexArrayID < 65536);
+
+	mRenderData.Push(data);
+	mRenderData.Back().mStateKey =
+		((Uint64)shaderID << SORT_KEY_SHADER_SHIFT) |
+		((Uint64)materialID << SORT_KEY_MATERIAL_SHIFT) |
+		((Uint64)vertexArrayID << SORT_KEY_VERTEX_ARRAY_SHIFT);
+}
 
-		// Find beggining of shader group
-		for (; src >= 0 && shader == queue[src].mShader; --src);
+///////////////////////////////////////////////////////////////////////////////
 
-		// Move item at (src + 1) to dst
-		queue[dst] = queue[src + 1];
-		// Update dst to (src + 1)
-		dst = src + 1;
+Uint32 Renderer::GetSortID(std::unordered_map<const void*, Uint32>& ids, const void* object)
+{
+	auto it = ids.find(object);
+	if (it != ids.end()) return it->second;
 
-		// Update current shader
-		if (src >= 0)
-			shader = queue[src].mShader;
-	}
+	Uint32 id = ids.size();
+	ids[object] = id;
 
-	// Dst now points to target location
-	queue[dst] = data;
+	return id;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-Uint32 Renderer::RegisterStaticModel(Model* model, float chunkSize, bool cullable)
+Uint32 Renderer::RegisterStaticModel(Model* model, float chunkSize, bool cullable, InstanceFormat::Type format)
 {
 	auto it = mModelToDataIndex.find(model);
 	// If ID exists, quit
@@ -583,9 +803,20 @@ Uint32 Renderer::RegisterStaticModel(Model* model, float chunkSize, bool cullabl
 	StaticRenderData data;
 	data.mRenderChunks.Reserve(256);
 	data.mVisibleChunks.Reserve(64);
+	data.mInstanceBuffer = Resource<VertexBuffer>::Create();
 	data.mChunkSize = chunkSize;
+	data.mDepth = 0.0f;
+	data.mFormat = format;
 	data.mCullable = cullable;
 
+	// Copy detail level distances
+	data.mNumLods = model->GetNumLods();
+	for (Uint32 lod = 0; lod < data.mNumLods; ++lod)
+	{
+		data.mLodDistances[lod] = model->GetLodDistance(lod);
+		data.mDrawCommands[lod].Reserve(64);
+	}
+
 	// Map model pointer to index
 	Uint32 id = mStaticRenderData.Size();
 	mModelToDataIndex[model] = id;
@@ -593,21 +824,28 @@ Uint32 Renderer::RegisterStaticModel(Model* model, float chunkSize, bool cullabl
 	// Add data to list
 	mStaticRenderData.Push(std::move(data));
 
-	// Add all meshes to queue
-	for (Uint32 i = 0; i < model->GetNumMeshes(); ++i)
+	// Add meshes of every detail level to render list
+	for (Uint32 lod = 0; lod < model->GetNumLods(); ++lod)
 	{
-		Mesh& mesh = model->GetMesh(i);
-
-		// Create render data
-		RenderData renderData;
-		renderData.mDataIndex = id;
-		renderData.mNumVertices = mesh.mNumVertices;
-		renderData.mVertexArray = mesh.mVertexArray;
-		renderData.mMaterial = mesh.mMaterial;
-		renderData.mShader = mesh.mMaterial->mShader;
+		Model* lodModel = model->GetLod(lod);
 
-		// Add to queue
-		AddRenderData(renderData, mStaticQueue);
+		for (Uint32 i = 0; i < lodModel->GetNumMeshes(); ++i)
+		{
+			Mesh& mesh = lodModel->GetMesh(i);
+
+			// Create render data
+			RenderData renderData;
+			renderData.mDataIndex = id;
+			renderData.mLod = lod;
+			renderData.mNumVertices = mesh.mNumVertices;
+			renderData.mVertexArray = mesh.mVertexArray;
+			renderData.mMaterial = mesh.mMaterial;
+			renderData.mShader = mesh.mMaterial->mShader;
+			renderData.mDynamic = false;
+
+			// Add to render list
+			AddRenderData(renderData);
+		}
 	}
 
 	return id;
@@ -620,8 +858,6 @@ Uint64 Renderer::AddStaticObject(const TransformComponent& t, RenderComponent& r
 	// Don't add if object is already added
 	if (r.mInstanceID) return 0;
 
-	/* TODO : Handle LOD models */
-
 	int modelID = 0;
 	{
 		auto it = mModelToDataIndex.find(r.mModel);
@@ -648,8 +884,9 @@ Uint64 Renderer::AddStaticObject(const TransformComponent& t, RenderComponent& r
 			// Create new chunk if it doesn't exist
 			RenderChunk chunk;
 			chunk.mTransforms.Reserve(4);
-			chunk.mInstanceBuffer = Resource<VertexBuffer>::Create();
-			chunk.mBufferSize = 0;
+			chunk.mOffset = 0;
+			chunk.mCapacity = 0;
+			chunk.mLod = 0;
 			chunk.mUpdated = false;
 			chunk.mBoundingBox.mMax = (Vector3f)(index + 1) * data.mChunkSize;
 			chunk.mBoundingBox.mMin = (Vector3f)(index)*data.mChunkSize;
@@ -695,8 +932,8 @@ Uint64 Renderer::AddStaticObject(const TransformComponent& t, RenderComponent& r
 	if (box.mMax.z > chunk.mBoundingBox.mMax.z)
 		chunk.mBoundingBox.mMax.z = box.mMax.z;
 
-	// Set instance ID
-	Uint64 instanceID = (indexHash << 16) | transformHandle;
+	// Set instance ID (Chunk index hash and transform slot)
+	Uint64 instanceID = ((Uint64)indexHash << 32) | HandleSlot(transformHandle);
 	r.mInstanceID = instanceID + 1;
 
 	// Mark for update
@@ -712,8 +949,8 @@ void Renderer::RemoveStaticObject(RenderComponent& r)
 	if (!r.mInstanceID) return;
 
 	Uint64 instanceID = r.mInstanceID - 1;
-	Uint32 indexHash = (Uint32)(instanceID >> 16);
-	Handle transformHandle = (Handle)(instanceID - indexHash);
+	Uint32 indexHash = (Uint32)(instanceID >> 32);
+	Uint32 transformSlot = (Uint32)instanceID;
 
 	// Get model group
 	int modelID = 0;
@@ -743,12 +980,12 @@ void Renderer::RemoveStaticObject(RenderComponent& r)
 	RenderChunk& chunk = data.mRenderChunks[chunkHandle];
 
 	// Remove transform
-	chunk.mTransforms.Remove(transformHandle);
+	chunk.mTransforms.Remove(chunk.mTransforms.SlotToHandle(transformSlot));
 
 	// If there are no transforms left, remove chunk
 	if (!chunk.mTransforms.Size())
 	{
-		Resource<VertexBuffer>::Free(chunk.mInstanceBuffer);
+		data.mAllocator.Free(chunk.mOffset, chunk.mCapacity);
 		data.mRenderChunks.Remove(chunkHandle);
 		data.mIndexToHandle.erase(indexHash);
 	}
@@ -763,15 +1000,17 @@ void Renderer::RemoveStaticObject(RenderComponent& r)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-Uint32 Renderer::RegisterDynamicModel(Model* model)
+Uint32 Renderer::RegisterDynamicModel(Model* model, InstanceFormat::Type format)
 {
 	auto it = mModelToDataIndex.find(model);
 	// If ID exists, quit
 	if (it != mModelToDataIndex.end()) return it->second;
 
 	DynamicRenderData data;
+	data.mFormat = format;
 	data.mInstanceOffset = 0;
 	data.mNumVisible = 0;
+	data.mDepth = 0.0f;
 
 	// Map model pointer to index
 	Uint32 id = mDynamicRenderData.Size();
@@ -792,9 +1031,11 @@ Uint32 Renderer::RegisterDynamicModel(Model* model)
 		renderData.mVertexArray = mesh.mVertexArray;
 		renderData.mMaterial = mesh.mMaterial;
 		renderData.mShader = mesh.mMaterial->mShader;
+		renderData.mLod = 0;
+		renderData.mDynamic = true;
 
-		// Add to queue
-		AddRenderData(renderData, mDynamicQueue);
+		// Add to render list
+		AddRenderData(renderData);
 	}
 
 	return id;
@@ -802,14 +1043,14 @@ Uint32 Renderer::RegisterDynamicModel(Model* model)
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Renderer::RegisterDynamicType(Uint32 typeID, Model* model)
+void Renderer::RegisterDynamicType(Uint32 typeID, Model* model, InstanceFormat::Type format)
 {
 	int modelID = 0;
 	{
 		auto it = mModelToDataIndex.find(model);
 		// If model group does not exist, create it
 		if (it == mModelToDataIndex.end())
-			modelID = RegisterDynamicModel(model);
+			modelID = RegisterDynamicModel(model, format);
 		else
 			modelID = it->second;
 	}
@@ -822,10 +1063,11 @@ void Renderer::RegisterDynamicType(Uint32 typeID, Model* model)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void Renderer::AddStaticChunk(const TransformComponent* t, RenderComponent* r, Uint32 n, const BoundingBox& box)
+void Renderer::AddStaticChunk(const ComponentRange<TransformComponent>& t, const ComponentRange<RenderComponent>& r,
+	Uint32 n, const BoundingBox& box)
 {
 	// Only add chunk if there are renderables to add
-	if (!t || !r || !n) return;
+	if (!t.mGroup || !r.mGroup || !n) return;
 
 	int modelID = 0;
 	{
@@ -853,8 +1095,9 @@ void Renderer::AddStaticChunk(const TransformComponent* t, RenderComponent* r, U
 			// Create new chunk if it doesn't exist
 			RenderChunk chunk;
 			chunk.mTransforms.Reserve(4);
-			chunk.mInstanceBuffer = Resource<VertexBuffer>::Create();
-			chunk.mBufferSize = 0;
+			chunk.mOffset = 0;
+			chunk.mCapacity = 0;
+			chunk.mLod = 0;
 			chunk.mUpdated = false;
 			chunk.mBoundingBox.mMax = (Vector3f)(index + 1) * data.mChunkSize;
 			chunk.mBoundingBox.mMin = (Vector3f)(index) * data.mChunkSize;
@@ -892,8 +1135,8 @@ void Renderer::AddStaticChunk(const TransformComponent* t, RenderComponent* r, U
 			ToTransform(t[i].mPosition, t[i].mRotation, t[i].mScale)
 		);
 
-		// Set instance ID
-		Uint64 instanceID = (indexHash << 16) | transformHandle;
+		// Set instance ID (Chunk index hash and transform slot)
+		Uint64 instanceID = ((Uint64)indexHash << 32) | HandleSlot(transformHandle);
 		r[i].mInstanceID = instanceID + 1;
 	}
 
@@ -931,8 +1174,8 @@ void Renderer::RemoveStaticChunk(Model* model, const Vector3f& pos)
 	}
 	RenderChunk& chunk = data.mRenderChunks[chunkHandle];
 
-	// Remove chunk
-	Resource<VertexBuffer>::Free(chunk.mInstanceBuffer);
+	// Remove chunk and free its instance range
+	data.mAllocator.Free(chunk.mOffset, chunk.mCapacity);
 	data.mRenderChunks.Remove(chunkHandle);
 	data.mIndexToHandle.erase(indexHash);
 }
@@ -3,14 +3,19 @@
 
 #include <Core/Clock.h>
 #include <Core/HandleArray.h>
+#include <Core/RangeAllocator.h>
 
+#include <Math/Vector2.h>
 #include <Math/Vector3.h>
 #include <Math/Matrix4.h>
 #include <Math/BoundingBox.h>
 #include <Math/Frustum.h>
 
 #include <Graphics/Components.h>
+#include <Graphics/InstanceFormat.h>
+#include <Graphics/Model.h>
 #include <Graphics/RenderPass.h>
+#include <Graphics/StreamingBuffer.h>
 
 #include <Scene/Components.h>
 
@@ -19,7 +24,25 @@
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Initial size of the dynamic instance buffer for each frame (Grows if it overflows) */
 #define DYNAMIC_INSTANCE_BUFFER_SIZE 1024 * 1024
+/* Initial size of the static instance staging buffer for each frame (Grows if it overflows) */
+#define STATIC_INSTANCE_STAGING_SIZE 256 * 1024
+/* Minimum size of a model's static instance buffer (In instances) */
+#define STATIC_INSTANCE_BUFFER_MIN_SIZE 256
+/* Fraction of a LOD switch distance chunks must move past before changing level (Stops popping at the boundary) */
+#define LOD_HYSTERESIS 0.1f
+/* Initial size of the common uniform buffer for each frame (Enough for a few render passes) */
+#define COMMON_UNIFORM_BUFFER_SIZE 4096
+
+/* Render command sort key layout, from most to least significant bits:
+   render pass (4), shader (12), material (16), vertex array (16), depth (16) */
+#define SORT_KEY_PASS_SHIFT 60
+#define SORT_KEY_SHADER_SHIFT 48
+#define SORT_KEY_MATERIAL_SHIFT 32
+#define SORT_KEY_VERTEX_ARRAY_SHIFT 16
+/* Maximum number of render passes that fit in a sort key */
+#define MAX_RENDER_PASSES 16
 
 class Scene;
 
@@ -28,7 +51,6 @@ class VertexBuffer;
 class Material;
 class Shader;
 class Mesh;
-class Model;
 class FrameBuffer;
 
 class Camera;
@@ -39,21 +61,40 @@ struct RenderChunk
 {
 	/* List of transform matrices */
 	HandleArray<Matrix4f> mTransforms;
-	/* Instance buffer w/ transform data */
-	VertexBuffer* mInstanceBuffer;
-	/* The current size of instance buffer */
-	Uint32 mBufferSize;
+	/* Start of chunk's range in the model instance buffer (In instances) */
+	Uint32 mOffset;
+	/* Size of chunk's range in the model instance buffer (In instances, 0 if not allocated yet) */
+	Uint32 mCapacity;
 
 	/* Bounding box of chunk */
 	BoundingBox mBoundingBox;
+	/* Current detail level */
+	Uint32 mLod;
 	/* True if chunk has been updated */
 	bool mUpdated;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Instanced draw of a range of a model's instance buffer (The instance half of an indirect draw command) */
+struct DrawCommand
+{
+	/* First instance in the instance buffer */
+	Uint32 mBaseInstance;
+	/* Number of instances */
+	Uint32 mInstanceCount;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 struct StaticRenderData
 {
+public:
+	/* Build draw commands for visible chunks, one list per detail level (Chunks with adjacent ranges share a command) */
+	void BuildDrawCommands();
+	/* Update detail levels of visible chunks */
+	void UpdateLods(const Vector3f& camPos);
+
 public:
 	/* Array of chunks */
 	HandleArray<RenderChunk> mRenderChunks;
@@ -61,9 +102,24 @@ public:
 	std::unordered_map<Uint32, Handle> mIndexToHandle;
 	/* List of visible chunks (reconstructed every frame) */
 	Array<Uint32> mVisibleChunks;
+	/* Draw commands for visible chunks of each detail level, shared by all passes (reconstructed every frame) */
+	Array<DrawCommand> mDrawCommands[MODEL_MAX_LODS];
+	/* Camera distance each detail level starts at */
+	float mLodDistances[MODEL_MAX_LODS];
+	/* Number of detail levels */
+	Uint32 mNumLods;
+
+	/* Instance buffer shared by all chunks */
+	VertexBuffer* mInstanceBuffer;
+	/* Suballocates chunk ranges of the instance buffer */
+	RangeAllocator mAllocator;
 
 	/* Chunk size */
 	float mChunkSize;
+	/* Distance from camera to nearest visible chunk (Updated every frame) */
+	float mDepth;
+	/* Instance buffer encoding */
+	InstanceFormat::Type mFormat;
 	/* True if culling is enabled for this model */
 	bool mCullable;
 };
@@ -75,10 +131,14 @@ struct DynamicRenderData
 public:
 	/* Type ID of renderables */
 	Uint32 mTypeID;
-	/* Matrix offset in instance buffer */
+	/* Instance buffer encoding */
+	InstanceFormat::Type mFormat;
+	/* Byte offset in instance buffer */
 	Uint32 mInstanceOffset;
 	/* Number of visible instances */
 	Uint32 mNumVisible;
+	/* Distance from camera to nearest visible instance (Updated every frame) */
+	float mDepth;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -96,24 +156,46 @@ struct RenderData
 	Uint32 mNumVertices;
 	/* Instance data */
 	Uint32 mDataIndex;
+	/* Detail level of mesh (Static render data only) */
+	Uint32 mLod;
+	/* True if instance data is dynamic render data */
+	bool mDynamic;
+
+	/* Shader, material and vertex array bits of the sort key */
+	Uint64 mStateKey;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct RenderCommand
+{
+	/* Sort key (See SORT_KEY_* for layout) */
+	Uint64 mKey;
+	/* Index of render data to draw */
+	Uint32 mRenderData;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Uniforms shared by all scene shaders, uploaded once per render pass (Matches the std140 CommonUniforms block) */
 struct CommonUniforms
 {
 public:
 	/* Projection-view matrix */
 	Matrix4f mProjView;
-	/* Camera object */
-	Camera* mCamera;
 	/* Clip plane */
 	Vector4f mClipPlane;
+	/* Camera position */
+	Vector3f mCamPos;
 	/* Time in seconds */
 	float mTime;
+	/* Camera near and far planes */
+	Vector2f mCamPlanes;
+	/* Pads block to a multiple of a vec4 */
+	float mPadding[2];
 
-	/* Bind all common uniforms */
-	void ApplyToShader(Shader* shader);
+	/* Returns true if struct packing matches the std140 block layout */
+	static bool ValidateLayout();
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -133,21 +215,24 @@ public:
 	/* Render scene */
 	void Render(FrameBuffer* target);
 
-	/* Register model for static renderables */
-	Uint32 RegisterStaticModel(Model* model, float chunkSize, bool cullable = true);
-	/* Register model for dynamic renderables */
-	Uint32 RegisterDynamicModel(Model* model);
+	/* Register model for static renderables (Model shaders must decode the given instance format, asserted when drawing) */
+	Uint32 RegisterStaticModel(Model* model, float chunkSize, bool cullable = true,
+		InstanceFormat::Type format = InstanceFormat::Matrix);
+	/* Register model for dynamic renderables (Model shaders must decode the given instance format, asserted when drawing) */
+	Uint32 RegisterDynamicModel(Model* model, InstanceFormat::Type format = InstanceFormat::Matrix);
 	/* Add static renderable object */
 	Uint64 AddStaticObject(const TransformComponent& t, RenderComponent& r);
 	/* Remove static renderable object */
 	void RemoveStaticObject(RenderComponent& r);
 	/* Register dynamic object type */
-	void RegisterDynamicType(Uint32 typeID, Model* model);
+	void RegisterDynamicType(Uint32 typeID, Model* model, InstanceFormat::Type format = InstanceFormat::Matrix);
 	/* Register dynamic object type */
-	template <typename T> void RegisterDynamicType(Model* model) { RegisterDynamicType(T::StaticTypeID(), model); }
+	template <typename T> void RegisterDynamicType(Model* model, InstanceFormat::Type format = InstanceFormat::Matrix)
+	{ RegisterDynamicType(T::StaticTypeID(), model, format); }
 
 	/* Add a chunk of static renderables */
-	void AddStaticChunk(const TransformComponent* t, RenderComponent* r, Uint32 n, const BoundingBox& box);
+	void AddStaticChunk(const ComponentRange<TransformComponent>& t, const ComponentRange<RenderComponent>& r,
+		Uint32 n, const BoundingBox& box);
 	/* Remove render chunk that contains the given point */
 	void RemoveStaticChunk(Model* model, const Vector3f& pos);
 
@@ -168,23 +253,32 @@ public:
 	/* Add a render pass */
 	RenderPass* AddRenderPass(RenderPass::Type type);
 
+	/* Get number of static chunks that passed culling last frame */
+	Uint32 GetNumChunksDrawn() const;
+	/* Get number of static chunks that were culled last frame */
+	Uint32 GetNumChunksCulled() const;
+
 private:
-	/* Add render data to a queue */
-	void AddRenderData(const RenderData& data, Array<RenderData>& queue);
+	/* Add render data and compute its state key */
+	void AddRenderData(const RenderData& data);
+	/* Get small sort ID of an object (IDs are assigned in order of first use) */
+	static Uint32 GetSortID(std::unordered_map<const void*, Uint32>& ids, const void* object);
 
 	/* Do any pre-render updates */
 	void Update();
 	/* Update (cull) static objects */
-	void UpdateStatic(const Frustum& frustum);
+	void UpdateStatic(const Frustum& frustum, const Vector3f& camPos);
+	/* Allocate ranges for updated chunks and upload their instances */
+	void UpdateInstanceBuffer(StaticRenderData& data);
 	/* Update (cull) dynamic objects */
-	void UpdateDynamic(const Frustum& frustum);
+	void UpdateDynamic(const Frustum& frustum, const Vector3f& camPos);
+	/* Create render commands for all passes and sort them */
+	void UpdateCommands();
 
 	/* Do a render pass */
-	void DoRenderPass(RenderPass* pass, FrameBuffer* target);
-	/* Render static objects */
-	void RenderStatic(RenderPass* pass, CommonUniforms& uniforms);
-	/* Render dynamic objects */
-	void RenderDynamic(RenderPass* pass, CommonUniforms& uniforms);
+	void DoRenderPass(RenderPass* pass, FrameBuffer* target, const RenderCommand* commands, Uint32 numCommands);
+	/* Submit sorted commands, skipping redundant state changes */
+	void SubmitCommands(const RenderCommand* commands, Uint32 numCommands);
 
 private:
 	/* Scene to render */
@@ -198,15 +292,25 @@ private:
 	Array<DynamicRenderData> mDynamicRenderData;
 	/* Map model pointer to render data index */
 	std::unordered_map<Model*, Uint32> mModelToDataIndex;
+	/* Map shaders to sort IDs */
+	std::unordered_map<const void*, Uint32> mShaderIDs;
+	/* Map materials to sort IDs */
+	std::unordered_map<const void*, Uint32> mMaterialIDs;
+	/* Map vertex arrays to sort IDs */
+	std::unordered_map<const void*, Uint32> mVertexArrayIDs;
 
 	/* Default lighting method */
 	LightingPass* mLightingMethod;
 	/* List of render passes */
 	Array<RenderPass*> mRenderPasses;
-	/* Static render queue */
-	Array<RenderData> mStaticQueue;
-	/* Dynamic render queue */
-	Array<RenderData> mDynamicQueue;
+	/* List of render data for every registered mesh */
+	Array<RenderData> mRenderData;
+	/* Render commands for this frame (Sorted by key) */
+	Array<RenderCommand> mCommands;
+	/* Scratch space for sorting commands */
+	Array<RenderCommand> mSortBuffer;
+	/* Scratch list of indices that passed culling */
+	Array<Uint32> mCullIndices;
 
 	/* G-buffer for deffered lighting */
 	FrameBuffer* mGBuffer;
@@ -215,12 +319,17 @@ private:
 	/* Quad vertex buffer */
 	VertexBuffer* mQuadVbo;
 
+	/* Common uniform buffer (One range per render pass) */
+	StreamingBuffer mUniformBuffer;
 	/* Dynamic instance buffer */
-	VertexBuffer* mDynamicBuffer;
-	/* Dynamic buffer size */
-	Uint32 mDynBufferSize;
-	/* Dynamic buffer offset */
-	Uint32 mDynBufferOffset;
+	StreamingBuffer mDynamicBuffer;
+	/* Staging buffer for static instance updates (Copied into the instance buffers on the GPU) */
+	StreamingBuffer mStagingBuffer;
+
+	/* Number of static chunks that passed culling */
+	Uint32 mNumChunksDrawn;
+	/* Number of static chunks that were culled */
+	Uint32 mNumChunksCulled;
 
 	/* True if a normal pass has been added and is at end */
 	bool mValidRenderSeq;
@@ -1,8 +1,11 @@
 #include <Graphics/Shader.h>
 
 #include <Core/LogFile.h>
+#include <Core/StringHash.h>
 
 #include <Graphics/OpenGL.h>
+#include <Graphics/UniformBlock.h>
+#include <Graphics/InstanceFormat.h>
 
 #include <Resource/XmlDocument.h>
 
@@ -13,11 +16,36 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 Uint32 Shader::sCurrentBound = 0;
+std::unordered_map<Uint32, UniformHandle> Shader::sUniformHandles;
+Array<std::string> Shader::sUniformNames;
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Uniform block with a fixed binding point */
+	struct BlockBinding
+	{
+		/* Block name */
+		const char* mName;
+		/* Binding point */
+		Uint32 mBinding;
+	};
+
+	/* Engine uniform blocks, bound after linking so every shader that declares one shares its buffer */
+	const BlockBinding BLOCK_BINDINGS[] =
+	{
+		{ "CommonUniforms", COMMON_UNIFORMS_BINDING },
+		{ "AtmosphereUniforms", ATMOSPHERE_UNIFORMS_BINDING }
+	};
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 
 Shader::Shader() :
-	mUniforms		(8)
+	mUniforms		(8),
+	mHandleToIndex	(32),
+	mInstanceFormat	(-1)
 {
 
 }
@@ -35,6 +63,13 @@ Shader::~Shader()
 ///////////////////////////////////////////////////////////////////////////////
 
 bool Shader::Load(const char* fname)
+{
+	return LoadData(fname) && Upload();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Shader::LoadData(const char* fname)
 {
 	XmlDocument doc;
 	if (!doc.Load(fname))
@@ -43,47 +78,68 @@ bool Shader::Load(const char* fname)
 		return false;
 	}
 
-	// Create program
-	Uint32 program = 0;
-	program = glCreateProgram();
-	// List of shaders
-	Array<Uint32> shaders(4);
+	mSources.Reserve(4);
 
 	XmlNode programNode = doc.GetFirstNode("program");
 	XmlNode shaderNode = programNode.GetFirstNode("shader");
 	while (shaderNode.Exists())
 	{
 		const char* type = shaderNode.GetFirstAttribute("type").GetValue();
-		Uint32 shader = 0;
 
 		if (strcmp(type, "Vertex") == 0)
-			shader = LoadShader(shaderNode.GetValue(), GL_VERTEX_SHADER);
+			ReadShader(shaderNode.GetValue(), GL_VERTEX_SHADER);
 
 		else if (strcmp(type, "Geometry") == 0)
-			shader = LoadShader(shaderNode.GetValue(), GL_GEOMETRY_SHADER);
+			ReadShader(shaderNode.GetValue(), GL_GEOMETRY_SHADER);
 
 		else if (strcmp(type, "Fragment") == 0)
-			shader = LoadShader(shaderNode.GetValue(), GL_FRAGMENT_SHADER);
+			ReadShader(shaderNode.GetValue(), GL_FRAGMENT_SHADER);
 
 		else
 			LOG_WARNING << "Skipping " << shaderNode.GetValue() << ", unknown shader type\n";
 
+		shaderNode = shaderNode.GetNextSibling("shader");
+	}
+
+	// Transform feedback varyings
+	XmlNode feedbackNode = programNode.GetFirstNode("feedback");
+	if (feedbackNode.Exists())
+		mFeedback = feedbackNode.GetValue();
+
+
+	mFileHash = fname;
+	mFile = fname;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Shader::Upload()
+{
+	// Create program
+	Uint32 program = 0;
+	program = glCreateProgram();
+	// List of shaders
+	Array<Uint32> shaders(4);
+
+	for (Uint32 i = 0; i < mSources.Size(); ++i)
+	{
+		Uint32 shader = CompileShader(mSources[i]);
+
 		if (shader)
 		{
 			// Add shader to shader list
 			glAttachShader(program, shader);
 			shaders.Push(shader);
 		}
-
-		shaderNode = shaderNode.GetNextSibling("shader");
 	}
 
 	// Add transform feedback varyings
-	XmlNode feedbackNode = programNode.GetFirstNode("feedback");
-	if (feedbackNode.Exists())
+	if (mFeedback.size())
 	{
 		Array<const char*> varyings(4);
-		char* value = feedbackNode.GetValue();
+		char* value = &mFeedback[0];
 
 		// Add first varying
 		if (*value != ' ' && *value != 0)
@@ -98,11 +154,18 @@ bool Shader::Load(const char* fname)
 			}
 		}
 
-		Uint32 size = varyings.Size();
 		if (varyings.Size())
 			glTransformFeedbackVaryings(program, varyings.Size(), &varyings[0], GL_INTERLEAVED_ATTRIBS);
 	}
 
+	// Sources aren't needed after compiling
+	mSources = Array<ShaderSource>();
+	mFeedback = std::string();
+
+	// File name is only kept for the load result message
+	std::string file;
+	file.swap(mFile);
+
 	// Link program
 	glLinkProgram(program);
 
@@ -113,7 +176,7 @@ bool Shader::Load(const char* fname)
 	if (!success)
 	{
 		glGetProgramInfoLog(program, 512, NULL, infoLog);
-		LOG_ERROR << "Failed to link program:\n" << infoLog << "\n";
+		LOG_ERROR << "Failed to link shader " << file << ":\n" << infoLog << "\n";
 		glDeleteProgram(program);
 		return false;
 	}
@@ -124,45 +187,66 @@ bool Shader::Load(const char* fname)
 
 	mID = program;
 
+	// Renderer checks instance buffers are encoded the way the program decodes them
+	mInstanceFormat = InstanceFormat::FromProgram(mID);
 
-	mFileHash = fname;
+	// Bind engine uniform blocks
+	for (Uint32 i = 0; i < sizeof(BLOCK_BINDINGS) / sizeof(BlockBinding); ++i)
+	{
+		Uint32 index = glGetUniformBlockIndex(mID, BLOCK_BINDINGS[i].mName);
+		if (index != GL_INVALID_INDEX)
+			glUniformBlockBinding(mID, index, BLOCK_BINDINGS[i].mBinding);
+	}
+
+	// Cache locations of uniforms that were set before linking
+	for (Uint32 i = 0; i < mUniforms.Size(); ++i)
+		mUniforms[i].mLocation = glGetUniformLocation(mID, sUniformNames[mUniforms[i].mHandle].c_str());
 
-	LOG_INFO << "Loaded shader " << fname << "\n";
+	LOG_INFO << "Loaded shader " << file << "\n";
 	return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-Uint32 Shader::LoadShader(const char* fname, Uint32 type)
+bool Shader::ReadShader(const char* fname, Uint32 type)
 {
 	// Read file
 	std::ifstream file(fname, std::ios::binary | std::ios::ate);
 	if (!file.is_open())
 	{
 		LOG_ERROR << "Could not find shader file named " << fname << "\n";
-		return 0;
+		return false;
 	}
 
 	// Get file size
 	Uint32 fsize = (Uint32)file.tellg();
 	file.seekg(0, std::ios::beg);
 
-	char* buffer = (char*)malloc(fsize + 1);
-	file.read(buffer, fsize);
-	buffer[fsize] = 0;
+	ShaderSource source;
+	source.mType = type;
+	source.mFile = fname;
+	source.mCode.resize(fsize);
+	file.read(&source.mCode[0], fsize);
 
 	file.close();
 
+	mSources.Push(std::move(source));
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Shader::CompileShader(const ShaderSource& source)
+{
+	const char* code = source.mCode.c_str();
 
 	// Create shader
 	Uint32 shader = 0;
-	shader = glCreateShader(type);
-	glShaderSource(shader, 1, &buffer, NULL);
+	shader = glCreateShader(source.mType);
+	glShaderSource(shader, 1, &code, NULL);
 	glCompileShader(shader);
 
-	// Free text buffer
-	free(buffer);
-
 	// Check status
 	int success;
 	char infoLog[512];
@@ -170,7 +254,7 @@ Uint32 Shader::LoadShader(const char* fname, Uint32 type)
 	if (!success)
 	{
 		glGetShaderInfoLog(shader, 512, NULL, infoLog);
-		LOG_ERROR << "Failed to compile " << fname << ":\n" << infoLog << "\n";
+		LOG_ERROR << "Failed to compile " << source.mFile << ":\n" << infoLog << "\n";
 		glDeleteShader(shader);
 		return 0;
 	}
@@ -186,91 +270,181 @@ void Shader::Bind()
 	sCurrentBound = mID;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+Int32 Shader::GetInstanceFormat() const
+{
+	return mInstanceFormat;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-Uniform& Shader::FindUniform(const char* name)
+UniformHandle Shader::GetUniformHandle(const char* name)
 {
-	// Linear search
-	for (Uint32 i = 0; i < mUniforms.Size(); ++i)
+	Uint32 hash = StringHash::Hash(name);
+
+	auto it = sUniformHandles.find(hash);
+	bool collision = it != sUniformHandles.end();
+	if (collision && sUniformNames[it->second] == name)
+		return it->second;
+
+	// The map only holds the first name of each hash, colliding names are found by comparing names (Collisions are rare)
+	if (collision)
 	{
-		// Depends on string literals having same pointer location for comparison
-		if (name == mUniforms[i].mName || strcmp(name, mUniforms[i].mName) == 0)
-			return mUniforms[i];
+		for (Uint32 i = 0; i < sUniformNames.Size(); ++i)
+		{
+			if (sUniformNames[i] == name)
+				return i;
+		}
+
+		LOG_WARNING << "Uniform names " << sUniformNames[it->second] << " and " << name << " have the same hash\n";
 	}
 
-	// Add new uniform
-	mUniforms.Push(Uniform(name));
+	// Register new uniform name
+	if (!sUniformNames.Capacity())
+		sUniformNames.Reserve(64);
+
+	UniformHandle handle = sUniformNames.Size();
+	sUniformNames.Push(std::string(name));
+	if (!collision)
+		sUniformHandles[hash] = handle;
 
-	return mUniforms.Back();
+	return handle;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+Uniform& Shader::GetUniform(UniformHandle handle)
+{
+	// Extend map to cover all handles registered so far
+	while (mHandleToIndex.Size() < sUniformNames.Size())
+		mHandleToIndex.Push(0);
+
+	Uint32& index = mHandleToIndex[handle];
+	if (!index)
+	{
+		// Add new uniform, location is cached when the program is linked
+		mUniforms.Push(Uniform(handle));
+		index = mUniforms.Size();
+
+		if (mID)
+			mUniforms.Back().mLocation = glGetUniformLocation(mID, sUniformNames[handle].c_str());
+	}
+
+	return mUniforms[index - 1];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void Shader::SetUniform(const char* name, int val)
 {
-	Uniform& uniform = FindUniform(name);
+	SetUniform(GetUniformHandle(name), val);
+}
+
+void Shader::SetUniform(const char* name, float val)
+{
+	SetUniform(GetUniformHandle(name), val);
+}
+
+void Shader::SetUniform(const char* name, const Vector2f& val)
+{
+	SetUniform(GetUniformHandle(name), val);
+}
+
+void Shader::SetUniform(const char* name, const Vector3f& val)
+{
+	SetUniform(GetUniformHandle(name), val);
+}
+
+void Shader::SetUniform(const char* name, const Vector4f& val)
+{
+	SetUniform(GetUniformHandle(name), val);
+}
+
+void Shader::SetUniform(const char* name, const Matrix2f& val)
+{
+	SetUniform(GetUniformHandle(name), val);
+}
+
+void Shader::SetUniform(const char* name, const Matrix3f& val)
+{
+	SetUniform(GetUniformHandle(name), val);
+}
+
+void Shader::SetUniform(const char* name, const Matrix4f& val)
+{
+	SetUniform(GetUniformHandle(name), val);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Shader::SetUniform(UniformHandle handle, int val)
+{
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Int;
 	uniform.mHasChanged = true;
 
 	*reinterpret_cast<int*>(uniform.mVariable) = val;
 }
 
-void Shader::SetUniform(const char* name, float val)
+void Shader::SetUniform(UniformHandle handle, float val)
 {
-	Uniform& uniform = FindUniform(name);
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Float;
 	uniform.mHasChanged = true;
 
 	*reinterpret_cast<float*>(uniform.mVariable) = val;
 }
 
-void Shader::SetUniform(const char* name, const Vector2f& val)
+void Shader::SetUniform(UniformHandle handle, const Vector2f& val)
 {
-	Uniform& uniform = FindUniform(name);
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Vec2;
 	uniform.mHasChanged = true;
 
 	*reinterpret_cast<Vector2f*>(uniform.mVariable) = val;
 }
 
-void Shader::SetUniform(const char* name, const Vector3f& val)
+void Shader::SetUniform(UniformHandle handle, const Vector3f& val)
 {
-	Uniform& uniform = FindUniform(name);
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Vec3;
 	uniform.mHasChanged = true;
 
 	*reinterpret_cast<Vector3f*>(uniform.mVariable) = val;
 }
 
-void Shader::SetUniform(const char* name, const Vector4f& val)
+void Shader::SetUniform(UniformHandle handle, const Vector4f& val)
 {
-	Uniform& uniform = FindUniform(name);
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Vec4;
 	uniform.mHasChanged = true;
 
 	*reinterpret_cast<Vector4f*>(uniform.mVariable) = val;
 }
 
-void Shader::SetUniform(const char* name, const Matrix2f& val)
+void Shader::SetUniform(UniformHandle handle, const Matrix2f& val)
 {
-	Uniform& uniform = FindUniform(name);
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Mat2;
 	uniform.mHasChanged = true;
 
 	*reinterpret_cast<Matrix2f*>(uniform.mVariable) = val;
 }
 
-void Shader::SetUniform(const char* name, const Matrix3f& val)
+void Shader::SetUniform(UniformHandle handle, const Matrix3f& val)
 {
-	Uniform& uniform = FindUniform(name);
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Mat3;
 	uniform.mHasChanged = true;
 
 	*reinterpret_cast<Matrix3f*>(uniform.mVariable) = val;
 }
 
-void Shader::SetUniform(const char* name, const Matrix4f& val)
+void Shader::SetUniform(UniformHandle handle, const Matrix4f& val)
 {
-	Uniform& uniform = FindUniform(name);
+	Uniform& uniform = GetUniform(handle);
 	uniform.mType = Uniform::Mat4;
 	uniform.mHasChanged = true;
 
@@ -290,7 +464,7 @@ void Shader::ApplyUniforms()
 		// Only set uniform if it has changed
 		if (uniform.mHasChanged)
 		{
-			int loc = glGetUniformLocation(mID, uniform.mName);
+			int loc = uniform.mLocation;
 			Uniform::Type type = (Uniform::Type)uniform.mType;
 			float* var = uniform.mVariable;
 
@@ -333,8 +507,9 @@ void Shader::ApplyUniforms()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-Uniform::Uniform(const char* name) :
-	mName		(name),
+Uniform::Uniform(UniformHandle handle) :
+	mLocation	(-1),
+	mHandle		(handle),
 	mType		(0),
 	mHasChanged	(false)
 {
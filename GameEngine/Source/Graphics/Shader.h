@@ -11,12 +11,20 @@
 
 #include <Resource/Loadable.h>
 
+#include <string>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Index of a uniform name, the same name maps to the same handle in every shader */
+typedef Uint32 UniformHandle;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 struct Uniform
 {
 	Uniform() = default;
-	Uniform(const char* name);
+	Uniform(UniformHandle handle);
 
 	enum Type
 	{
@@ -30,10 +38,12 @@ struct Uniform
 		Mat4
 	};
 
-	/* Uniform name */
-	const char* mName;
 	/* Storage for uniform variable */
 	float mVariable[16];
+	/* Uniform location (-1 if the shader doesn't use it) */
+	int mLocation;
+	/* Uniform name handle */
+	UniformHandle mHandle;
 	/* Uniform type */
 	Uint16 mType;
 
@@ -55,10 +65,17 @@ public:
 
 	/* Load shader from XML file */
 	bool Load(const char* fname);
+	/* Read XML file and shader sources without compiling (Thread safe) */
+	bool LoadData(const char* fname);
+	/* Compile and link loaded sources (Main thread only) */
+	bool Upload();
 
 	/* Bind shader */
 	void Bind();
 
+	/* Get handle of a uniform name (Resolve once and keep the handle, main thread only) */
+	static UniformHandle GetUniformHandle(const char* name);
+
 	/* Set shader uniform */
 	void SetUniform(const char* name, int val);
 	/* Set shader uniform */
@@ -75,22 +92,69 @@ public:
 	void SetUniform(const char* name, const Matrix3f& val);
 	/* Set shader uniform */
 	void SetUniform(const char* name, const Matrix4f& val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, int val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, float val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, const Vector2f& val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, const Vector3f& val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, const Vector4f& val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, const Matrix2f& val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, const Matrix3f& val);
+	/* Set shader uniform */
+	void SetUniform(UniformHandle handle, const Matrix4f& val);
 	/* Update all uniforms */
 	void ApplyUniforms();
 
+	/* Get instance transform format the program decodes (InstanceFormat::Type, -1 if it has no instance attributes) */
+	Int32 GetInstanceFormat() const;
+
+private:
+	/* Source of a shader stage */
+	struct ShaderSource
+	{
+		/* Shader type */
+		Uint32 mType;
+		/* Source file name */
+		std::string mFile;
+		/* Shader code */
+		std::string mCode;
+	};
+
 private:
-	/* Load shader code from file */
-	Uint32 LoadShader(const char* fname, Uint32 type);
-	/* Find uniform object */
-	Uniform& FindUniform(const char* name);
+	/* Read shader code from file */
+	bool ReadShader(const char* fname, Uint32 type);
+	/* Compile shader stage */
+	Uint32 CompileShader(const ShaderSource& source);
+	/* Get uniform object, adding it if the shader doesn't have it yet */
+	Uniform& GetUniform(UniformHandle handle);
 
 private:
 	/* Current bound shader */
 	static Uint32 sCurrentBound;
+	/* Map uniform name hashes to handles (First name registered with each hash, names are compared on lookup) */
+	static std::unordered_map<Uint32, UniformHandle> sUniformHandles;
+	/* Uniform names, indexed by handle */
+	static Array<std::string> sUniformNames;
 
 private:
-	/* Uniform map */
+	/* List of uniforms used by shader */
 	Array<Uniform> mUniforms;
+	/* Map uniform handles to index in uniform list plus one (0 if shader doesn't have the uniform) */
+	Array<Uint32> mHandleToIndex;
+	/* Stage sources waiting to be compiled */
+	Array<ShaderSource> mSources;
+	/* Transform feedback varyings waiting to be linked (Space separated) */
+	std::string mFeedback;
+	/* XML file name waiting to be logged after linking */
+	std::string mFile;
+	/* Instance transform format found after linking */
+	Int32 mInstanceFormat;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,190 @@
+#include <Graphics/StreamingBuffer.h>
+#include <Graphics/OpenGL.h>
+
+#include <Core/LogFile.h>
+
+#include <Resource/Resource.h>
+
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+StreamingBuffer::StreamingBuffer() :
+	mBuffer			(0),
+	mTarget			(VertexBuffer::Array),
+	mFrameSize		(0),
+	mAlign			(1),
+	mFrame			(0),
+	mFrameUsed		(0)
+{
+
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	for (Uint32 i = 0; i < mFences.Size(); ++i)
+	{
+		if (mFences[i])
+			glDeleteSync((GLsync)mFences[i]);
+	}
+
+	if (mBuffer)
+		Resource<VertexBuffer>::Free(mBuffer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void StreamingBuffer::Init(VertexBuffer::Target target, Uint32 frameSize, Uint32 numFrames)
+{
+	mTarget = target;
+	mFrameSize = frameSize;
+	mFences.Resize(numFrames, 0);
+
+	// Uniform buffer ranges must start at an implementation defined alignment
+	if (target == VertexBuffer::Uniform)
+	{
+		int align = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+		mAlign = align > 0 ? (Uint32)align : 256;
+	}
+
+	mBuffer = Resource<VertexBuffer>::Create();
+	mBuffer->Bind(mTarget);
+	mBuffer->BufferData(NULL, mFrameSize * numFrames, VertexBuffer::Stream);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void* StreamingBuffer::Map(Uint32 size, Uint32& offset, Uint32 align)
+{
+	// First write of the frame
+	if (!mFrameUsed)
+		WaitForRegion();
+
+	if (align < mAlign)
+		align = mAlign;
+
+	Uint32 start = (mFrameUsed + align - 1) & ~(align - 1);
+	if (start + size > mFrameSize)
+	{
+		Grow(size);
+		start = 0;
+	}
+
+	mFrameUsed = start + size;
+	offset = mFrame * mFrameSize + start;
+
+	// The fence guarantees the GPU is done with this region, so there is no need to synchronize
+	mBuffer->Bind(mTarget);
+	return mBuffer->MapWrite(size, VertexBuffer::Unsynchronized | VertexBuffer::InvalidateRange, offset);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StreamingBuffer::Unmap()
+{
+	mBuffer->Bind(mTarget);
+	mBuffer->Unmap();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 StreamingBuffer::Write(const void* data, Uint32 size, Uint32 align)
+{
+	Uint32 offset = 0;
+	void* ptr = Map(size, offset, align);
+
+	memcpy(ptr, data, size);
+	Unmap();
+
+	return offset;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StreamingBuffer::EndFrame()
+{
+	// Nothing was written, so the region isn't in use
+	if (!mFrameUsed) return;
+
+	mFences[mFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	mFrame = (mFrame + 1) % mFences.Size();
+	mFrameUsed = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StreamingBuffer::WaitForRegion()
+{
+	GLsync fence = (GLsync)mFences[mFrame];
+	if (!fence) return;
+
+	// Flush on the first wait so the fence is guaranteed to signal
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	GLenum result = GL_TIMEOUT_EXPIRED;
+
+	while (result == GL_TIMEOUT_EXPIRED)
+	{
+		result = glClientWaitSync(fence, flags, 1000000);
+		flags = 0;
+	}
+
+	glDeleteSync(fence);
+	mFences[mFrame] = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StreamingBuffer::Grow(Uint32 size)
+{
+	// Double region size until the request fits
+	Uint32 frameSize = mFrameSize ? mFrameSize * 2 : 1024;
+	while (frameSize < size)
+		frameSize *= 2;
+	mFrameSize = frameSize;
+
+	LOG_WARNING << "Streaming buffer is full, growing to " << mFrameSize << " bytes per frame\n";
+
+	// New storage isn't used by the GPU, old storage is kept alive by the driver until it is done
+	for (Uint32 i = 0; i < mFences.Size(); ++i)
+	{
+		if (mFences[i])
+			glDeleteSync((GLsync)mFences[i]);
+		mFences[i] = 0;
+	}
+
+	mBuffer->Bind(mTarget);
+	mBuffer->BufferData(NULL, mFrameSize * mFences.Size(), VertexBuffer::Stream);
+
+	mFrame = 0;
+	mFrameUsed = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void StreamingBuffer::Bind()
+{
+	mBuffer->Bind(mTarget);
+}
+
+void StreamingBuffer::Bind(Uint32 index, Uint32 offset, Uint32 size)
+{
+	mBuffer->Bind(mTarget, index, offset, size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+VertexBuffer* StreamingBuffer::GetBuffer() const
+{
+	return mBuffer;
+}
+
+Uint32 StreamingBuffer::GetFrameSize() const
+{
+	return mFrameSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef STREAMING_BUFFER_H
+#define STREAMING_BUFFER_H
+
+#include <Core/Array.h>
+
+#include <Graphics/VertexBuffer.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Default number of frames a streaming buffer is split into */
+#define STREAMING_BUFFER_FRAMES 3
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Buffer for data that is rewritten every frame. The buffer is split into one region per frame
+   and each region is fenced, so writes never wait on or overwrite data the GPU is still reading */
+class StreamingBuffer
+{
+public:
+	StreamingBuffer();
+	~StreamingBuffer();
+
+	StreamingBuffer(const StreamingBuffer& other) = delete;
+	StreamingBuffer& operator=(const StreamingBuffer& other) = delete;
+
+	/* Create buffer (Frame size is in bytes) */
+	void Init(VertexBuffer::Target target, Uint32 frameSize, Uint32 numFrames = STREAMING_BUFFER_FRAMES);
+
+	/* Map space in the current frame region (Unmap before drawing, offset in bytes is returned through offset).
+	   The buffer grows if the region is full, which drops anything written earlier in the frame */
+	void* Map(Uint32 size, Uint32& offset, Uint32 align = 16);
+	/* Unmap space */
+	void Unmap();
+	/* Copy data into the current frame region and return its offset in bytes */
+	Uint32 Write(const void* data, Uint32 size, Uint32 align = 16);
+	/* Fence current region and move to the next one (Call after all draws that use this frame's data) */
+	void EndFrame();
+
+	/* Bind buffer */
+	void Bind();
+	/* Bind part of buffer to an indexed target */
+	void Bind(Uint32 index, Uint32 offset, Uint32 size);
+
+	/* Get internal buffer */
+	VertexBuffer* GetBuffer() const;
+	/* Get size of a frame region in bytes */
+	Uint32 GetFrameSize() const;
+
+private:
+	/* Wait until the GPU is done with the current region */
+	void WaitForRegion();
+	/* Reallocate buffer with larger regions */
+	void Grow(Uint32 size);
+
+private:
+	/* Internal buffer */
+	VertexBuffer* mBuffer;
+	/* Buffer target */
+	VertexBuffer::Target mTarget;
+	/* Fence of each region (Null if region isn't in use) */
+	Array<void*> mFences;
+
+	/* Size of each region in bytes */
+	Uint32 mFrameSize;
+	/* Minimum offset alignment required by the target */
+	Uint32 mAlign;
+	/* Index of current region */
+	Uint32 mFrame;
+	/* Number of bytes used in current region */
+	Uint32 mFrameUsed;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
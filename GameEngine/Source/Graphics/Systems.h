@@ -12,7 +12,7 @@ class TransformMatrixSystem : public GameSystem
 {
 	TYPE_INFO(TransformMatrixSystem);
 
-	REQUIRES_COMPONENTS(
+	REQUIRES_COMPONENTS_PARALLEL(
 		TransformComponent,
 		RenderComponent
 	);
@@ -1,6 +1,7 @@
 #include <Graphics/Terrain.h>
 
 #include <Math/Rect.h>
+#include <Math/SIMD.h>
 
 #include <Resource/Resource.h>
 
@@ -12,9 +13,12 @@
 #include <Graphics/Shader.h>
 #include <Graphics/Image.h>
 #include <Graphics/Texture.h>
+#include <Graphics/TiledHeightMap.h>
 
 #include <Scene/Scene.h>
 
+#include <algorithm>
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -22,9 +26,86 @@ INIT_GAME_OBJECT(TerrainObject);
 
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace
+{
+	using namespace Simd;
+
+	/* Bilinearly sample the first channel of an image at world positions, clamped to edge like the GPU sampler.
+	   Index and weight math is vectorized, the four texels of each sample are gathered one lane at a time */
+	template <typename T>
+	void SampleImage(const Image* image, float size, float scale, const float* x, const float* z, Uint32 num, float* out)
+	{
+		const T* data = (const T*)image->GetData();
+		Uint32 w = image->GetWidth();
+		Uint32 h = image->GetHeight();
+		Uint32 c = image->GetNumChannels();
+		Uint32 stride = w * c;
+
+		// Map world position to texel space, texel centers are at half integers
+		VecF toU = SetF(w / size);
+		VecF toV = SetF(h / size);
+		VecF offsetU = SetF(0.5f * w - 0.5f);
+		VecF offsetV = SetF(0.5f * h - 0.5f);
+		VecF maxU = SetF((float)(w - 1));
+		VecF maxV = SetF((float)(h - 1));
+		// Lower texel of the pair stops one short of the edge, so the upper texel is always valid
+		VecF maxLowerU = SetF((float)(w - 2));
+		VecF maxLowerV = SetF((float)(h - 2));
+		VecF zero = SetF(0.0f);
+
+		float xs[SIMD_WIDTH], zs[SIMD_WIDTH];
+		Int32 cs[SIMD_WIDTH], rs[SIMD_WIDTH];
+		float h00[SIMD_WIDTH], h10[SIMD_WIDTH], h01[SIMD_WIDTH], h11[SIMD_WIDTH];
+		float result[SIMD_WIDTH];
+
+		for (Uint32 i = 0; i < num; i += SIMD_WIDTH)
+		{
+			Uint32 numLanes = std::min(num - i, (Uint32)SIMD_WIDTH);
+
+			// Last group is padded with the last position
+			for (Uint32 n = 0; n < SIMD_WIDTH; ++n)
+			{
+				Uint32 k = i + std::min(n, numLanes - 1);
+				xs[n] = x[k];
+				zs[n] = z[k];
+			}
+
+			VecF u = Min(Max(Add(Mul(LoadF(xs), toU), offsetU), zero), maxU);
+			VecF v = Min(Max(Add(Mul(LoadF(zs), toV), offsetV), zero), maxV);
+			VecI col = FastFloor(Min(u, maxLowerU));
+			VecI row = FastFloor(Min(v, maxLowerV));
+			VecF fu = Sub(u, ToFloat(col));
+			VecF fv = Sub(v, ToFloat(row));
+
+			StoreI(cs, col);
+			StoreI(rs, row);
+
+			for (Uint32 n = 0; n < SIMD_WIDTH; ++n)
+			{
+				const T* p = data + rs[n] * stride + cs[n] * c;
+				h00[n] = (float)p[0];
+				h10[n] = (float)p[c];
+				h01[n] = (float)p[stride];
+				h11[n] = (float)p[stride + c];
+			}
+
+			VecF top = Lerp(LoadF(h00), LoadF(h10), fu);
+			VecF bottom = Lerp(LoadF(h01), LoadF(h11), fu);
+			StoreF(result, Mul(Lerp(top, bottom, fv), SetF(scale)));
+
+			for (Uint32 n = 0; n < numLanes; ++n)
+				out[i + n] = result[n];
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 Terrain::Terrain() :
 	mSquareSize		(0.0f),
 	mHeightMap		(0),
+	mTiledHeightMap	(0),
+	mColorMap		(0),
 	mSize			(0.0f),
 	mMaxHeight		(10.0f)
 {
@@ -316,6 +397,10 @@ void Terrain::Create(Scene* scene)
 	float res = (1 << (mLodLevels.Size() - 1)) * mSquareSize;
 	shader->SetUniform("res", res);
 
+	// Single height map by default, samplers of different types can't share a texture unit so move the array sampler
+	shader->SetUniform("useTiles", 0);
+	shader->SetUniform("heightTiles", 15);
+
 	Material* material = Resource<Material>::Create();
 	material->mShader = shader;
 	material->mSpecular = Vector3f(0.05f);
@@ -386,6 +471,37 @@ void Terrain::SetHeightMap(Texture* texture)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void Terrain::SetHeightMap(TiledHeightMap* map)
+{
+	if (!mScene || mTiledHeightMap == map) return;
+
+	RenderComponent& r = *mScene->GetComponent<RenderComponent>(mObjectID);
+	Material* material = r.mModel->GetMesh(0).mMaterial;
+
+	mTiledHeightMap = map;
+	material->AddTexture(mTiledHeightMap->GetTileArray(), "heightTiles");
+	material->AddTexture(mTiledHeightMap->GetTileTable(), "tileTable");
+
+	Shader* shader = material->mShader;
+	shader->SetUniform("useTiles", 1);
+	shader->SetUniform("tileSize", mTiledHeightMap->GetTileSize());
+	shader->SetUniform("tileRes", (float)mTiledHeightMap->GetTileRes());
+	shader->SetUniform("tableSize", (float)mTiledHeightMap->GetTableSize());
+
+	// The unused single height map sampler needs its own texture unit
+	if (!mHeightMap)
+		shader->SetUniform("heightMap", 14);
+
+	// Tiled terrain is unbounded, so the color map repeats
+	if (mColorMap)
+	{
+		mColorMap->Bind();
+		mColorMap->SetWrap(Texture::Repeat);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void Terrain::SetColorMap(Texture* texture)
 {
 	if (!mScene) return;
@@ -397,7 +513,7 @@ void Terrain::SetColorMap(Texture* texture)
 
 		mColorMap = texture;
 		mColorMap->Bind();
-		mColorMap->SetWrap(Texture::ClampToEdge);
+		mColorMap->SetWrap(mTiledHeightMap ? Texture::Repeat : Texture::ClampToEdge);
 		mColorMap->SetFilter(Texture::Linear);
 		r.mModel->GetMesh(0).mMaterial->AddTexture(mColorMap, "colorMap");
 	}
@@ -426,9 +542,234 @@ Texture* Terrain::GetHeightMap() const
 	return mHeightMap;
 }
 
+TiledHeightMap* Terrain::GetTiledHeightMap() const
+{
+	return mTiledHeightMap;
+}
+
 Texture* Terrain::GetColorMap() const
 {
 	return mColorMap;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+float Terrain::GetHeight(float x, float z) const
+{
+	float h;
+	SampleHeights(&x, &z, 1, &h);
+	return h;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Vector3f Terrain::GetNormal(float x, float z) const
+{
+	Vector3f n;
+	Vector2f p(x, z);
+	GetNormals(&p, 1, &n);
+	return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Terrain::Raycast(const Vector3f& origin, const Vector3f& dir, float maxDist, float& dist) const
+{
+	return Raycast(&origin, &dir, 1, maxDist, &dist) > 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Terrain::GetHeights(const Vector2f* points, Uint32 num, float* out) const
+{
+	// Points are split into x and z lists in blocks on the stack (Queries can run on any thread, so no frame memory)
+	float x[TERRAIN_QUERY_BLOCK], z[TERRAIN_QUERY_BLOCK];
+
+	for (Uint32 i = 0; i < num; i += TERRAIN_QUERY_BLOCK)
+	{
+		Uint32 size = std::min(num - i, (Uint32)TERRAIN_QUERY_BLOCK);
+
+		for (Uint32 n = 0; n < size; ++n)
+		{
+			x[n] = points[i + n].x;
+			z[n] = points[i + n].y;
+		}
+
+		SampleHeights(x, z, size, out + i);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Terrain::GetNormals(const Vector2f* points, Uint32 num, Vector3f* out) const
+{
+	float e = GetSampleSpacing();
+
+	// Central differences, the four neighbours of each point in a block are sampled in one batch
+	float x[4 * TERRAIN_QUERY_BLOCK], z[4 * TERRAIN_QUERY_BLOCK], h[4 * TERRAIN_QUERY_BLOCK];
+
+	for (Uint32 i = 0; i < num; i += TERRAIN_QUERY_BLOCK)
+	{
+		Uint32 size = std::min(num - i, (Uint32)TERRAIN_QUERY_BLOCK);
+
+		for (Uint32 n = 0; n < size; ++n)
+		{
+			const Vector2f& p = points[i + n];
+			float* px = x + 4 * n;
+			float* pz = z + 4 * n;
+
+			px[0] = p.x - e;	pz[0] = p.y;
+			px[1] = p.x + e;	pz[1] = p.y;
+			px[2] = p.x;		pz[2] = p.y - e;
+			px[3] = p.x;		pz[3] = p.y + e;
+		}
+
+		SampleHeights(x, z, 4 * size, h);
+
+		for (Uint32 n = 0; n < size; ++n)
+		{
+			const float* s = h + 4 * n;
+			out[i + n] = Normalize(Vector3f(s[0] - s[1], 2.0f * e, s[2] - s[3]));
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Terrain::Raycast(const Vector3f* origins, const Vector3f* dirs, Uint32 num, float maxDist, float* dists) const
+{
+	// Half a texel per step, so features of the height map can't be stepped over
+	float step = 0.5f * GetSampleSpacing();
+	Uint32 numSteps = (Uint32)ceil(maxDist / step);
+	Uint32 numHits = 0;
+
+	float ox[SIMD_WIDTH], oy[SIMD_WIDTH], oz[SIMD_WIDTH];
+	float dx[SIMD_WIDTH], dy[SIMD_WIDTH], dz[SIMD_WIDTH];
+	float px[SIMD_WIDTH], pz[SIMD_WIDTH], h[SIMD_WIDTH];
+	float lo[SIMD_WIDTH], hi[SIMD_WIDTH];
+
+	for (Uint32 i = 0; i < num; i += SIMD_WIDTH)
+	{
+		Uint32 numLanes = std::min(num - i, (Uint32)SIMD_WIDTH);
+
+		// Last group is padded with the last ray
+		for (Uint32 n = 0; n < SIMD_WIDTH; ++n)
+		{
+			Uint32 k = i + std::min(n, numLanes - 1);
+			ox[n] = origins[k].x;	oy[n] = origins[k].y;	oz[n] = origins[k].z;
+			dx[n] = dirs[k].x;		dy[n] = dirs[k].y;		dz[n] = dirs[k].z;
+		}
+
+		VecF vox = LoadF(ox), voy = LoadF(oy), voz = LoadF(oz);
+		VecF vdx = LoadF(dx), vdy = LoadF(dy), vdz = LoadF(dz);
+
+		// March all lanes until every ray is below the terrain or out of range
+		int active = (1 << SIMD_WIDTH) - 1;
+		int hits = 0;
+		for (Uint32 s = 0; s <= numSteps && active; ++s)
+		{
+			float t = std::min(s * step, maxDist);
+			VecF vt = SetF(t);
+
+			StoreF(px, Add(vox, Mul(vdx, vt)));
+			StoreF(pz, Add(voz, Mul(vdz, vt)));
+			SampleHeights(px, pz, SIMD_WIDTH, h);
+
+			int below = MoveMask(CmpLe(Add(voy, Mul(vdy, vt)), LoadF(h))) & active;
+			for (Uint32 n = 0; n < SIMD_WIDTH; ++n)
+			{
+				if (!(below & (1 << n))) continue;
+
+				// Hit is between the previous and current step
+				lo[n] = std::max(t - step, 0.0f);
+				hi[n] = t;
+			}
+
+			hits |= below;
+			active &= ~below;
+		}
+
+		// Refine hits by bisection
+		if (hits)
+		{
+			for (Uint32 n = 0; n < SIMD_WIDTH; ++n)
+			{
+				if (hits & (1 << n)) continue;
+				lo[n] = 0.0f;
+				hi[n] = 0.0f;
+			}
+
+			VecF vlo = LoadF(lo), vhi = LoadF(hi);
+			for (Uint32 iter = 0; iter < 8; ++iter)
+			{
+				VecF mid = Mul(Add(vlo, vhi), SetF(0.5f));
+
+				StoreF(px, Add(vox, Mul(vdx, mid)));
+				StoreF(pz, Add(voz, Mul(vdz, mid)));
+				SampleHeights(px, pz, SIMD_WIDTH, h);
+
+				VecF below = CmpLe(Add(voy, Mul(vdy, mid)), LoadF(h));
+				vhi = Select(below, mid, vhi);
+				vlo = Select(below, vlo, mid);
+			}
+			StoreF(hi, vhi);
+		}
+
+		for (Uint32 n = 0; n < numLanes; ++n)
+		{
+			bool hit = (hits & (1 << n)) != 0;
+			dists[i + n] = hit ? hi[n] : -1.0f;
+			numHits += hit;
+		}
+	}
+
+	return numHits;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Terrain::SampleHeights(const float* x, const float* z, Uint32 num, float* out) const
+{
+	if (mTiledHeightMap)
+	{
+		// Terrain queries need real heights, so wait for tiles that are still generating
+		mTiledHeightMap->GetHeights(x, z, num, out, true);
+		for (Uint32 i = 0; i < num; ++i)
+			out[i] *= mMaxHeight;
+
+		return;
+	}
+
+	Image* image = mHeightMap ? mHeightMap->GetImage() : 0;
+
+	// No CPU copy of the height map
+	if (!image || !image->GetData() || image->GetWidth() < 2 || image->GetHeight() < 2)
+	{
+		for (Uint32 i = 0; i < num; ++i)
+			out[i] = 0.0f;
+
+		return;
+	}
+
+	// Integer formats are normalized, like they are on the GPU
+	if (image->GetDataType() == Image::Float)
+		SampleImage<float>(image, mSize, mMaxHeight, x, z, num, out);
+	else if (image->GetDataType() == Image::Ushort)
+		SampleImage<Uint16>(image, mSize, mMaxHeight / 65535.0f, x, z, num, out);
+	else
+		SampleImage<Uint8>(image, mSize, mMaxHeight / 255.0f, x, z, num, out);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+float Terrain::GetSampleSpacing() const
+{
+	if (mTiledHeightMap)
+		return mTiledHeightMap->GetTileSize() / (mTiledHeightMap->GetTileRes() - 1);
+
+	Image* image = mHeightMap ? mHeightMap->GetImage() : 0;
+	return image && image->GetWidth() ? mSize / image->GetWidth() : 1.0f;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -10,9 +10,13 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Number of points batched terrain queries process at a time */
+#define TERRAIN_QUERY_BLOCK 64
+
 class Texture;
 class Image;
 class Scene;
+class TiledHeightMap;
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -50,7 +54,9 @@ public:
 	void SetMaxHeight(float h);
 	/* Set height map */
 	void SetHeightMap(Texture* map);
-	/* Set color map */
+	/* Set tiled height map (Used instead of the single height map, so terrain isn't bounded by its size) */
+	void SetHeightMap(TiledHeightMap* map);
+	/* Set color map (Repeats outside the terrain size with a tiled height map) */
 	void SetColorMap(Texture* map);
 
 	/* Get terrain size */
@@ -61,9 +67,31 @@ public:
 	float GetMaxHeight() const;
 	/* Get terrain height map */
 	Texture* GetHeightMap() const;
+	/* Get tiled height map */
+	TiledHeightMap* GetTiledHeightMap() const;
 	/* Get terrain color map */
 	Texture* GetColorMap() const;
 
+	/* Get bilinearly filtered terrain height at position (Reads the CPU copy of the height map, queries of a tiled height map wait for missing tiles to generate) */
+	float GetHeight(float x, float z) const;
+	/* Get terrain normal at position */
+	Vector3f GetNormal(float x, float z) const;
+	/* Find distance along a ray (Normalized direction) to the terrain, returns false if it isn't hit within max distance */
+	bool Raycast(const Vector3f& origin, const Vector3f& dir, float maxDist, float& dist) const;
+
+	/* Get terrain heights at a list of (x, z) positions */
+	void GetHeights(const Vector2f* points, Uint32 num, float* out) const;
+	/* Get terrain normals at a list of (x, z) positions */
+	void GetNormals(const Vector2f* points, Uint32 num, Vector3f* out) const;
+	/* Raycast a list of rays, hit distances are written to dists (-1 for a miss). Returns number of hits */
+	Uint32 Raycast(const Vector3f* origins, const Vector3f* dirs, Uint32 num, float maxDist, float* dists) const;
+
+private:
+	/* Get heights at positions given as separate x and z lists (With a tiled height map, blocks until the tiles are generated) */
+	void SampleHeights(const float* x, const float* z, Uint32 num, float* out) const;
+	/* Get distance between height samples in world units */
+	float GetSampleSpacing() const;
+
 private:
 	/* ID of terrain object */
 	GameObjectID mObjectID;
@@ -76,6 +104,8 @@ private:
 
 	/* Height map */
 	Texture* mHeightMap;
+	/* Tiled height map */
+	TiledHeightMap* mTiledHeightMap;
 	/* Color map */
 	Texture* mColorMap;
 	/* Size of terrain (square) */
@@ -74,8 +74,8 @@ void Texture::Create(Uint32 format, Uint32 dtype, Uint32 w, Uint32 h, Uint32 d)
 
 	if (mDimensions == _2D)
 		glTexImage2D(GL_TEXTURE_2D, 0, internalFmt, w, h, 0, format, dtype, 0);
-	else if (mDimensions == _3D)
-		glTexImage3D(GL_TEXTURE_3D, 0, internalFmt, w, h, d, 0, format, dtype, 0);
+	else if (mDimensions == _3D || mDimensions == _2DArray)
+		glTexImage3D(mDimensions, 0, internalFmt, w, h, d, 0, format, dtype, 0);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -151,6 +151,68 @@ void Texture::SetSubImage(Image* image, Uint32 x, Uint32 y)
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void Texture::SetSubImage(Image* image, Uint32 x, Uint32 y, Uint32 z)
+{
+	assert(sCurrentBound == mID);
+
+	void* data = image->GetData();
+	Uint32 w = image->GetWidth();
+	Uint32 h = image->GetHeight();
+	Uint32 c = image->GetNumChannels();
+
+	// This function only usable with 3D and array textures
+	if (!data || (mDimensions != _3D && mDimensions != _2DArray)) return;
+
+	Uint32 format = GL_RED;
+	if (c == 2)
+		format = GL_RG;
+	else if (c == 3)
+		format = GL_RGB;
+	else if (c == 4)
+		format = GL_RGBA;
+	else if (c != 1)
+		return;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(mDimensions, 0, x, y, z, w, h, 1, format, image->GetDataType(), data);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Texture::UpdateRegion(Uint32 x, Uint32 y, Uint32 w, Uint32 h)
+{
+	assert(sCurrentBound == mID);
+
+	// This function only usable with 2D images
+	if (!mImage || !mImage->GetData() || mDimensions != _2D) return;
+
+	Uint32 c = mImage->GetNumChannels();
+
+	Uint32 format = GL_RED;
+	if (c == 2)
+		format = GL_RG;
+	else if (c == 3)
+		format = GL_RGB;
+	else if (c == 4)
+		format = GL_RGBA;
+	else if (c != 1)
+		return;
+
+	// Read the region out of the full image rows
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, mImage->GetWidth());
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, format, mImage->GetDataType(), mImage->GetData());
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void Texture::SetWrap(Wrap wrap)
 {
 	assert(sCurrentBound == mID);
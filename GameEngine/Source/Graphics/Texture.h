@@ -37,9 +37,10 @@ public:
 
 	enum Dimensions
 	{
-		_1D	= 0x0DE0,
-		_2D	= 0x0DE1,
-		_3D	= 0x806F
+		_1D			= 0x0DE0,
+		_2D			= 0x0DE1,
+		_3D			= 0x806F,
+		_2DArray	= 0x8C1A
 	};
 
 public:
@@ -55,6 +56,10 @@ public:
 	void SetImage(Image* image, bool mipmap = false, Uint32 format = 0);
 	/* Set subregion of image */
 	void SetSubImage(Image* image, Uint32 x, Uint32 y);
+	/* Set subregion of a 3D texture slice or array texture layer */
+	void SetSubImage(Image* image, Uint32 x, Uint32 y, Uint32 z);
+	/* Upload a region of the source image to the same region of the texture (2D only) */
+	void UpdateRegion(Uint32 x, Uint32 y, Uint32 w, Uint32 h);
 	/* Set texture wrap */
 	void SetWrap(Wrap wrap);
 	/* Set texture filter */
@@ -0,0 +1,576 @@
+#include <Graphics/TiledHeightMap.h>
+
+#include <Resource/Resource.h>
+
+#include <Graphics/Texture.h>
+
+#include <Scene/Scene.h>
+
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TiledHeightMap::TiledHeightMap(float f, float a, float l, float p) :
+	mGenerator		(f, a, l, p),
+	mSeed			(0.0f),
+	mOctaves		(5),
+	mTileRes		(DEFAULT_TILE_RES),
+	mTileSize		(256.0f),
+	mViewRadius		(2),
+	mMemoryLimit	(DEFAULT_TILE_MEMORY),
+	mMaxUploads		(DEFAULT_TILE_UPLOADS),
+	mFront			(0),
+	mBack			(0),
+	mMemoryUsed		(0),
+	mTileArray		(0),
+	mTileTable		(0),
+	mCenter			(0),
+	mTableDirty		(false)
+{
+	mSeed.x = (float)(rand() / (float)RAND_MAX) * 10000.0f - 5000.0f;
+	mSeed.y = (float)(rand() / (float)RAND_MAX) * 10000.0f - 5000.0f;
+}
+
+TiledHeightMap::~TiledHeightMap()
+{
+	for (auto it = mTiles.begin(); it != mTiles.end(); ++it)
+	{
+		// Generation jobs hold a pointer to the tile
+		JobSystem::Wait(&it->second->mCounter);
+		delete it->second;
+	}
+
+	if (mTileArray)
+		Resource<Texture>::Free(mTileArray);
+	if (mTileTable)
+		Resource<Texture>::Free(mTileTable);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::Create()
+{
+	Uint32 tableSize = GetTableSize();
+	Uint32 numLayers = tableSize * tableSize;
+
+	// Texture array with a layer for every tile in view
+	mTileArray = Resource<Texture>::Create();
+	mTileArray->SetDimensions(Texture::_2DArray);
+	mTileArray->Bind();
+	mTileArray->Create(Texture::Red, Image::Float, mTileRes, mTileRes, numLayers);
+	mTileArray->SetWrap(Texture::ClampToEdge);
+	mTileArray->SetFilter(Texture::Linear);
+
+	// Table starts out empty (Layer of -1)
+	float* table = (float*)malloc(numLayers * 3 * sizeof(float));
+	for (Uint32 i = 0; i < numLayers; ++i)
+	{
+		table[3 * i + 0] = -1.0f;
+		table[3 * i + 1] = 0.0f;
+		table[3 * i + 2] = 0.0f;
+	}
+	mTableImage.SetData(table, tableSize, tableSize, 3, Image::Float);
+
+	// Create with a float format so layer and tile indices aren't normalized
+	mTileTable = Resource<Texture>::Create();
+	mTileTable->Bind();
+	mTileTable->Create(Texture::Rgb, Image::Float, tableSize, tableSize);
+	mTileTable->SetSubImage(&mTableImage, 0, 0);
+	mTileTable->SetWrap(Texture::Repeat);
+	mTileTable->SetFilter(Texture::Nearest);
+
+	// All layers are free
+	mLayers.Reserve(numLayers);
+	mFreeLayers.Reserve(numLayers);
+	for (Uint32 i = 0; i < numLayers; ++i)
+	{
+		mLayers.Push(0);
+		mFreeLayers.Push(numLayers - i - 1);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::Update(const Vector2f& pos)
+{
+	if (!mTileArray) return;
+
+	Vector2i center = GetTileIndex(pos);
+	Int32 radius = (Int32)mViewRadius;
+
+	// Release layers of tiles that left the view
+	if (center.x != mCenter.x || center.y != mCenter.y)
+	{
+		for (Uint32 i = 0; i < mLayers.Size(); ++i)
+		{
+			HeightTile* tile = mLayers[i];
+			if (!tile) continue;
+
+			if (abs(tile->mIndex.x - center.x) > radius || abs(tile->mIndex.y - center.y) > radius)
+				ReleaseLayer(tile);
+		}
+
+		mCenter = center;
+	}
+
+	// Request tiles in view, closest rings first so they are generated and uploaded first
+	Uint32 numUploads = 0;
+	for (Int32 ring = 0; ring <= radius; ++ring)
+	{
+		for (Int32 r = -ring; r <= ring; ++r)
+		{
+			for (Int32 c = -ring; c <= ring; ++c)
+			{
+				// Only visit the border of the ring
+				if (abs(r) != ring && abs(c) != ring) continue;
+
+				HeightTile* tile = GetTile(Vector2i(center.x + c, center.y + r));
+				if (tile && tile->mLayer < 0 && numUploads < mMaxUploads)
+				{
+					UploadTile(tile);
+					++numUploads;
+				}
+			}
+		}
+	}
+
+	// Upload table
+	if (mTableDirty)
+	{
+		mTileTable->Bind();
+		mTileTable->SetSubImage(&mTableImage, 0, 0);
+		mTableDirty = false;
+	}
+
+	// Stay under memory limit
+	EvictTiles();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+HeightTile* TiledHeightMap::GetTile(const Vector2i& index)
+{
+	HeightTile* tile = 0;
+	bool created = false;
+
+	{
+		Lock lock(mTileMutex);
+		tile = RequestTile(index, created);
+	}
+
+	if (created)
+		GenerateTile(tile);
+
+	return tile->mReady.load(std::memory_order_acquire) ? tile : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+HeightTile* TiledHeightMap::RequestTile(const Vector2i& index, bool& created)
+{
+	HeightTile*& tile = mTiles[GetTileKey(index)];
+
+	created = !tile;
+	if (created)
+	{
+		tile = new HeightTile();
+		tile->mIndex = index;
+		mMemoryUsed += mTileRes * mTileRes * sizeof(float);
+	}
+
+	Touch(tile);
+
+	return tile;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::GenerateTile(HeightTile* tile)
+{
+	// Tile can't be evicted until it is ready, so it stays valid after the lock is released
+	GenerateJobData data;
+	data.mMap = this;
+	data.mTile = tile;
+	JobSystem::Run(&TiledHeightMap::GenerateJob, &data, sizeof(data), &tile->mCounter);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Vector2i TiledHeightMap::GetTileIndex(const Vector2f& pos) const
+{
+	return Floor(pos / mTileSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TiledHeightMap::GetHeights(const float* x, const float* z, Uint32 num, float* out, bool wait)
+{
+	// Unique tiles used by the current batch (Points are usually close together, so there are only a few)
+	HeightTile* tiles[HEIGHT_QUERY_MAX_TILES];
+	HeightTile* created[HEIGHT_QUERY_MAX_TILES];
+	bool ready = true;
+
+	for (Uint32 start = 0; start < num;)
+	{
+		Uint32 numTiles = 0;
+		Uint32 numCreated = 0;
+		Uint32 end = start;
+
+		{
+			Lock lock(mTileMutex);
+
+			HeightTile* tile = 0;
+			for (; end < num; ++end)
+			{
+				Vector2i index = GetTileIndex(Vector2f(x[end], z[end]));
+				if (tile && tile->mIndex.x == index.x && tile->mIndex.y == index.y) continue;
+
+				Uint32 n = 0;
+				for (; n < numTiles && (tiles[n]->mIndex.x != index.x || tiles[n]->mIndex.y != index.y); ++n);
+
+				if (n == numTiles)
+				{
+					// Batch is full, remaining points go in the next one
+					if (numTiles == HEIGHT_QUERY_MAX_TILES) break;
+
+					bool isNew = false;
+					tiles[numTiles++] = RequestTile(index, isNew);
+					if (isNew)
+						created[numCreated++] = tiles[n];
+
+					// Keep tile from being evicted until the batch is done
+					++tiles[n]->mNumReaders;
+				}
+
+				tile = tiles[n];
+			}
+		}
+
+		// Submit generation jobs without holding the lock
+		for (Uint32 i = 0; i < numCreated; ++i)
+			GenerateTile(created[i]);
+
+		if (!SampleTiles(x + start, z + start, end - start, out + start, tiles, numTiles, wait))
+			ready = false;
+
+		Lock lock(mTileMutex);
+		for (Uint32 i = 0; i < numTiles; ++i)
+			--tiles[i]->mNumReaders;
+
+		start = end;
+	}
+
+	return ready;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TiledHeightMap::SampleTiles(const float* x, const float* z, Uint32 num, float* out, HeightTile** tiles, Uint32 numTiles, bool wait)
+{
+	bool isReady[HEIGHT_QUERY_MAX_TILES];
+	bool ready = true;
+
+	for (Uint32 i = 0; i < numTiles; ++i)
+	{
+		// Only block when the caller asked to, running other jobs in the meantime
+		if (wait)
+		{
+			while (!tiles[i]->mReady.load(std::memory_order_acquire))
+			{
+				if (!JobSystem::RunJob())
+					std::this_thread::yield();
+			}
+		}
+
+		isReady[i] = tiles[i]->mReady.load(std::memory_order_acquire);
+		ready = ready && isReady[i];
+	}
+
+	float toTexel = (float)(mTileRes - 1) / mTileSize;
+	Int32 maxIndex = (Int32)mTileRes - 2;
+
+	Uint32 t = 0;
+	for (Uint32 i = 0; i < num; ++i)
+	{
+		Vector2i index = GetTileIndex(Vector2f(x[i], z[i]));
+
+		// Find tile of point
+		for (Uint32 n = 0; tiles[t]->mIndex.x != index.x || tiles[t]->mIndex.y != index.y; ++n)
+			t = n;
+
+		// Fallback height until the tile is generated
+		if (!isReady[t])
+		{
+			out[i] = 0.0f;
+			continue;
+		}
+
+		const HeightTile* tile = tiles[t];
+		const float* heights = (const float*)tile->mImage.GetData();
+
+		// Edge texels are shared with neighbouring tiles, so a tile spans (res - 1) texels
+		float u = x[i] * toTexel - tile->mIndex.x * (float)(mTileRes - 1);
+		float v = z[i] * toTexel - tile->mIndex.y * (float)(mTileRes - 1);
+		Int32 c = std::min(std::max((Int32)u, 0), maxIndex);
+		Int32 r = std::min(std::max((Int32)v, 0), maxIndex);
+		float fu = u - c;
+		float fv = v - r;
+
+		const float* p = heights + r * mTileRes + c;
+		float top = p[0] + (p[1] - p[0]) * fu;
+		float bottom = p[mTileRes] + (p[mTileRes + 1] - p[mTileRes]) * fu;
+		out[i] = top + (bottom - top) * fv;
+	}
+
+	return ready;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::Touch(HeightTile* tile)
+{
+	if (mFront == tile) return;
+
+	Unlink(tile);
+
+	// Add to front
+	tile->mNext = mFront;
+	if (mFront)
+		mFront->mPrev = tile;
+	mFront = tile;
+
+	if (!mBack)
+		mBack = tile;
+}
+
+void TiledHeightMap::Unlink(HeightTile* tile)
+{
+	if (tile->mPrev)
+		tile->mPrev->mNext = tile->mNext;
+	else if (mFront == tile)
+		mFront = tile->mNext;
+
+	if (tile->mNext)
+		tile->mNext->mPrev = tile->mPrev;
+	else if (mBack == tile)
+		mBack = tile->mPrev;
+
+	tile->mPrev = 0;
+	tile->mNext = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::EvictTiles()
+{
+	Lock lock(mTileMutex);
+
+	HeightTile* tile = mBack;
+
+	while (tile && mMemoryUsed > mMemoryLimit)
+	{
+		HeightTile* prev = tile->mPrev;
+
+		// Resident, generating, and queried tiles are still in use
+		if (tile->mLayer < 0 && tile->mReady.load(std::memory_order_acquire) && !tile->mNumReaders)
+		{
+			Unlink(tile);
+			mTiles.erase(GetTileKey(tile->mIndex));
+			mMemoryUsed -= mTileRes * mTileRes * sizeof(float);
+
+			delete tile;
+		}
+
+		tile = prev;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::UploadTile(HeightTile* tile)
+{
+	if (!mFreeLayers.Size()) return;
+
+	Int32 layer = mFreeLayers.Back();
+	mFreeLayers.Pop();
+
+	tile->mLayer = layer;
+	mLayers[layer] = tile;
+
+	mTileArray->Bind();
+	mTileArray->SetSubImage(&tile->mImage, 0, 0, layer);
+
+	// Tile table is indexed by tile index modulo its size, so entries don't move when the camera does
+	Int32 tableSize = (Int32)GetTableSize();
+	Int32 x = ((tile->mIndex.x % tableSize) + tableSize) % tableSize;
+	Int32 y = ((tile->mIndex.y % tableSize) + tableSize) % tableSize;
+
+	float* entry = (float*)mTableImage.GetData() + 3 * (y * tableSize + x);
+	entry[0] = (float)layer;
+	entry[1] = (float)tile->mIndex.x;
+	entry[2] = (float)tile->mIndex.y;
+	mTableDirty = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::ReleaseLayer(HeightTile* tile)
+{
+	Int32 tableSize = (Int32)GetTableSize();
+	Int32 x = ((tile->mIndex.x % tableSize) + tableSize) % tableSize;
+	Int32 y = ((tile->mIndex.y % tableSize) + tableSize) % tableSize;
+
+	// Clear table entry if it still belongs to this tile
+	float* entry = (float*)mTableImage.GetData() + 3 * (y * tableSize + x);
+	if (entry[0] == (float)tile->mLayer)
+	{
+		entry[0] = -1.0f;
+		mTableDirty = true;
+	}
+
+	mLayers[tile->mLayer] = 0;
+	mFreeLayers.Push(tile->mLayer);
+	tile->mLayer = -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::GenerateJob(void* data)
+{
+	GenerateJobData* job = (GenerateJobData*)data;
+	TiledHeightMap* map = job->mMap;
+	HeightTile* tile = job->mTile;
+
+	Uint32 res = map->mTileRes;
+	float* heights = (float*)malloc(res * res * sizeof(float));
+
+	// Neighbouring tiles share edge texels, so a tile spans (res - 1) noise units
+	Vector2f start = Vector2f((float)tile->mIndex.x, (float)tile->mIndex.y) * (float)(res - 1) + map->mSeed;
+
+	for (Uint32 r = 0; r < res; ++r)
+	{
+		float* row = heights + r * res;
+		map->mGenerator.EvaluateRow(map->mOctaves, start.x, start.y + r, 1.0f, res, row);
+
+		for (Uint32 c = 0; c < res; ++c)
+			row[c] = row[c] * 0.5f + 0.5f;
+	}
+
+	tile->mImage.SetData(heights, res, res, 1, Image::Float);
+
+	// Publish heights to queries on other threads
+	tile->mReady.store(true, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint64 TiledHeightMap::GetTileKey(const Vector2i& index)
+{
+	return ((Uint64)(Uint32)index.x << 32) | (Uint32)index.y;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMap::SetTileSize(Uint32 res, float size)
+{
+	mTileRes = res;
+	mTileSize = size;
+}
+
+void TiledHeightMap::SetOctaves(Uint32 octaves)
+{
+	mOctaves = octaves;
+}
+
+void TiledHeightMap::SetViewRadius(Uint32 radius)
+{
+	mViewRadius = radius;
+}
+
+void TiledHeightMap::SetMemoryLimit(Uint32 bytes)
+{
+	mMemoryLimit = bytes;
+}
+
+void TiledHeightMap::SetMaxUploads(Uint32 num)
+{
+	mMaxUploads = num;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Texture* TiledHeightMap::GetTileArray() const
+{
+	return mTileArray;
+}
+
+Texture* TiledHeightMap::GetTileTable() const
+{
+	return mTileTable;
+}
+
+Uint32 TiledHeightMap::GetTileRes() const
+{
+	return mTileRes;
+}
+
+float TiledHeightMap::GetTileSize() const
+{
+	return mTileSize;
+}
+
+Uint32 TiledHeightMap::GetTableSize() const
+{
+	return 2 * mViewRadius + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TiledHeightMapSystem::TiledHeightMapSystem() :
+	mHeightMap		(0)
+{
+
+}
+
+TiledHeightMapSystem::~TiledHeightMapSystem()
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMapSystem::OnInit()
+{
+	// Tiles are uploaded to the GPU
+	SetMainThread(true);
+}
+
+bool TiledHeightMapSystem::MatchesTags(const std::unordered_set<Uint32>& set)
+{
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMapSystem::SetHeightMap(TiledHeightMap* map)
+{
+	mHeightMap = map;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void TiledHeightMapSystem::Update(float dt)
+{
+	if (!mHeightMap) return;
+
+	const Vector3f& p = mScene->GetCamera().GetPosition();
+	mHeightMap->Update(Vector2f(p.x, p.z));
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
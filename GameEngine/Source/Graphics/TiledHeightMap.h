@@ -0,0 +1,222 @@
+#ifndef TILED_HEIGHT_MAP_H
+#define TILED_HEIGHT_MAP_H
+
+#include <Core/DataTypes.h>
+#include <Core/Array.h>
+#include <Core/JobSystem.h>
+#include <Core/Thread.h>
+
+#include <Math/Vector2.h>
+#include <Math/Noise.h>
+
+#include <Graphics/Image.h>
+
+#include <Scene/GameSystem.h>
+
+#include <unordered_map>
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Default number of texels along each side of a tile */
+#define DEFAULT_TILE_RES 129
+/* Default maximum amount of memory used by cached tiles (in bytes) */
+#define DEFAULT_TILE_MEMORY (64 * 1024 * 1024)
+/* Default maximum number of tiles uploaded to the GPU each frame */
+#define DEFAULT_TILE_UPLOADS 2
+/* Maximum number of unique tiles a height query holds at once (Larger queries are split into batches) */
+#define HEIGHT_QUERY_MAX_TILES 8
+
+class Texture;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Square tile of heights in range [0, 1] (Edge texels are shared with neighbouring tiles) */
+struct HeightTile
+{
+	HeightTile() :
+		mIndex			(0),
+		mReady			(false),
+		mLayer			(-1),
+		mNumReaders		(0),
+		mPrev			(0),
+		mNext			(0)
+	{ }
+
+	/* Tile coordinates */
+	Vector2i mIndex;
+	/* Height data (Float, 1 channel) */
+	Image mImage;
+	/* Keeps track of generation job */
+	JobCounter mCounter;
+	/* Set by the generation job once height data can be read */
+	std::atomic<bool> mReady;
+	/* Texture array layer the tile is uploaded to (-1 if not resident) */
+	Int32 mLayer;
+	/* Number of height queries using the tile (Tiles with readers aren't evicted) */
+	Uint32 mNumReaders;
+
+	/* More recently used tile */
+	HeightTile* mPrev;
+	/* Less recently used tile */
+	HeightTile* mNext;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Height field made of fixed size noise tiles that are generated on demand on worker threads.
+   Generated tiles are cached with a memory limit, and tiles around the camera are streamed into a texture array */
+class TiledHeightMap
+{
+	struct GenerateJobData
+	{
+		/* Height map that owns the tile */
+		TiledHeightMap* mMap;
+		/* Tile to generate */
+		HeightTile* mTile;
+	};
+
+public:
+	TiledHeightMap(
+		float frequency = 1.0f,
+		float amplitude = 1.0f,
+		float lacunarity = 2.0f,
+		float persistence = 0.5f);
+	~TiledHeightMap();
+
+	/* Create GPU textures (Call after settings are set) */
+	void Create();
+	/* Stream tiles around position into the texture array (Main thread only) */
+	void Update(const Vector2f& pos);
+
+	/* Get tile (Starts generating it if needed, returns null until it is ready) */
+	HeightTile* GetTile(const Vector2i& index);
+	/* Get index of tile that contains position */
+	Vector2i GetTileIndex(const Vector2f& pos) const;
+	/* Get bilinearly filtered heights in range [0, 1] at a list of positions (Thread safe). Points in tiles that aren't generated yet
+	   get a height of 0 and false is returned, unless wait is set, in which case the call runs jobs until the tiles are ready */
+	bool GetHeights(const float* x, const float* z, Uint32 num, float* out, bool wait = false);
+
+	/* Set number of texels along each side of a tile, and the size of a tile in world units */
+	void SetTileSize(Uint32 res, float size);
+	/* Set number of noise octaves */
+	void SetOctaves(Uint32 octaves);
+	/* Set number of tiles in each direction around the camera that are kept on the GPU */
+	void SetViewRadius(Uint32 radius);
+	/* Set maximum amount of memory used by cached tiles (in bytes) */
+	void SetMemoryLimit(Uint32 bytes);
+	/* Set maximum number of tiles uploaded to the GPU each frame */
+	void SetMaxUploads(Uint32 num);
+
+	/* Get texture array that holds resident tiles */
+	Texture* GetTileArray() const;
+	/* Get table that maps tiles to texture array layers (Indexed by tile index modulo table size) */
+	Texture* GetTileTable() const;
+	/* Get number of texels along each side of a tile */
+	Uint32 GetTileRes() const;
+	/* Get size of a tile in world units */
+	float GetTileSize() const;
+	/* Get number of tiles along each side of the tile table */
+	Uint32 GetTableSize() const;
+
+private:
+	/* Get tile, creating it if it doesn't exist (Tile mutex must be locked). New tiles must be passed to GenerateTile() after unlocking */
+	HeightTile* RequestTile(const Vector2i& index, bool& created);
+	/* Start generating tile on a worker thread (Call without the tile mutex locked) */
+	void GenerateTile(HeightTile* tile);
+	/* Sample a batch of points whose tiles are all in the tile list */
+	bool SampleTiles(const float* x, const float* z, Uint32 num, float* out, HeightTile** tiles, Uint32 numTiles, bool wait);
+	/* Move tile to front of the recently used list */
+	void Touch(HeightTile* tile);
+	/* Remove tile from the recently used list */
+	void Unlink(HeightTile* tile);
+	/* Free least recently used tiles that aren't resident until memory is under the limit */
+	void EvictTiles();
+	/* Upload tile to a free texture array layer */
+	void UploadTile(HeightTile* tile);
+	/* Remove tile from texture array */
+	void ReleaseLayer(HeightTile* tile);
+
+	/* Job that generates tile heights */
+	static void GenerateJob(void* data);
+	/* Get map key of tile index */
+	static Uint64 GetTileKey(const Vector2i& index);
+
+private:
+	/* Noise generator */
+	FractalNoise mGenerator;
+	/* Float seed */
+	Vector2f mSeed;
+	/* Number of noise octaves */
+	Uint32 mOctaves;
+
+	/* Number of texels along each side of a tile */
+	Uint32 mTileRes;
+	/* Size of a tile in world units */
+	float mTileSize;
+	/* Number of tiles in each direction around the camera kept on the GPU */
+	Uint32 mViewRadius;
+	/* Maximum number of bytes used by cached tiles */
+	Uint32 mMemoryLimit;
+	/* Maximum number of tiles uploaded each frame */
+	Uint32 mMaxUploads;
+
+	/* Map of tile index to tile */
+	std::unordered_map<Uint64, HeightTile*> mTiles;
+	/* Most recently used tile */
+	HeightTile* mFront;
+	/* Least recently used tile */
+	HeightTile* mBack;
+	/* Number of bytes used by tiles */
+	Uint32 mMemoryUsed;
+	/* Protects tile map and recently used list (Height queries can come from any thread) */
+	Mutex mTileMutex;
+
+	/* Texture array of resident tiles */
+	Texture* mTileArray;
+	/* Table of (layer, tile x, tile y) for each resident tile */
+	Texture* mTileTable;
+	/* CPU copy of tile table */
+	Image mTableImage;
+	/* Tile in each texture array layer */
+	Array<HeightTile*> mLayers;
+	/* Unused texture array layers */
+	Array<Int32> mFreeLayers;
+	/* Tile the camera was in last update */
+	Vector2i mCenter;
+	/* True if tile table needs to be uploaded */
+	bool mTableDirty;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Streams a tiled height map around the camera every frame */
+class TiledHeightMapSystem : public GameSystem
+{
+	TYPE_INFO(TiledHeightMapSystem);
+
+public:
+	REQUIRES_NO_COMPONENTS;
+
+public:
+	TiledHeightMapSystem();
+	~TiledHeightMapSystem();
+
+	/* Set height map to update */
+	void SetHeightMap(TiledHeightMap* map);
+
+	/* Update tiles */
+	void Update(float dt) override;
+
+private:
+	void OnInit() override;
+	bool MatchesTags(const std::unordered_set<Uint32>& set) override;
+
+private:
+	/* Height map to update */
+	TiledHeightMap* mHeightMap;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <Graphics/UniformBlock.h>
+
+#include <Core/LogFile.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+Std140Layout::Std140Layout(const char* block) :
+	mBlock		(block),
+	mOffset		(0),
+	mValid		(true)
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Std140Layout::Add(Type type, Uint32 arraySize)
+{
+	Uint32 align = GetAlignment(type, arraySize);
+	Uint32 offset = (mOffset + align - 1) & ~(align - 1);
+
+	mOffset = offset + GetSize(type, arraySize);
+	return offset;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Std140Layout::Check(const char* name, Type type, Uint32 offset, Uint32 arraySize)
+{
+	Uint32 expected = Add(type, arraySize);
+
+	if (offset != expected)
+	{
+		LOG_ERROR << "Uniform block " << mBlock << ": " << name << " is at offset " <<
+			offset << ", std140 expects " << expected << "\n";
+		mValid = false;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Std140Layout::Validate(Uint32 size)
+{
+	if (size != GetSize())
+	{
+		LOG_ERROR << "Uniform block " << mBlock << ": struct size is " << size <<
+			", std140 expects " << GetSize() << "\n";
+		mValid = false;
+	}
+
+	return mValid;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Std140Layout::GetSize() const
+{
+	// Blocks are padded like a struct, to a multiple of a vec4
+	return (mOffset + 15) & ~15u;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Std140Layout::GetAlignment(Type type, Uint32 arraySize)
+{
+	// Arrays and matrices are aligned to a vec4
+	if (arraySize)
+		return 16;
+
+	switch (type)
+	{
+	case Int:
+	case Float:
+		return 4;
+	case Vec2:
+		return 8;
+	default:
+		return 16;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Std140Layout::GetSize(Type type, Uint32 arraySize)
+{
+	Uint32 size = 0;
+
+	switch (type)
+	{
+	case Int:
+	case Float:
+		size = 4;
+		break;
+	case Vec2:
+		size = 8;
+		break;
+	case Vec3:
+		size = 12;
+		break;
+	case Vec4:
+		size = 16;
+		break;
+	case Mat3:
+		// Columns are stored as vec4
+		size = 48;
+		break;
+	case Mat4:
+		size = 64;
+		break;
+	}
+
+	// Array elements are padded to a vec4
+	if (arraySize)
+		size = ((size + 15) & ~15u) * arraySize;
+
+	return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef UNIFORM_BLOCK_H
+#define UNIFORM_BLOCK_H
+
+#include <Core/DataTypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Binding point of the CommonUniforms block (Camera and per pass constants) */
+#define COMMON_UNIFORMS_BINDING 0
+/* Binding point of the AtmosphereUniforms block */
+#define ATMOSPHERE_UNIFORMS_BINDING 1
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Computes std140 offsets and checks CPU struct packing against them (Doesn't need a GL context) */
+class Std140Layout
+{
+public:
+	enum Type
+	{
+		Int,
+		Float,
+		Vec2,
+		Vec3,
+		Vec4,
+		Mat3,
+		Mat4
+	};
+
+public:
+	Std140Layout(const char* block);
+
+	/* Add member and get its std140 offset (Array size of 0 means not an array) */
+	Uint32 Add(Type type, Uint32 arraySize = 0);
+	/* Add member and check that the CPU struct has it at the same offset */
+	void Check(const char* name, Type type, Uint32 offset, Uint32 arraySize = 0);
+	/* Check size of CPU struct, returns true if the whole struct matches the block layout */
+	bool Validate(Uint32 size);
+
+	/* Get size of block so far (Rounded up to a vec4) */
+	Uint32 GetSize() const;
+
+	/* Get base alignment of a member */
+	static Uint32 GetAlignment(Type type, Uint32 arraySize = 0);
+	/* Get number of bytes a member takes up */
+	static Uint32 GetSize(Type type, Uint32 arraySize = 0);
+
+private:
+	/* Block name for error messages */
+	const char* mBlock;
+	/* Offset of next member */
+	Uint32 mOffset;
+	/* False if any checked member didn't match */
+	bool mValid;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
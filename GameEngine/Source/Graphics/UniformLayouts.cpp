@@ -0,0 +1,52 @@
+#include <Graphics/Renderer.h>
+#include <Graphics/Atmosphere.h>
+#include <Graphics/UniformBlock.h>
+
+#include <stddef.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool CommonUniforms::ValidateLayout()
+{
+	Std140Layout layout("CommonUniforms");
+	layout.Check("mProjView", Std140Layout::Mat4, offsetof(CommonUniforms, mProjView));
+	layout.Check("mClipPlane", Std140Layout::Vec4, offsetof(CommonUniforms, mClipPlane));
+	layout.Check("mCamPos", Std140Layout::Vec3, offsetof(CommonUniforms, mCamPos));
+	layout.Check("mTime", Std140Layout::Float, offsetof(CommonUniforms, mTime));
+	layout.Check("mCamPlanes", Std140Layout::Vec2, offsetof(CommonUniforms, mCamPlanes));
+
+	return layout.Validate(sizeof(CommonUniforms));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AtmosphereUniforms::ValidateLayout()
+{
+	Std140Layout layout("AtmosphereUniforms");
+	layout.Check("mSolarIrradiance", Std140Layout::Vec3, offsetof(AtmosphereUniforms, mSolarIrradiance));
+	layout.Check("mSolarIntensity", Std140Layout::Float, offsetof(AtmosphereUniforms, mSolarIntensity));
+	layout.Check("mBr", Std140Layout::Vec3, offsetof(AtmosphereUniforms, mScattering_R));
+	layout.Check("mTopRadius", Std140Layout::Float, offsetof(AtmosphereUniforms, mTopRadius));
+	layout.Check("mBm", Std140Layout::Vec3, offsetof(AtmosphereUniforms, mScattering_M));
+	layout.Check("mBotRadius", Std140Layout::Float, offsetof(AtmosphereUniforms, mBotRadius));
+	layout.Check("mSunSize", Std140Layout::Vec2, offsetof(AtmosphereUniforms, mSunSize));
+	layout.Check("mSunAngularRadius", Std140Layout::Float, offsetof(AtmosphereUniforms, mSunAngularRadius));
+	layout.Check("mHr", Std140Layout::Float, offsetof(AtmosphereUniforms, mScaleHeight_R));
+	layout.Check("mHm", Std140Layout::Float, offsetof(AtmosphereUniforms, mScaleHeight_M));
+	layout.Check("mMiePhaseG", Std140Layout::Float, offsetof(AtmosphereUniforms, mMiePhase_G));
+	layout.Check("mBaseHeight", Std140Layout::Float, offsetof(AtmosphereUniforms, mBaseHeight));
+	layout.Check("mDistScale", Std140Layout::Float, offsetof(AtmosphereUniforms, mDistScale));
+	layout.Check("TRANSMITTANCE_TEXTURE_WIDTH", Std140Layout::Int, offsetof(AtmosphereUniforms, mTransmittanceTexture_W));
+	layout.Check("TRANSMITTANCE_TEXTURE_HEIGHT", Std140Layout::Int, offsetof(AtmosphereUniforms, mTransmittanceTexture_H));
+	layout.Check("SCATTERING_TEXTURE_R_SIZE", Std140Layout::Int, offsetof(AtmosphereUniforms, mScatteringTexture_R));
+	layout.Check("SCATTERING_TEXTURE_MU_SIZE", Std140Layout::Int, offsetof(AtmosphereUniforms, mScatteringTexture_Mu));
+	layout.Check("SCATTERING_TEXTURE_MU_S_SIZE", Std140Layout::Int, offsetof(AtmosphereUniforms, mScatteringTexture_MuS));
+	layout.Check("SCATTERING_TEXTURE_NU_SIZE", Std140Layout::Int, offsetof(AtmosphereUniforms, mScatteringTexture_Nu));
+	layout.Check("IRRADIANCE_TEXTURE_WIDTH", Std140Layout::Int, offsetof(AtmosphereUniforms, mIrradianceTexture_W));
+	layout.Check("IRRADIANCE_TEXTURE_HEIGHT", Std140Layout::Int, offsetof(AtmosphereUniforms, mIrradianceTexture_H));
+
+	return layout.Validate(sizeof(AtmosphereUniforms));
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -37,15 +37,27 @@ void VertexArray::Bind()
 ///////////////////////////////////////////////////////////////////////////////
 
 void VertexArray::VertexAttrib(Uint32 index, Uint32 size, Uint32 stride, Uint32 offset, Uint32 divisor)
+{
+	VertexAttrib(index, size, Float, stride, offset, divisor);
+}
+
+void VertexArray::VertexAttrib(Uint32 index, Uint32 size, AttribType type, Uint32 stride, Uint32 offset, Uint32 divisor)
 {
 	assert(sCurrentBound == mID);
 
-	glVertexAttribPointer(index, size, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+	glVertexAttribPointer(index, size, type, GL_FALSE, stride, (void*)offset);
 	glEnableVertexAttribArray(index);
 	if (divisor)
 		glVertexAttribDivisor(index, divisor);
 }
 
+void VertexArray::DisableAttrib(Uint32 index)
+{
+	assert(sCurrentBound == mID);
+
+	glDisableVertexAttribArray(index);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void VertexArray::SetDrawMode(DrawMode mode)
@@ -23,6 +23,12 @@ public:
 		TriangleFan
 	};
 
+	enum AttribType
+	{
+		Float		= 0x1406,
+		HalfFloat	= 0x140B
+	};
+
 public:
 	VertexArray();
 	~VertexArray();
@@ -32,6 +38,10 @@ public:
 
 	/* Enable vertex attrib */
 	void VertexAttrib(Uint32 index, Uint32 size, Uint32 stride = 0, Uint32 offset = 0, Uint32 divisor = 0);
+	/* Enable vertex attrib with a non float data type (Values are converted to floats) */
+	void VertexAttrib(Uint32 index, Uint32 size, AttribType type, Uint32 stride, Uint32 offset, Uint32 divisor = 0);
+	/* Disable vertex attrib */
+	void DisableAttrib(Uint32 index);
 
 	/* Set vertex array draw mode */
 	void SetDrawMode(DrawMode mode);
@@ -44,6 +44,13 @@ void VertexBuffer::Bind(VertexBuffer::Target target, Uint32 index)
 	sCurrentBound = mID;
 }
 
+void VertexBuffer::Bind(VertexBuffer::Target target, Uint32 index, Uint32 offset, Uint32 size)
+{
+	glBindBufferRange(target, index, mID, offset, size);
+	mTarget = target;
+	sCurrentBound = mID;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 void VertexBuffer::BufferData(const void* data, Uint32 size, Usage usage)
@@ -78,4 +85,14 @@ void VertexBuffer::Unmap()
 	glUnmapBuffer(mTarget);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+void VertexBuffer::CopyData(VertexBuffer* src, Uint32 size, Uint32 srcOffset, Uint32 dstOffset)
+{
+	// Copy targets don't disturb buffers bound to other targets
+	glBindBuffer(GL_COPY_READ_BUFFER, src->mID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, mID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, srcOffset, dstOffset, size);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
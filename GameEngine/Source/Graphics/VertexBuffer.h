@@ -16,7 +16,10 @@ public:
 	{
 		Array				= 0x8892,
 		Element				= 0x8893,
-		TransformFeedback	= 0x8C8E
+		TransformFeedback	= 0x8C8E,
+		Uniform				= 0x8A11,
+		CopyRead			= 0x8F36,
+		CopyWrite			= 0x8F37
 	};
 
 	enum Usage
@@ -41,6 +44,8 @@ public:
 	void Bind(Target target);
 	/* Bind buffer to index */
 	void Bind(Target target, Uint32 index);
+	/* Bind range of buffer to index */
+	void Bind(Target target, Uint32 index, Uint32 offset, Uint32 size);
 
 	/* Send data for first time */
 	void BufferData(const void* data, Uint32 size, Usage usage);
@@ -50,6 +55,8 @@ public:
 	void* MapWrite(Uint32 size, Uint32 opt, Uint32 offset = 0);
 	/* Unmap all mapped ranges */
 	void Unmap();
+	/* Copy range of another buffer into this buffer on the GPU (Offsets are in bytes) */
+	void CopyData(VertexBuffer* src, Uint32 size, Uint32 srcOffset, Uint32 dstOffset);
 
 private:
 	/* Current bound buffer */
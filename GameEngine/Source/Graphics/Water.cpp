@@ -66,20 +66,25 @@ void Water::SetAltitude(float h)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-float FindMin(Image* hmap, const Vector2i& s, const Vector2i& e)
+/* Find minimum terrain height in a square area, sampled on a grid with edges included (Sample buffers are reused between calls) */
+float FindMin(Terrain* terrain, const Vector2f& start, float size, Uint32 samplesPerSide, Array<Vector2f>& points, Array<float>& heights)
 {
-	float* h = (float*)hmap->GetData();
-	float min = INFINITY;
-	int w = (int)hmap->GetWidth();
+	float step = size / (samplesPerSide - 1);
 
-	for (int r = s.y; r <= e.y; ++r)
+	for (Uint32 r = 0; r < samplesPerSide; ++r)
 	{
-		for (int c = s.x; c <= e.x; ++c)
-		{
-			float height = h[r * w + c];
-			if (height < min)
-				min = height;
-		}
+		for (Uint32 c = 0; c < samplesPerSide; ++c)
+			points[r * samplesPerSide + c] = start + Vector2f(c * step, r * step);
+	}
+
+	// One batched query per chunk (Works with single and tiled height maps)
+	terrain->GetHeights(&points[0], points.Size(), &heights[0]);
+
+	float min = INFINITY;
+	for (Uint32 i = 0; i < heights.Size(); ++i)
+	{
+		if (heights[i] < min)
+			min = heights[i];
 	}
 
 	return min;
@@ -191,13 +196,14 @@ void Water::Create(Scene* scene, float viewDist, Uint32 numSquares, float chunkS
 	// Create water map
 	float terrainSize = mTerrain->GetSize();
 	int sizeInChunks = 2 * (int)ceil(terrainSize * 0.5f / chunkSize);
-	Image* hmap = mTerrain->GetHeightMap()->GetImage();
-	float terrainScale = mTerrain->GetMaxHeight();
+	float halfSize = sizeInChunks * chunkSize * 0.5f;
 
-	assert(hmap);
-	float chunkToPixel = (float)hmap->GetWidth() / terrainSize * chunkSize;
-	float pixelOffset = ((sizeInChunks * chunkSize - terrainSize) * 0.5f) / chunkSize * chunkToPixel;
-	int w = (int)hmap->GetWidth();
+	// Sample chunks at the terrain's LOD-0 square size
+	Uint32 samplesPerSide = (Uint32)ceil(chunkSize / mTerrain->GetSquareSize()) + 1;
+	Array<Vector2f> points;
+	Array<float> heights;
+	points.Resize(samplesPerSide * samplesPerSide);
+	heights.Resize(samplesPerSide * samplesPerSide);
 
 	// Keep track of which chunks are in water
 	Uint32 numChunks = sizeInChunks * sizeInChunks;
@@ -206,25 +212,13 @@ void Water::Create(Scene* scene, float viewDist, Uint32 numSquares, float chunkS
 	hasWater.Resize(numChunks, false);
 	visited.Resize(numChunks, false);
 
-	// Scan heights
+	// Scan heights (Chunk grid is centered on the origin, like the water loader expects)
 	for (int r = 0; r < sizeInChunks; ++r)
 	{
 		for (int c = 0; c < sizeInChunks; ++c)
 		{
-			Vector2i s(
-				(int)floor(c * chunkToPixel - pixelOffset),
-				(int)floor(r * chunkToPixel - pixelOffset));
-			Vector2i e(
-				(int)ceil((c + 1) * chunkToPixel - pixelOffset),
-				(int)ceil((r + 1) * chunkToPixel - pixelOffset));
-
-			// Clamp values
-			if (s.x < 0) s.x = 0;
-			if (s.y < 0) s.y = 0;
-			if (e.x >= w) e.x = w - 1;
-			if (e.y >= w) e.y = w - 1;
-
-			float min = FindMin(hmap, s, e) * terrainScale;
+			Vector2f start(c * chunkSize - halfSize, r * chunkSize - halfSize);
+			float min = FindMin(mTerrain, start, chunkSize, samplesPerSide, points, heights);
 
 			// Add height to grid
 			minHeights.Push(min);
@@ -345,7 +339,7 @@ Material* Water::GetMaterial() const
 WaterLoader::WaterLoader() :
 	mModel			(0)
 {
-
+	mStreaming = true;
 }
 
 WaterLoader::~WaterLoader()
@@ -376,7 +370,7 @@ void WaterLoader::OnInit()
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void WaterLoader::OnChunkEnter(ObjectChunk& chunk)
+void WaterLoader::OnChunkPrepare(ObjectChunk& chunk)
 {
 	Vector3f chunkPos = chunk.GetBoundingBox().GetPosition();
 	Vector2i chunkIndex = Vector2i(
@@ -388,21 +382,16 @@ void WaterLoader::OnChunkEnter(ObjectChunk& chunk)
 	// Check if chunk has water
 	if (index >= 0 && index < mWaterMap.Size() && mWaterMap[index])
 	{
-		ComponentMap components;
-		Array<GameObjectID> ids = mScene->CreateObjects<WaterChunk>(1, &components);
-
-		// Set position
-		TransformComponent& t = *components.Get<TransformComponent>();
-		t.mPosition = chunkPos;
-		t.mPosition.y = 0.0f;
+		chunkPos.y = 0.0f;
+		chunk.AddPlacement(chunkPos, Vector3f(0.0f), 1.0f, mModel);
+	}
+}
 
-		// Set model
-		RenderComponent& r = *components.Get<RenderComponent>();
-		r.mModel = mModel;
+///////////////////////////////////////////////////////////////////////////////
 
-		// Add to chunk
-		chunk.AddRenderables(mRenderer, ids, components);
-	}
+void WaterLoader::OnChunkEnter(ObjectChunk& chunk)
+{
+	CommitPlacements<WaterChunk>(chunk);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
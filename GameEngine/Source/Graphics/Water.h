@@ -30,6 +30,7 @@ public:
 
 private:
 	void OnInit() override;
+	void OnChunkPrepare(ObjectChunk& chunk) override;
 	void OnChunkEnter(ObjectChunk& chunk) override;
 	void OnChunkLeave(ObjectChunk& chunk) override;
 
@@ -1,11 +1,24 @@
 #include <Math/Frustum.h>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
 Frustum::Frustum()
 {
-
+	// Padding planes always pass (n = 0, d = 1)
+	for (Uint32 i = 0; i < 8; ++i)
+	{
+		mPlaneData[0][i] = 0.0f;
+		mPlaneData[1][i] = 0.0f;
+		mPlaneData[2][i] = 0.0f;
+		mPlaneData[3][i] = 1.0f;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -14,6 +27,12 @@ Frustum::Frustum()
 void Frustum::SetPlane(const Plane& plane, Side side)
 {
 	mPlanes[side] = plane;
+
+	// Update SoA copy
+	mPlaneData[0][side] = plane.n.x;
+	mPlaneData[1][side] = plane.n.y;
+	mPlaneData[2][side] = plane.n.z;
+	mPlaneData[3][side] = plane.d;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -43,17 +62,203 @@ bool Frustum::Contains(const BoundingBox& box) const
 
 bool Frustum::Contains(const BoundingSphere& sphere) const
 {
-	bool contains = true;
-
 	for (Uint32 i = 0; i < 6; ++i)
 	{
 		const Plane& plane = mPlanes[i];
 
 		if (plane.Dist(sphere.p) + sphere.r < 0.0f)
-			contains = false;
+			return false;
 	}
 
-	return contains;
+	return true;
 }
 
-///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(__AVX__)
+
+Uint32 Frustum::ContainsBatch(const BoundingBox* boxes, Uint32 num, Uint32* out, Uint32 stride) const
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	// Load planes, each register holds one component of all planes
+	__m256 nx = _mm256_loadu_ps(mPlaneData[0]);
+	__m256 ny = _mm256_loadu_ps(mPlaneData[1]);
+	__m256 nz = _mm256_loadu_ps(mPlaneData[2]);
+	__m256 d = _mm256_loadu_ps(mPlaneData[3]);
+
+	// Masks used to choose the positive vertex of the box for each plane
+	__m256 sx = _mm256_cmp_ps(nx, zero, _CMP_GT_OQ);
+	__m256 sy = _mm256_cmp_ps(ny, zero, _CMP_GT_OQ);
+	__m256 sz = _mm256_cmp_ps(nz, zero, _CMP_GT_OQ);
+
+	const char* ptr = (const char*)boxes;
+	Uint32 numVisible = 0;
+
+	for (Uint32 i = 0; i < num; ++i, ptr += stride)
+	{
+		const BoundingBox& box = *(const BoundingBox*)ptr;
+
+		// Positive vertex
+		__m256 px = _mm256_blendv_ps(_mm256_set1_ps(box.mMin.x), _mm256_set1_ps(box.mMax.x), sx);
+		__m256 py = _mm256_blendv_ps(_mm256_set1_ps(box.mMin.y), _mm256_set1_ps(box.mMax.y), sy);
+		__m256 pz = _mm256_blendv_ps(_mm256_set1_ps(box.mMin.z), _mm256_set1_ps(box.mMax.z), sz);
+
+		// Signed distance to each plane
+		__m256 dist = _mm256_add_ps(
+			_mm256_add_ps(_mm256_mul_ps(nx, px), _mm256_mul_ps(ny, py)),
+			_mm256_add_ps(_mm256_mul_ps(nz, pz), d));
+
+		// Visible if no plane has positive vertex behind it
+		out[numVisible] = i;
+		numVisible += !_mm256_movemask_ps(_mm256_cmp_ps(dist, zero, _CMP_LT_OQ));
+	}
+
+	return numVisible;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Frustum::ContainsBatch(const BoundingSphere* spheres, Uint32 num, Uint32* out, Uint32 stride) const
+{
+	const __m256 zero = _mm256_setzero_ps();
+
+	// Load planes, each register holds one component of all planes
+	__m256 nx = _mm256_loadu_ps(mPlaneData[0]);
+	__m256 ny = _mm256_loadu_ps(mPlaneData[1]);
+	__m256 nz = _mm256_loadu_ps(mPlaneData[2]);
+	__m256 d = _mm256_loadu_ps(mPlaneData[3]);
+
+	const char* ptr = (const char*)spheres;
+	Uint32 numVisible = 0;
+
+	for (Uint32 i = 0; i < num; ++i, ptr += stride)
+	{
+		const BoundingSphere& sphere = *(const BoundingSphere*)ptr;
+
+		// Signed distance to each plane, offset by radius
+		__m256 dist = _mm256_add_ps(
+			_mm256_add_ps(
+				_mm256_mul_ps(nx, _mm256_set1_ps(sphere.p.x)),
+				_mm256_mul_ps(ny, _mm256_set1_ps(sphere.p.y))),
+			_mm256_add_ps(
+				_mm256_mul_ps(nz, _mm256_set1_ps(sphere.p.z)),
+				_mm256_add_ps(d, _mm256_set1_ps(sphere.r))));
+
+		// Visible if sphere isn't fully behind any plane
+		out[numVisible] = i;
+		numVisible += !_mm256_movemask_ps(_mm256_cmp_ps(dist, zero, _CMP_LT_OQ));
+	}
+
+	return numVisible;
+}
+
+#else
+
+Uint32 Frustum::ContainsBatch(const BoundingBox* boxes, Uint32 num, Uint32* out, Uint32 stride) const
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	// Load planes, each register holds one component of 4 planes
+	__m128 nx0 = _mm_loadu_ps(mPlaneData[0]);
+	__m128 ny0 = _mm_loadu_ps(mPlaneData[1]);
+	__m128 nz0 = _mm_loadu_ps(mPlaneData[2]);
+	__m128 d0 = _mm_loadu_ps(mPlaneData[3]);
+	__m128 nx1 = _mm_loadu_ps(mPlaneData[0] + 4);
+	__m128 ny1 = _mm_loadu_ps(mPlaneData[1] + 4);
+	__m128 nz1 = _mm_loadu_ps(mPlaneData[2] + 4);
+	__m128 d1 = _mm_loadu_ps(mPlaneData[3] + 4);
+
+	// Masks used to choose the positive vertex of the box for each plane
+	__m128 sx0 = _mm_cmpgt_ps(nx0, zero);
+	__m128 sy0 = _mm_cmpgt_ps(ny0, zero);
+	__m128 sz0 = _mm_cmpgt_ps(nz0, zero);
+	__m128 sx1 = _mm_cmpgt_ps(nx1, zero);
+	__m128 sy1 = _mm_cmpgt_ps(ny1, zero);
+	__m128 sz1 = _mm_cmpgt_ps(nz1, zero);
+
+	const char* ptr = (const char*)boxes;
+	Uint32 numVisible = 0;
+
+	for (Uint32 i = 0; i < num; ++i, ptr += stride)
+	{
+		const BoundingBox& box = *(const BoundingBox*)ptr;
+
+		__m128 minX = _mm_set1_ps(box.mMin.x), maxX = _mm_set1_ps(box.mMax.x);
+		__m128 minY = _mm_set1_ps(box.mMin.y), maxY = _mm_set1_ps(box.mMax.y);
+		__m128 minZ = _mm_set1_ps(box.mMin.z), maxZ = _mm_set1_ps(box.mMax.z);
+
+		// Positive vertex (select max where normal is positive)
+		__m128 px0 = _mm_or_ps(_mm_and_ps(sx0, maxX), _mm_andnot_ps(sx0, minX));
+		__m128 py0 = _mm_or_ps(_mm_and_ps(sy0, maxY), _mm_andnot_ps(sy0, minY));
+		__m128 pz0 = _mm_or_ps(_mm_and_ps(sz0, maxZ), _mm_andnot_ps(sz0, minZ));
+		__m128 px1 = _mm_or_ps(_mm_and_ps(sx1, maxX), _mm_andnot_ps(sx1, minX));
+		__m128 py1 = _mm_or_ps(_mm_and_ps(sy1, maxY), _mm_andnot_ps(sy1, minY));
+		__m128 pz1 = _mm_or_ps(_mm_and_ps(sz1, maxZ), _mm_andnot_ps(sz1, minZ));
+
+		// Signed distance to each plane
+		__m128 dist0 = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(nx0, px0), _mm_mul_ps(ny0, py0)),
+			_mm_add_ps(_mm_mul_ps(nz0, pz0), d0));
+		__m128 dist1 = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(nx1, px1), _mm_mul_ps(ny1, py1)),
+			_mm_add_ps(_mm_mul_ps(nz1, pz1), d1));
+
+		// Visible if no plane has positive vertex behind it
+		__m128 outside = _mm_or_ps(_mm_cmplt_ps(dist0, zero), _mm_cmplt_ps(dist1, zero));
+		out[numVisible] = i;
+		numVisible += !_mm_movemask_ps(outside);
+	}
+
+	return numVisible;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 Frustum::ContainsBatch(const BoundingSphere* spheres, Uint32 num, Uint32* out, Uint32 stride) const
+{
+	const __m128 zero = _mm_setzero_ps();
+
+	// Load planes, each register holds one component of 4 planes
+	__m128 nx0 = _mm_loadu_ps(mPlaneData[0]);
+	__m128 ny0 = _mm_loadu_ps(mPlaneData[1]);
+	__m128 nz0 = _mm_loadu_ps(mPlaneData[2]);
+	__m128 d0 = _mm_loadu_ps(mPlaneData[3]);
+	__m128 nx1 = _mm_loadu_ps(mPlaneData[0] + 4);
+	__m128 ny1 = _mm_loadu_ps(mPlaneData[1] + 4);
+	__m128 nz1 = _mm_loadu_ps(mPlaneData[2] + 4);
+	__m128 d1 = _mm_loadu_ps(mPlaneData[3] + 4);
+
+	const char* ptr = (const char*)spheres;
+	Uint32 numVisible = 0;
+
+	for (Uint32 i = 0; i < num; ++i, ptr += stride)
+	{
+		const BoundingSphere& sphere = *(const BoundingSphere*)ptr;
+
+		__m128 x = _mm_set1_ps(sphere.p.x);
+		__m128 y = _mm_set1_ps(sphere.p.y);
+		__m128 z = _mm_set1_ps(sphere.p.z);
+		__m128 r = _mm_set1_ps(sphere.r);
+
+		// Signed distance to each plane, offset by radius
+		__m128 dist0 = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(nx0, x), _mm_mul_ps(ny0, y)),
+			_mm_add_ps(_mm_mul_ps(nz0, z), _mm_add_ps(d0, r)));
+		__m128 dist1 = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(nx1, x), _mm_mul_ps(ny1, y)),
+			_mm_add_ps(_mm_mul_ps(nz1, z), _mm_add_ps(d1, r)));
+
+		// Visible if sphere isn't fully behind any plane
+		__m128 outside = _mm_or_ps(_mm_cmplt_ps(dist0, zero), _mm_cmplt_ps(dist1, zero));
+		out[numVisible] = i;
+		numVisible += !_mm_movemask_ps(outside);
+	}
+
+	return numVisible;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
@@ -31,8 +31,18 @@ public:
 	/* Returns true if frustum partially or fully contains a sphere */
 	bool Contains(const BoundingSphere& sphere) const;
 
+	/* Test a batch of boxes, stores indices of visible boxes in out and returns number visible.
+	   Out must have space for num indices, stride is the number of bytes between boxes */
+	Uint32 ContainsBatch(const BoundingBox* boxes, Uint32 num, Uint32* out, Uint32 stride = sizeof(BoundingBox)) const;
+	/* Test a batch of spheres, stores indices of visible spheres in out and returns number visible.
+	   Out must have space for num indices, stride is the number of bytes between spheres */
+	Uint32 ContainsBatch(const BoundingSphere* spheres, Uint32 num, Uint32* out, Uint32 stride = sizeof(BoundingSphere)) const;
+
 private:
 	Plane mPlanes[6];
+
+	/* Planes in SoA layout (nx, ny, nz, d), padded to 8 planes for SIMD */
+	float mPlaneData[4][8];
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,184 @@
+#include <Math/Noise.h>
+#include <Math/SIMD.h>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Permutation table (Same as SimplexNoise) */
+	const Uint8 gPerm[256] =
+	{
+		151, 160, 137, 91, 90, 15,
+		131, 13, 201, 95, 96, 53, 194, 233, 7, 225, 140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23,
+		190, 6, 148, 247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32, 57, 177, 33,
+		88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175, 74, 165, 71, 134, 139, 48, 27, 166,
+		77, 146, 158, 231, 83, 111, 229, 122, 60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244,
+		102, 143, 54, 65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169, 200, 196,
+		135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64, 52, 217, 226, 250, 124, 123,
+		5, 202, 38, 147, 118, 126, 255, 82, 85, 212, 207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42,
+		223, 183, 170, 213, 119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+		129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104, 218, 246, 97, 228,
+		251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241, 81, 51, 145, 235, 249, 14, 239, 107,
+		49, 192, 214, 31, 181, 199, 106, 157, 184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254,
+		138, 236, 205, 93, 222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180
+	};
+
+	/* Skew factor for 2D */
+	const float F2 = 0.366025403f;
+	/* Unskew factor for 2D */
+	const float G2 = 0.211324865f;
+
+	///////////////////////////////////////////////////////////////////////////
+
+	using namespace Simd;
+
+	/* Gradient dot residual for 8 gradient directions (Same as SimplexNoise 2D grad) */
+	inline VecF Grad(VecI hash, VecF x, VecF y)
+	{
+		VecI h = AndI(hash, SetI(0x3F));
+
+		// u = h < 4 ? x : y, v = h < 4 ? y : x
+		VecF lt4 = CastF(CmpLtI(h, SetI(4)));
+		VecF u = Select(lt4, x, y);
+		VecF v = Select(lt4, y, x);
+
+		// Flip signs using bit 0 and bit 1 of the hash
+		u = Xor(u, CastF(ShiftLeftI(AndI(h, SetI(1)), 31)));
+		v = Xor(v, CastF(ShiftLeftI(AndI(h, SetI(2)), 30)));
+
+		return Add(u, Mul(v, SetF(2.0f)));
+	}
+
+	/* Contribution of one simplex corner */
+	inline VecF Corner(VecI hash, VecF x, VecF y)
+	{
+		VecF t = Max(Sub(Sub(SetF(0.5f), Mul(x, x)), Mul(y, y)), SetF(0.0f));
+		t = Mul(t, t);
+		return Mul(Mul(t, t), Grad(hash, x, y));
+	}
+
+	/* 2D simplex noise for NOISE_SIMD_WIDTH samples */
+	inline VecF Simplex(VecF x, VecF y)
+	{
+		// Skew the input space to determine which simplex cell we're in
+		VecF s = Mul(Add(x, y), SetF(F2));
+		VecI i = FastFloor(Add(x, s));
+		VecI j = FastFloor(Add(y, s));
+
+		// Unskew the cell origin back to (x,y) space
+		VecF t = Mul(ToFloat(AddI(i, j)), SetF(G2));
+		VecF x0 = Sub(x, Sub(ToFloat(i), t));
+		VecF y0 = Sub(y, Sub(ToFloat(j), t));
+
+		// Middle corner offsets are (1, 0) in the lower triangle, (0, 1) in the upper triangle
+		VecF lower = CmpLt(y0, x0);
+		VecF one = SetF(1.0f);
+		VecF zero = SetF(0.0f);
+		VecF i1 = Select(lower, one, zero);
+		VecF j1 = Select(lower, zero, one);
+
+		VecF x1 = Add(Sub(x0, i1), SetF(G2));
+		VecF y1 = Add(Sub(y0, j1), SetF(G2));
+		VecF x2 = Add(Sub(x0, one), SetF(2.0f * G2));
+		VecF y2 = Add(Sub(y0, one), SetF(2.0f * G2));
+
+		// Hash corners (No gather on SSE2, so look up each lane)
+		Int32 is[SIMD_WIDTH], js[SIMD_WIDTH], lowers[SIMD_WIDTH];
+		Int32 h0[SIMD_WIDTH], h1[SIMD_WIDTH], h2[SIMD_WIDTH];
+		StoreI(is, i);
+		StoreI(js, j);
+		StoreI(lowers, CastI(lower));
+
+		for (Uint32 n = 0; n < SIMD_WIDTH; ++n)
+		{
+			Int32 i1n = lowers[n] ? 1 : 0;
+			h0[n] = gPerm[(Uint8)(is[n] + gPerm[(Uint8)js[n]])];
+			h1[n] = gPerm[(Uint8)(is[n] + i1n + gPerm[(Uint8)(js[n] + 1 - i1n)])];
+			h2[n] = gPerm[(Uint8)(is[n] + 1 + gPerm[(Uint8)(js[n] + 1)])];
+		}
+
+		// Add contributions from each corner, scaled to [-1, 1]
+		VecF n = Add(Add(Corner(LoadI(h0), x0, y0), Corner(LoadI(h1), x1, y1)), Corner(LoadI(h2), x2, y2));
+		return Mul(n, SetF(45.23065f));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FractalNoise::FractalNoise(float f, float a, float l, float p) :
+	mFrequency		(f),
+	mAmplitude		(a),
+	mLacunarity		(l),
+	mPersistence	(p)
+{
+
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FractalNoise::Evaluate(Uint32 octaves, const float* x, const float* y, float* out) const
+{
+	VecF px = LoadF(x);
+	VecF py = LoadF(y);
+	VecF output = SetF(0.0f);
+
+	float denom = 0.0f;
+	float frequency = mFrequency;
+	float amplitude = mAmplitude;
+
+	for (Uint32 i = 0; i < octaves; ++i)
+	{
+		VecF f = SetF(frequency);
+		output = Add(output, Mul(SetF(amplitude), Simplex(Mul(px, f), Mul(py, f))));
+		denom += amplitude;
+
+		frequency *= mLacunarity;
+		amplitude *= mPersistence;
+	}
+
+	StoreF(out, Div(output, SetF(denom)));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void FractalNoise::EvaluateRow(Uint32 octaves, float x, float y, float step, Uint32 num, float* out) const
+{
+	float xs[NOISE_SIMD_WIDTH], ys[NOISE_SIMD_WIDTH];
+	for (Uint32 n = 0; n < NOISE_SIMD_WIDTH; ++n)
+		ys[n] = y;
+
+	Uint32 i = 0;
+	for (; i + NOISE_SIMD_WIDTH <= num; i += NOISE_SIMD_WIDTH)
+	{
+		for (Uint32 n = 0; n < NOISE_SIMD_WIDTH; ++n)
+			xs[n] = x + (float)(i + n) * step;
+
+		Evaluate(octaves, xs, ys, out + i);
+	}
+
+	// Evaluate remaining samples into a temporary buffer
+	if (i < num)
+	{
+		float temp[NOISE_SIMD_WIDTH];
+		for (Uint32 n = 0; n < NOISE_SIMD_WIDTH; ++n)
+			xs[n] = x + (float)(i + n) * step;
+
+		Evaluate(octaves, xs, ys, temp);
+
+		for (Uint32 n = 0; i < num; ++n, ++i)
+			out[i] = temp[n];
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+float FractalNoise::Evaluate(Uint32 octaves, float x, float y) const
+{
+	float out[NOISE_SIMD_WIDTH];
+	EvaluateRow(octaves, x, y, 0.0f, 1, out);
+	return out[0];
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
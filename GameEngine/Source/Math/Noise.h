@@ -0,0 +1,48 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <Core/DataTypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Number of samples evaluated by each SIMD noise call */
+#if defined(__AVX2__)
+#define NOISE_SIMD_WIDTH 8
+#else
+#define NOISE_SIMD_WIDTH 4
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* 2D fractal simplex noise that evaluates several samples at once.
+   Uses the same permutation table and gradients as SimplexNoise, so results match SimplexNoise::fractal */
+class FractalNoise
+{
+public:
+	FractalNoise(
+		float frequency = 1.0f,
+		float amplitude = 1.0f,
+		float lacunarity = 2.0f,
+		float persistence = 0.5f);
+
+	/* Evaluate NOISE_SIMD_WIDTH samples, result is in range [-1, 1] */
+	void Evaluate(Uint32 octaves, const float* x, const float* y, float* out) const;
+	/* Evaluate samples at (x + i * step, y) for i in [0, num) */
+	void EvaluateRow(Uint32 octaves, float x, float y, float step, Uint32 num, float* out) const;
+	/* Evaluate a single sample */
+	float Evaluate(Uint32 octaves, float x, float y) const;
+
+private:
+	/* Frequency of first octave */
+	float mFrequency;
+	/* Amplitude of first octave */
+	float mAmplitude;
+	/* Frequency multiplier between octaves */
+	float mLacunarity;
+	/* Amplitude multiplier between octaves */
+	float mPersistence;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <Core/DataTypes.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Number of floats in a SIMD register */
+#if defined(__AVX2__)
+#define SIMD_WIDTH 8
+#else
+#define SIMD_WIDTH 4
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Wrappers over SSE2 and AVX2 so kernels can be written once for both register widths */
+namespace Simd
+{
+#if defined(__AVX2__)
+	typedef __m256 VecF;
+	typedef __m256i VecI;
+
+	inline VecF SetF(float x) { return _mm256_set1_ps(x); }
+	inline VecI SetI(Int32 x) { return _mm256_set1_epi32(x); }
+	inline VecF LoadF(const float* p) { return _mm256_loadu_ps(p); }
+	inline void StoreF(float* p, VecF x) { _mm256_storeu_ps(p, x); }
+	inline VecI LoadI(const Int32* p) { return _mm256_loadu_si256((const __m256i*)p); }
+	inline void StoreI(Int32* p, VecI x) { _mm256_storeu_si256((__m256i*)p, x); }
+	inline VecF Add(VecF a, VecF b) { return _mm256_add_ps(a, b); }
+	inline VecF Sub(VecF a, VecF b) { return _mm256_sub_ps(a, b); }
+	inline VecF Mul(VecF a, VecF b) { return _mm256_mul_ps(a, b); }
+	inline VecF Div(VecF a, VecF b) { return _mm256_div_ps(a, b); }
+	inline VecF Max(VecF a, VecF b) { return _mm256_max_ps(a, b); }
+	inline VecF Min(VecF a, VecF b) { return _mm256_min_ps(a, b); }
+	inline VecF Xor(VecF a, VecF b) { return _mm256_xor_ps(a, b); }
+	inline VecF Select(VecF mask, VecF a, VecF b) { return _mm256_blendv_ps(b, a, mask); }
+	inline VecF CmpLt(VecF a, VecF b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	inline VecF CmpLe(VecF a, VecF b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	inline int MoveMask(VecF x) { return _mm256_movemask_ps(x); }
+	inline VecF CastF(VecI x) { return _mm256_castsi256_ps(x); }
+	inline VecI CastI(VecF x) { return _mm256_castps_si256(x); }
+	inline VecF ToFloat(VecI x) { return _mm256_cvtepi32_ps(x); }
+	inline VecI Truncate(VecF x) { return _mm256_cvttps_epi32(x); }
+	inline VecI AddI(VecI a, VecI b) { return _mm256_add_epi32(a, b); }
+	inline VecI AndI(VecI a, VecI b) { return _mm256_and_si256(a, b); }
+	inline VecI CmpLtI(VecI a, VecI b) { return _mm256_cmpgt_epi32(b, a); }
+	inline VecI ShiftLeftI(VecI x, int n) { return _mm256_slli_epi32(x, n); }
+#else
+	typedef __m128 VecF;
+	typedef __m128i VecI;
+
+	inline VecF SetF(float x) { return _mm_set1_ps(x); }
+	inline VecI SetI(Int32 x) { return _mm_set1_epi32(x); }
+	inline VecF LoadF(const float* p) { return _mm_loadu_ps(p); }
+	inline void StoreF(float* p, VecF x) { _mm_storeu_ps(p, x); }
+	inline VecI LoadI(const Int32* p) { return _mm_loadu_si128((const __m128i*)p); }
+	inline void StoreI(Int32* p, VecI x) { _mm_storeu_si128((__m128i*)p, x); }
+	inline VecF Add(VecF a, VecF b) { return _mm_add_ps(a, b); }
+	inline VecF Sub(VecF a, VecF b) { return _mm_sub_ps(a, b); }
+	inline VecF Mul(VecF a, VecF b) { return _mm_mul_ps(a, b); }
+	inline VecF Div(VecF a, VecF b) { return _mm_div_ps(a, b); }
+	inline VecF Max(VecF a, VecF b) { return _mm_max_ps(a, b); }
+	inline VecF Min(VecF a, VecF b) { return _mm_min_ps(a, b); }
+	inline VecF Xor(VecF a, VecF b) { return _mm_xor_ps(a, b); }
+	inline VecF Select(VecF mask, VecF a, VecF b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	inline VecF CmpLt(VecF a, VecF b) { return _mm_cmplt_ps(a, b); }
+	inline VecF CmpLe(VecF a, VecF b) { return _mm_cmple_ps(a, b); }
+	inline int MoveMask(VecF x) { return _mm_movemask_ps(x); }
+	inline VecF CastF(VecI x) { return _mm_castsi128_ps(x); }
+	inline VecI CastI(VecF x) { return _mm_castps_si128(x); }
+	inline VecF ToFloat(VecI x) { return _mm_cvtepi32_ps(x); }
+	inline VecI Truncate(VecF x) { return _mm_cvttps_epi32(x); }
+	inline VecI AddI(VecI a, VecI b) { return _mm_add_epi32(a, b); }
+	inline VecI AndI(VecI a, VecI b) { return _mm_and_si128(a, b); }
+	inline VecI CmpLtI(VecI a, VecI b) { return _mm_cmplt_epi32(a, b); }
+	inline VecI ShiftLeftI(VecI x, int n) { return _mm_slli_epi32(x, n); }
+#endif
+
+	/* Largest integer not greater than x */
+	inline VecI FastFloor(VecF x)
+	{
+		VecI i = Truncate(x);
+		// Truncation rounds negative numbers up, so subtract one where x < i (Mask is -1)
+		return AddI(i, CastI(CmpLt(x, ToFloat(i))));
+	}
+
+	/* Linear interpolation */
+	inline VecF Lerp(VecF a, VecF b, VecF t)
+	{
+		return Add(a, Mul(Sub(b, a), t));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include <Resource/AsyncLoader.h>
+
+#include <Core/Thread.h>
+#include <Core/Clock.h>
+
+#include <condition_variable>
+#include <deque>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* I/O threads */
+	Thread* sThreads = 0;
+	/* Number of I/O threads */
+	Uint32 sNumThreads = 0;
+	/* True while I/O threads should keep running */
+	bool sIsRunning = false;
+
+	/* Work for I/O threads */
+	std::deque<std::function<void()>> sIOQueue;
+	/* Protects I/O queue */
+	std::mutex sIOMutex;
+	/* Wakes I/O threads when work is queued */
+	std::condition_variable sIOCondition;
+
+	/* Work for the main thread */
+	std::deque<std::function<void()>> sMainQueue;
+	/* Protects main thread queue */
+	std::mutex sMainMutex;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncLoader::Init(Uint32 numThreads)
+{
+	if (sThreads) return;
+
+	sIsRunning = true;
+	sNumThreads = numThreads ? numThreads : 1;
+	sThreads = new Thread[sNumThreads];
+
+	for (Uint32 i = 0; i < sNumThreads; ++i)
+		sThreads[i].Run(&AsyncLoader::IOLoop);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncLoader::CleanUp()
+{
+	if (!sThreads) return;
+
+	{
+		std::unique_lock<std::mutex> lock(sIOMutex);
+		sIsRunning = false;
+	}
+	sIOCondition.notify_all();
+
+	// Threads finish their queue before stopping
+	delete[] sThreads;
+	sThreads = 0;
+	sNumThreads = 0;
+
+	// Free resources of loads that finished reading
+	while (ProcessMain(1000.0f));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncLoader::RunIO(const std::function<void()>& func)
+{
+	// Run immediately if there are no I/O threads
+	if (!sThreads)
+	{
+		func();
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(sIOMutex);
+		sIOQueue.push_back(func);
+	}
+	sIOCondition.notify_one();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncLoader::RunMain(const std::function<void()>& func)
+{
+	std::unique_lock<std::mutex> lock(sMainMutex);
+	sMainQueue.push_back(func);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AsyncLoader::ProcessMain(float budget)
+{
+	Clock clock;
+
+	while (true)
+	{
+		std::function<void()> func;
+
+		{
+			std::unique_lock<std::mutex> lock(sMainMutex);
+			if (sMainQueue.empty()) return false;
+
+			func = std::move(sMainQueue.front());
+			sMainQueue.pop_front();
+		}
+
+		func();
+
+		if (clock.GetElapsedTime() * 1000.0f >= budget)
+			break;
+	}
+
+	std::unique_lock<std::mutex> lock(sMainMutex);
+	return !sMainQueue.empty();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool AsyncLoader::IsRunning()
+{
+	return sThreads != 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void AsyncLoader::IOLoop()
+{
+	while (true)
+	{
+		std::function<void()> func;
+
+		{
+			std::unique_lock<std::mutex> lock(sIOMutex);
+			sIOCondition.wait(lock, []() { return !sIsRunning || !sIOQueue.empty(); });
+
+			if (sIOQueue.empty()) return;
+
+			func = std::move(sIOQueue.front());
+			sIOQueue.pop_front();
+		}
+
+		func();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include <Core/DataTypes.h>
+
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Default number of threads that read and decode files */
+#define DEFAULT_IO_THREADS 2
+/* Default time spent on main thread work each frame (in milliseconds) */
+#define DEFAULT_UPLOAD_BUDGET 4.0f
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Threads for file reads and decoding, and a queue of work that must run on the main thread (i.e. GL uploads).
+   I/O threads are separate from the job system, so blocking reads don't stall frame jobs */
+class AsyncLoader
+{
+public:
+	/* Start I/O threads */
+	static void Init(Uint32 numThreads = DEFAULT_IO_THREADS);
+	/* Finish queued work and stop I/O threads */
+	static void CleanUp();
+
+	/* Run function on an I/O thread */
+	static void RunIO(const std::function<void()>& func);
+	/* Run function on the main thread during the next ProcessMain() (Thread safe) */
+	static void RunMain(const std::function<void()>& func);
+
+	/* Run queued main thread work until the time budget (in milliseconds) is used up, returns true if work is left.
+	   At least one function is run, so progress is always made */
+	static bool ProcessMain(float budget = DEFAULT_UPLOAD_BUDGET);
+	/* Returns true if I/O threads have been started */
+	static bool IsRunning();
+
+private:
+	/* I/O thread loop */
+	static void IOLoop();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
@@ -5,9 +5,95 @@
 #include <Core/StringHash.h>
 
 #include <Resource/Loadable.h>
+#include <Resource/AsyncLoader.h>
 
 #include <unordered_map>
 #include <type_traits>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <thread>
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Shared state of an asynchronous load */
+template <typename T>
+struct LoadState
+{
+	enum Status
+	{
+		Loading,
+		Loaded,
+		Failed
+	};
+
+	LoadState() :
+		mResource		(0),
+		mStatus			(Loading)
+	{ }
+
+	/* Resource being loaded (Null if load failed) */
+	T* mResource;
+	/* Load status */
+	std::atomic<Uint32> mStatus;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Handle to a resource that is loading in the background */
+template <typename T>
+class ResourceFuture
+{
+public:
+	ResourceFuture() = default;
+
+	/* Future of a load in flight */
+	ResourceFuture(const std::shared_ptr<LoadState<T>>& state) :
+		mState			(state)
+	{ }
+
+	/* Future of a resource that is already loaded */
+	ResourceFuture(T* resource) :
+		mState			(std::make_shared<LoadState<T>>())
+	{
+		mState->mResource = resource;
+		mState->mStatus = LoadState<T>::Loaded;
+	}
+
+	/* Returns true if the load has finished, successfully or not */
+	bool IsDone() const
+	{
+		return !mState || mState->mStatus != LoadState<T>::Loading;
+	}
+
+	/* Returns true if the resource is loaded and ready to use */
+	bool IsReady() const
+	{
+		return mState && mState->mStatus == LoadState<T>::Loaded;
+	}
+
+	/* Get resource (Null until it is loaded, or if the load failed) */
+	T* Get() const
+	{
+		return IsReady() ? mState->mResource : 0;
+	}
+
+	/* Block until the load finishes, running main thread work while waiting (Main thread only) */
+	T* Wait() const
+	{
+		while (!IsDone())
+		{
+			if (!AsyncLoader::ProcessMain())
+				std::this_thread::yield();
+		}
+
+		return Get();
+	}
+
+private:
+	/* Load state shared with the loader */
+	std::shared_ptr<LoadState<T>> mState;
+};
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -32,6 +118,11 @@ public:
 			// Return loaded resource
 			return it->second;
 
+		// Finish load that is already in flight
+		auto pending = sPendingLoads.find(hash);
+		if (pending != sPendingLoads.end())
+			return ResourceFuture<T>(pending->second).Wait();
+
 		T* obj = sResourcePool.New();
 		if (!obj->Load(fname, args...))
 		{
@@ -45,6 +136,38 @@ public:
 		return obj;
 	}
 
+	/* Load resource in the background (Main thread only). The file is read and decoded on an I/O thread
+	   with T::LoadData(), then T::Upload() does GPU work on the main thread. Loads of the same file are shared */
+	template <typename... Args>
+	static ResourceFuture<T> LoadAsync(const char* fname, Args... args)
+	{
+		// Check if file has already been loaded
+		Uint32 hash((Uint32)StringHash(fname));
+		auto it = sFileMap.find(hash);
+		if (it != sFileMap.end())
+			return ResourceFuture<T>(it->second);
+
+		// Share load that is already in flight
+		auto pending = sPendingLoads.find(hash);
+		if (pending != sPendingLoads.end())
+			return ResourceFuture<T>(pending->second);
+
+		std::shared_ptr<LoadState<T>> state = std::make_shared<LoadState<T>>();
+		state->mResource = sResourcePool.New();
+		sPendingLoads[hash] = state;
+
+		// File name must outlive the caller's string
+		std::string file(fname);
+
+		AsyncLoader::RunIO([=]()
+		{
+			bool success = state->mResource->LoadData(file.c_str(), args...);
+			AsyncLoader::RunMain([=]() { FinishLoad(state, hash, success && state->mResource->Upload()); });
+		});
+
+		return ResourceFuture<T>(state);
+	}
+
 	static void Free(T* resource)
 	{
 		if (std::is_base_of<Loadable, T>::value)
@@ -54,6 +177,24 @@ public:
 	}
 
 private:
+	/* Add loaded resource to loaded files, or free it if the load failed (Main thread) */
+	static void FinishLoad(const std::shared_ptr<LoadState<T>>& state, Uint32 hash, bool success)
+	{
+		sPendingLoads.erase(hash);
+
+		if (success)
+		{
+			sFileMap[hash] = state->mResource;
+			state->mStatus = LoadState<T>::Loaded;
+		}
+		else
+		{
+			sResourcePool.Free(state->mResource);
+			state->mResource = 0;
+			state->mStatus = LoadState<T>::Failed;
+		}
+	}
+
 	static void FreeLoadable(Loadable* resource)
 	{
 		// Remove from loaded files if needed
@@ -68,6 +209,8 @@ private:
 	static ObjectPool<T> sResourcePool;
 	/* Loaded resources */
 	static std::unordered_map<Uint32, T*> sFileMap;
+	/* Loads in flight */
+	static std::unordered_map<Uint32, std::shared_ptr<LoadState<T>>> sPendingLoads;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -78,6 +221,9 @@ ObjectPool<T> Resource<T>::sResourcePool;
 template <typename T>
 std::unordered_map<Uint32, T*> Resource<T>::sFileMap;
 
+template <typename T>
+std::unordered_map<Uint32, std::shared_ptr<LoadState<T>>> Resource<T>::sPendingLoads;
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #endif
\ No newline at end of file
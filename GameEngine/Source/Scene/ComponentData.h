@@ -2,8 +2,10 @@
 #define COMPONENT_DATA_H
 
 #include <Core/Array.h>
+#include <Core/FrameAllocator.h>
 
 #include <unordered_map>
+#include <utility>
 #include <assert.h>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -13,18 +15,185 @@ struct Component;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Size of each block of components (in bytes) */
+#define COMPONENT_CHUNK_SIZE 16384
+
+/* Get number of objects that fit in a chunk, given the total size of an object's components */
+inline Uint32 GetComponentChunkCapacity(Uint32 objectSize)
+{
+	return objectSize && objectSize < COMPONENT_CHUNK_SIZE ? COMPONENT_CHUNK_SIZE / objectSize : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Components of a single type for one object type.
+   Components are stored densely in fixed size chunks that are never moved,
+   so pointers to components stay valid until they are removed */
+template <typename T>
+class ComponentGroup
+{
+public:
+	ComponentGroup() :
+		mSize			(0),
+		mChunkCapacity	(GetComponentChunkCapacity(sizeof(T)))
+	{
+		mChunks.Reserve(4);
+	}
+
+	~ComponentGroup()
+	{
+		Clear();
+
+		for (Uint32 i = 0; i < mChunks.Size(); ++i)
+			Free(mChunks[i]);
+	}
+
+	ComponentGroup(const ComponentGroup<T>&) = delete;
+	ComponentGroup<T>& operator=(const ComponentGroup<T>&) = delete;
+
+	/* Access component by index */
+	T& operator[](Uint32 i) const
+	{
+		return mChunks[i / mChunkCapacity][i % mChunkCapacity];
+	}
+
+	/* Set number of components per chunk (Only works while group is empty) */
+	void SetChunkCapacity(Uint32 capacity)
+	{
+		if (mSize || !capacity || capacity == mChunkCapacity) return;
+
+		// Chunks of the old size can't be reused
+		for (Uint32 i = 0; i < mChunks.Size(); ++i)
+			Free(mChunks[i]);
+		mChunks.Clear();
+
+		mChunkCapacity = capacity;
+	}
+
+	/* Add component to end, returns its index */
+	Uint32 Push(T&& component)
+	{
+		Uint32 chunk = mSize / mChunkCapacity;
+
+		// Allocate new chunk if needed
+		if (chunk == mChunks.Size())
+			mChunks.Push((T*)Alloc(mChunkCapacity * sizeof(T), alignof(T) > 64 ? alignof(T) : 64));
+
+		new(mChunks[chunk] + mSize % mChunkCapacity)T(std::move(component));
+		return mSize++;
+	}
+
+	/* Remove component by moving the last component into its place */
+	void SwapPop(Uint32 index)
+	{
+		T& last = (*this)[--mSize];
+
+		if (index != mSize)
+		{
+			T& removed = (*this)[index];
+			removed.~T();
+			new(&removed)T(std::move(last));
+		}
+		last.~T();
+
+		// Keep one empty chunk around so objects near a chunk border don't cause allocations
+		Uint32 numUsed = GetNumChunks();
+		while (mChunks.Size() > numUsed + 1)
+		{
+			Free(mChunks.Back());
+			mChunks.Pop();
+		}
+	}
+
+	/* Remove all components (Keeps chunks) */
+	void Clear()
+	{
+		for (Uint32 i = 0; i < mSize; ++i)
+			(*this)[i].~T();
+		mSize = 0;
+	}
+
+	/* Get number of components */
+	Uint32 Size() const
+	{
+		return mSize;
+	}
+
+	/* Get number of components per chunk */
+	Uint32 GetChunkCapacity() const
+	{
+		return mChunkCapacity;
+	}
+
+	/* Get number of chunks that contain components */
+	Uint32 GetNumChunks() const
+	{
+		return (mSize + mChunkCapacity - 1) / mChunkCapacity;
+	}
+
+	/* Get pointer to first component in chunk */
+	T* GetChunk(Uint32 chunk) const
+	{
+		return mChunks[chunk];
+	}
+
+	/* Get number of components in chunk */
+	Uint32 GetChunkSize(Uint32 chunk) const
+	{
+		Uint32 start = chunk * mChunkCapacity;
+		return mSize - start < mChunkCapacity ? mSize - start : mChunkCapacity;
+	}
+
+private:
+	/* List of chunks */
+	Array<T*> mChunks;
+	/* Number of components */
+	Uint32 mSize;
+	/* Number of components per chunk */
+	Uint32 mChunkCapacity;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Access to a range of components that were created together.
+   The range can span multiple chunks, so it can only be accessed by index */
+template <typename T>
+struct ComponentRange
+{
+	ComponentRange() : mGroup(0), mStart(0) { }
+	ComponentRange(ComponentGroup<T>* group, Uint32 start) : mGroup(group), mStart(start) { }
+
+	/* Convenience accessor operator */
+	T& operator[](Uint32 i) const { return (*mGroup)[mStart + i]; }
+	/* Access first component */
+	T& operator*() const { return (*mGroup)[mStart]; }
+	/* Access first component */
+	T* operator->() const { return &(*mGroup)[mStart]; }
+
+	/* Group that contains the components */
+	ComponentGroup<T>* mGroup;
+	/* Index of first component */
+	Uint32 mStart;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
 /* Object that is returned when game objects are created.
-   They store pointers to the begginning of the create components */
+   It stores the location of the created components */
 class ComponentMap
 {
 public:
-	/* Add component pointer to map */
-	void Add(Uint32 type, Component* c) { mMap[type] = c; }
-	/* Get component pointer */
-	template <typename T> T* Get() { return (T*)mMap[T::StaticTypeID()]; }
+	/* Add component range to map */
+	void Add(Uint32 type, void* group, Uint32 start) { mMap[type] = std::make_pair(group, start); }
+	/* Get created components */
+	template <typename T> ComponentRange<T> Get()
+	{
+		std::pair<void*, Uint32>& range = mMap[T::StaticTypeID()];
+		return ComponentRange<T>((ComponentGroup<T>*)range.first, range.second);
+	}
 
 private:
-	std::unordered_map<Uint32, Component*> mMap;
+	std::unordered_map<Uint32, std::pair<void*, Uint32>> mMap;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -49,28 +218,27 @@ class ComponentData
 {
 public:
 	/* Add component group for object type */
-	static void CreateGroup(Uint32 type)
+	static void CreateGroup(Uint32 type, Uint32 chunkCapacity)
 	{
-		Array<T>& data = sData[type];
-		if (!data.Capacity())
-			data.Reserve(32);
+		sData[type].SetChunkCapacity(chunkCapacity);
 	}
 
-	/* Create components for specific group (Don't call manually) */
-	static T* CreateComponents(Uint32 type, const Array<GameObjectID>& ids)
+	/* Create components for specific group, returns index of first component (Don't call manually) */
+	static Uint32 CreateComponents(Uint32 type, const Array<GameObjectID, FrameAllocator>& ids)
 	{
-		Array<T>& data = sData[type];
+		ComponentGroup<T>& data = sData[type];
+		Uint32 start = data.Size();
 
 		for (Uint32 i = 0; i < ids.Size(); ++i)
 			data.Push(T(ids[i]));
 
-		return &data.Back() - ids.Size() + 1;
+		return start;
 	}
 
 	/* Remove components by index (Don't call manually) */
-	static void RemoveComponents(Uint32 type, const Array<Uint32>& indices)
+	static void RemoveComponents(Uint32 type, const Array<Uint32, FrameAllocator>& indices)
 	{
-		Array<T>& data = sData[type];
+		ComponentGroup<T>& data = sData[type];
 
 		for (Uint32 i = 0; i < indices.Size(); ++i)
 		{
@@ -86,7 +254,7 @@ public:
 	}
 
 	/* Get component data */
-	static Array<T>& GetData(Uint32 type)
+	static ComponentGroup<T>& GetData(Uint32 type)
 	{
 		return sData[type];
 	}
@@ -94,18 +262,18 @@ public:
 	/* Reset data */
 	static void Reset()
 	{
-		sData.Clear();
+		sData.clear();
 	}
 
 private:
 	/* Component data */
-	static std::unordered_map<Uint32, Array<T>> sData;
+	static std::unordered_map<Uint32, ComponentGroup<T>> sData;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 template <typename T>
-std::unordered_map<Uint32, Array<T>> ComponentData<T>::sData;
+std::unordered_map<Uint32, ComponentGroup<T>> ComponentData<T>::sData;
 
 ///////////////////////////////////////////////////////////////////////////////
 
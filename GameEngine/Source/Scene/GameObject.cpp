@@ -21,28 +21,31 @@ GameObjectID GameObject::GetID() const
 ///////////////////////////////////////////////////////////////////////////////
 
 GameObjectID::GameObjectID() :
+	mSlot			(0),
+	mGeneration		(0),
 	mTypeID			(0)
 {
 
 }
 
 GameObjectID::GameObjectID(::Handle handle, Uint16 typeID) :
-	mHandle		(handle),
-	mTypeID		(typeID)
+	mSlot			(HandleSlot(handle)),
+	mGeneration		(HandleGeneration(handle)),
+	mTypeID			(typeID)
 {
 
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-GameObjectID::operator Uint32() const
+GameObjectID::operator Uint64() const
 {
-	return (((Uint32)mHandle) << 16) | (Uint32)mTypeID;
+	return (MakeHandle(mSlot, mGeneration) << 16) | (Uint64)mTypeID;
 }
 
 Handle GameObjectID::Handle() const
 {
-	return mHandle;
+	return MakeHandle(mSlot, mGeneration);
 }
 
 Uint16 GameObjectID::TypeID() const
@@ -21,7 +21,8 @@ public:
 	GameObjectID();
 	GameObjectID(Handle handle, Uint16 typeID);
 
-	operator Uint32() const;
+	/* Pack ID into a single integer */
+	operator Uint64() const;
 
 	/* Get object handle */
 	Handle Handle() const;
@@ -31,8 +32,10 @@ public:
 	bool Exists() const;
 
 private:
-	/* Object handle */
-	::Handle mHandle;
+	/* Handle slot index */
+	Uint32 mSlot;
+	/* Handle generation */
+	Uint16 mGeneration;
 	/* Object type ID */
 	Uint16 mTypeID;
 };
@@ -68,8 +71,9 @@ struct Component;
 
 ///////////////////////////////////////////////////////////////////////////////
 
-#define _CREATE_COMPONENT_GROUPS_FUNC(x) ComponentData<x>::CreateGroup(typeID);
-#define _CREATE_COMPONENTS_FUNC(x) map.Add(x::StaticTypeID(), (Component*)ComponentData<x>::CreateComponents(typeID, ids));
+#define _COMPONENT_SIZE_FUNC(x) + sizeof(x)
+#define _CREATE_COMPONENT_GROUPS_FUNC(x) ComponentData<x>::CreateGroup(typeID, capacity);
+#define _CREATE_COMPONENTS_FUNC(x) map.Add(x::StaticTypeID(), &ComponentData<x>::GetData(typeID), ComponentData<x>::CreateComponents(typeID, ids));
 #define _REMOVE_COMPONENTS_FUNC(x) ComponentData<x>::RemoveComponents(typeID, indices);
 #define _GET_COMPONENT_TYPES_FUNC(x) set.insert(x::StaticTypeID());
 #define _HAS_COMPONENT_FUNC(x) template <> static bool HasComponent<x>() { return true; }
@@ -79,14 +83,18 @@ struct Component;
 #define _REGISTER_COMPONENTS_IMPL(...) \
 public: \
 	static void CreateComponentGroups() \
-	{ Uint32 typeID = StaticTypeID(); LOOP(_CREATE_COMPONENT_GROUPS_FUNC, __VA_ARGS__) } \
-	static ComponentMap CreateComponents(const Array<GameObjectID>& ids) \
+	{ \
+		Uint32 typeID = StaticTypeID(); \
+		Uint32 capacity = GetComponentChunkCapacity((Uint32)(0 LOOP(_COMPONENT_SIZE_FUNC, __VA_ARGS__))); \
+		LOOP(_CREATE_COMPONENT_GROUPS_FUNC, __VA_ARGS__) \
+	} \
+	static ComponentMap CreateComponents(const Array<GameObjectID, FrameAllocator>& ids) \
 	{ \
 		ComponentMap map; Uint32 typeID = StaticTypeID(); \
 		LOOP(_CREATE_COMPONENTS_FUNC, __VA_ARGS__) \
 		return map; \
 	} \
-	static void RemoveComponents(const Array<Uint32>& indices) \
+	static void RemoveComponents(const Array<Uint32, FrameAllocator>& indices) \
 	{ Uint32 typeID = StaticTypeID(); LOOP(_REMOVE_COMPONENTS_FUNC, __VA_ARGS__) } \
 	static void GetComponentTypes(std::unordered_set<Uint32>& set) \
 	{ LOOP(_GET_COMPONENT_TYPES_FUNC, __VA_ARGS__) } \
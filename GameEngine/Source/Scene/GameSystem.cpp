@@ -4,7 +4,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 GameSystem::GameSystem() :
-	mScene		(0)
+	mScene			(0),
+	mMinBatchSize	(DEFAULT_MIN_BATCH_SIZE),
+	mMainThread		(false)
 {
 
 }
@@ -66,4 +68,52 @@ void GameSystem::RegisterObjectType(
 		mObjectTypes.Push(typeID);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+void GameSystem::SetMinBatchSize(Uint32 size)
+{
+	mMinBatchSize = size;
+}
+
+void GameSystem::SetMainThread(bool mainThread)
+{
+	mMainThread = mainThread;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool GameSystem::IsMainThread() const
+{
+	return mMainThread;
+}
+
+const Array<Uint32>& GameSystem::GetDependencies() const
+{
+	return mDependencies;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void GameSystem::AddDependency(Uint32 type)
+{
+	if (!mDependencies.Capacity())
+		mDependencies.Reserve(4);
+
+	mDependencies.Push(type);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint32 GameSystem::GetBatchSize(Uint32 num) const
+{
+	// Aim for a few batches per thread so work can be balanced by stealing
+	Uint32 numBatches = JobSystem::GetNumThreads() * 4;
+	Uint32 size = (num + numBatches - 1) / numBatches;
+	if (size < mMinBatchSize)
+		size = mMinBatchSize;
+
+	// Round up to multiple of 64 so batch boundaries fall on cache line boundaries
+	return (size + 63) & ~63u;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
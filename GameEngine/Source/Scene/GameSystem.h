@@ -5,13 +5,18 @@
 #include <Core/LogFile.h>
 #include <Core/StringHash.h>
 #include <Core/Profiler.h>
+#include <Core/JobSystem.h>
 
 #include <Scene/ComponentData.h>
 
 #include <unordered_set>
+#include <type_traits>
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Default minimum number of entities processed by each job in parallel systems */
+#define DEFAULT_MIN_BATCH_SIZE 128
+
 class Scene;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -34,21 +39,46 @@ public:
 
 	/* Override to add system dependencies */
 	virtual void RegisterDependencies();
+	/* Get component types the system reads and writes */
+	virtual void GetComponentAccess(std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes) = 0;
 
 	/* Add an object type */
 	void RegisterObjectType(Uint32 typeID,
 		const std::unordered_set<Uint32>& set,
 		const std::unordered_set<Uint32>& tags);
 
+	/* Set minimum number of entities processed by each job (Parallel systems only) */
+	void SetMinBatchSize(Uint32 size);
+	/* Force system to update on the main thread (i.e. if it uses input or the window) */
+	void SetMainThread(bool mainThread);
+
+	/* Returns true if system must update on the main thread */
+	bool IsMainThread() const;
+	/* Get type IDs of systems that must update before this one */
+	const Array<Uint32>& GetDependencies() const;
+
 protected:
 	/* Custom initialization */
 	virtual void OnInit();
 	/* Custom clean up */
 	virtual void OnCleanUp();
 
-	/* Get component lists from objects that meet requirements */
+	/* Get component lists from objects that meet requirements (Only valid for the current frame) */
 	template <typename T>
-	Array<ComponentList<T>> GetComponentLists();
+	Array<ComponentList<T>, FrameAllocator> GetComponentLists();
+
+	/* Get number of entities each job should process for a list of the given size */
+	Uint32 GetBatchSize(Uint32 num) const;
+
+	/* Make a system update before this one (Call in RegisterDependencies) */
+	void AddDependency(Uint32 type);
+	/* Make a system update before this one (Call in RegisterDependencies) */
+	template <typename T> void AddDependency() { AddDependency(T::StaticTypeID()); }
+
+	/* Add component access from Execute function parameters (const components are read only) */
+	template <typename C, typename... Args>
+	static void GetExecuteAccess(void (C::*)(Args...),
+		std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes);
 
 protected:
 	/* Scene access */
@@ -56,6 +86,12 @@ protected:
 
 	/* List of tags */
 	Array<StringHash> mTags;
+	/* Minimum number of entities processed by each job */
+	Uint32 mMinBatchSize;
+	/* Type IDs of systems that must update before this one */
+	Array<Uint32> mDependencies;
+	/* True if system must update on the main thread */
+	bool mMainThread;
 
 private:
 	/* Checks if the set of components matches system requirements */
@@ -71,22 +107,33 @@ private:
 ///////////////////////////////////////////////////////////////////////////////
 
 template <typename T>
-inline Array<ComponentList<T>> GameSystem::GetComponentLists()
+inline Array<ComponentList<T>, FrameAllocator> GameSystem::GetComponentLists()
 {
 	if (!mObjectTypes.Size())
-		return Array<ComponentList<T>>();
+		return Array<ComponentList<T>, FrameAllocator>();
+
+	// One list per chunk (All components of an object type share chunk capacity, so lists line up)
+	Uint32 numLists = 0;
+	for (Uint32 i = 0; i < mObjectTypes.Size(); ++i)
+		numLists += ComponentData<T>::GetData(mObjectTypes[i]).GetNumChunks();
 
-	Array<ComponentList<T>> components(mObjectTypes.Size());
+	if (!numLists)
+		return Array<ComponentList<T>, FrameAllocator>();
+
+	Array<ComponentList<T>, FrameAllocator> components(numLists);
 
 	for (Uint32 i = 0; i < mObjectTypes.Size(); ++i)
 	{
-		Array<T>& data = ComponentData<T>::GetData(mObjectTypes[i]);
+		ComponentGroup<T>& data = ComponentData<T>::GetData(mObjectTypes[i]);
 
-		ComponentList<T> list;
-		list.mData = &data.Front();
-		list.mSize = data.Size();
+		for (Uint32 c = 0; c < data.GetNumChunks(); ++c)
+		{
+			ComponentList<T> list;
+			list.mData = data.GetChunk(c);
+			list.mSize = data.GetChunkSize(c);
 
-		components.Push(list);
+			components.Push(list);
+		}
 	}
 
 	return components;
@@ -94,22 +141,49 @@ inline Array<ComponentList<T>> GameSystem::GetComponentLists()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+template <typename T>
+inline void _AddComponentAccess(std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes, std::true_type)
+{
+	if (std::is_const<T>::value)
+		reads.insert(std::remove_const<T>::type::StaticTypeID());
+	else
+		writes.insert(T::StaticTypeID());
+}
+
+template <typename T>
+inline void _AddComponentAccess(std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes, std::false_type)
+{
+	// Not a component (i.e. dt)
+}
+
+template <typename C, typename... Args>
+inline void GameSystem::GetExecuteAccess(void (C::*)(Args...),
+	std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes)
+{
+	int expand[] = { 0, (_AddComponentAccess<typename std::remove_reference<Args>::type>(
+		reads, writes, std::is_class<typename std::remove_reference<Args>::type>()), 0)... };
+	(void)expand;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 #include <Core/Macros.h>
 
 
 #define _MATCHES_REQUIREMENTS_FUNC(x) valid &= set.find(x::StaticTypeID()) != set.end();
 #define _REQUIRES_COMPONENT_FUNC(x) template <> bool RequiresComponent<x>() const { return true; }
-#define _DEFINE_COMPONENT_LISTS_FUNC(x) Array<ComponentList<x>> CONCAT(_, x) = GetComponentLists<x>();
+#define _DEFINE_COMPONENT_LISTS_FUNC(x) Array<ComponentList<x>, FrameAllocator> CONCAT(_, x) = GetComponentLists<x>();
 #define _GET_COMPONENT_LIST_REF_FUNC(x) ComponentList<x>& CONCAT(ref_, x) = CONCAT(_, x)[i];
 #define _EXECUTE_SYSTEM_FUNC(x) CONCAT(ref_, x)[n]
 #define _EXECUTE_SYSTEM_COMMA_FUNC(x) , CONCAT(ref_, x)[n]
 #define _REGISTER_TAGS_FUNC(x) mTags.Push(x);
+#define _COMPONENT_WRITE_ACCESS_FUNC(x) writes.insert(x::StaticTypeID());
 
 
 #define _SYSTEM_UPDATE_IMPL(...) \
 	void Update(float dt) override \
 	{ \
-		ProfilerMarker marker(GetTypeName(), FILE_NAME, __LINE__, 0); \
+		ProfilerMarker marker(GetTypeName()); \
 		LOOP(_DEFINE_COMPONENT_LISTS_FUNC, __VA_ARGS__) \
 		for (Uint32 i = 0; i < CONCAT(_, FIRST_ARG(__VA_ARGS__)).Size(); ++i) \
 		{ \
@@ -119,6 +193,23 @@ inline Array<ComponentList<T>> GameSystem::GetComponentLists()
 		} \
 	} \
 
+#define _SYSTEM_UPDATE_PARALLEL_IMPL(...) \
+	void Update(float dt) override \
+	{ \
+		ProfilerMarker marker(GetTypeName()); \
+		LOOP(_DEFINE_COMPONENT_LISTS_FUNC, __VA_ARGS__) \
+		for (Uint32 i = 0; i < CONCAT(_, FIRST_ARG(__VA_ARGS__)).Size(); ++i) \
+		{ \
+			LOOP(_GET_COMPONENT_LIST_REF_FUNC, __VA_ARGS__) \
+			Uint32 size = CONCAT(ref_, FIRST_ARG(__VA_ARGS__)).mSize; \
+			JobSystem::ParallelFor(0, size, GetBatchSize(size), [&](Uint32 start, Uint32 end) \
+			{ \
+				for (Uint32 n = start; n < end; ++n) \
+				{ Execute(COMMA_LIST(_EXECUTE_SYSTEM_FUNC, _EXECUTE_SYSTEM_COMMA_FUNC, __VA_ARGS__), dt); } \
+			}); \
+		} \
+	} \
+
 #define _REQUIRES_COMPONENTS_NO_UPDATE_IMPL(...) \
 public: \
 	bool MatchesRequirements(const std::unordered_set<Uint32>& set) override \
@@ -130,15 +221,38 @@ public: \
 	template <typename T> bool RequiresComponent() const { return false; } \
 	LOOP(_REQUIRES_COMPONENT_FUNC, __VA_ARGS__)
 
+#define _EXECUTE_ACCESS_IMPL \
+	void GetComponentAccess(std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes) override \
+	{ GetExecuteAccess(&std::remove_pointer<decltype(this)>::type::Execute, reads, writes); }
+
+#define _CUSTOM_UPDATE_ACCESS_IMPL(...) \
+	void GetComponentAccess(std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes) override \
+	{ LOOP(_COMPONENT_WRITE_ACCESS_FUNC, __VA_ARGS__) }
+
 #define _REQUIRES_COMPONENTS_IMPL(...) \
 	_REQUIRES_COMPONENTS_NO_UPDATE_IMPL(__VA_ARGS__) \
+	_EXECUTE_ACCESS_IMPL \
 	_SYSTEM_UPDATE_IMPL(__VA_ARGS__)
 
 
+#define _REQUIRES_COMPONENTS_PARALLEL_IMPL(...) \
+	_REQUIRES_COMPONENTS_NO_UPDATE_IMPL(__VA_ARGS__) \
+	_EXECUTE_ACCESS_IMPL \
+	_SYSTEM_UPDATE_PARALLEL_IMPL(__VA_ARGS__)
+
+#define _REQUIRES_COMPONENTS_CUSTOM_UPDATE_IMPL(...) \
+	_REQUIRES_COMPONENTS_NO_UPDATE_IMPL(__VA_ARGS__) \
+	_CUSTOM_UPDATE_ACCESS_IMPL(__VA_ARGS__)
+
+
 #define REQUIRES_COMPONENTS(...) _REQUIRES_COMPONENTS_IMPL(__VA_ARGS__)
-#define REQUIRES_COMPONENTS_CUSTOM_UPDATE(...) _REQUIRES_COMPONENTS_NO_UPDATE_IMPL(__VA_ARGS__)
+/* Execute is called from worker threads, so it must only modify the components it is given */
+#define REQUIRES_COMPONENTS_PARALLEL(...) _REQUIRES_COMPONENTS_PARALLEL_IMPL(__VA_ARGS__)
+/* Custom update systems are assumed to write to all required components */
+#define REQUIRES_COMPONENTS_CUSTOM_UPDATE(...) _REQUIRES_COMPONENTS_CUSTOM_UPDATE_IMPL(__VA_ARGS__)
 #define REQUIRES_NO_COMPONENTS \
 	bool MatchesRequirements(const std::unordered_set<Uint32>& set) override { return false; } \
+	void GetComponentAccess(std::unordered_set<Uint32>& reads, std::unordered_set<Uint32>& writes) override { } \
 	template <typename T> bool RequiresComponent() const { return false; } \
 
 
@@ -4,6 +4,10 @@
 
 #include <Graphics/Model.h>
 
+#include <Core/Clock.h>
+
+#include <algorithm>
+
 #include <assert.h>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -15,14 +19,22 @@ ObjectLoader::ObjectLoader() :
 	mChunkSize			(0.0f),
 	mLoadRange			(0.0f),
 	mUnloadRange		(0.0f),
-	mPrevPos			(0.0f)
+	mPrevPos			(0.0f),
+	mCenter				(0),
+	mStreaming			(false),
+	mCommitBudget		(DEFAULT_COMMIT_BUDGET)
 {
 
 }
 
 ObjectLoader::~ObjectLoader()
 {
-
+	for (auto it = mChunks.begin(); it != mChunks.end(); ++it)
+	{
+		// Preparation jobs hold a pointer to the chunk
+		JobSystem::Wait(&it->second->mPrepareCounter);
+		delete it->second;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -36,7 +48,7 @@ void ObjectLoader::Init(Scene* scene)
 	OnInit();
 
 	// Initialize
-	mChunks.Reserve(64);
+	mPendingChunks.Reserve(64);
 
 	// Setup initial chunks
 	ReloadChunks();
@@ -46,149 +58,309 @@ void ObjectLoader::Init(Scene* scene)
 
 void ObjectLoader::Update()
 {
+	// Commit chunks that finished preparing in previous frames
+	CommitChunks();
+
 	Camera& cam = mScene->GetCamera();
-	Vector2f newPos(cam.GetPosition().x, cam.GetPosition().z);
-	Vector2b moved = newPos != mPrevPos;
+	mPrevPos = Vector2f(cam.GetPosition().x, cam.GetPosition().z);
+
+	if (mChunkSize <= 0.0f) return;
+
+	// Chunks only enter or leave range when the camera moves to a different chunk
+	Vector2i center = Floor(mPrevPos / mChunkSize);
+	if (center.x == mCenter.x && center.y == mCenter.y) return;
+
+	Vector2i prevCenter = mCenter;
+	mCenter = center;
+
+	// Update chunks
+	UpdateChunks(prevCenter);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ObjectLoader::UpdateChunks(const Vector2i& prevCenter)
+{
+	// Only the border between the old and new ranges needs to be checked
+	Array<Vector2i, FrameAllocator> ring(64);
+
+	// Unload chunks that left the unload range
+	GetRing(prevCenter, mCenter, mUnloadWidths, ring);
+	for (Uint32 i = 0; i < ring.Size(); ++i)
+		LeaveChunk(ring[i]);
+
+	// Load chunks that entered the load range
+	ring.Clear();
+	GetRing(mCenter, prevCenter, mLoadWidths, ring);
+	for (Uint32 i = 0; i < ring.Size(); ++i)
+		EnterChunk(ring[i]);
+}
 
-	// Don't update if camera didn't move
-	if (!moved.x && !moved.y) return;
+///////////////////////////////////////////////////////////////////////////////
 
-	float unloadSquared = mUnloadRange * mUnloadRange;
-	float halfChunk = mChunkSize * 0.5f;
+void ObjectLoader::GetRing(const Vector2i& a, const Vector2i& b, const Array<Int32>& widths,
+	Array<Vector2i, FrameAllocator>& ring)
+{
+	// Ranges haven't been calculated yet
+	if (!widths.Size()) return;
 
-	// Get bounding box of new unloading zone
-	Vector2i s = Floor((newPos - mUnloadRange) / mChunkSize);
-	Vector2i e = Floor((newPos + mUnloadRange + mChunkSize) / mChunkSize);
+	Int32 radius = (Int32)widths.Size() / 2;
 
-	// Find new chunks inside unload zone
-	for (int r = s.y; r < e.y; ++r)
+	for (Int32 r = a.y - radius; r <= a.y + radius; ++r)
 	{
-		for (int c = s.x; c < e.x; ++c)
+		Int32 aw = widths[r - a.y + radius];
+		if (aw < 0) continue;
+
+		// Columns of this row inside range around a
+		Int32 s = a.x - aw;
+		Int32 e = a.x + aw;
+
+		// Columns of this row inside range around b
+		Int32 bOffset = r - b.y + radius;
+		Int32 bw = bOffset >= 0 && bOffset < (Int32)widths.Size() ? widths[bOffset] : -1;
+
+		if (bw < 0)
 		{
-			Vector2f p((float)c, (float)r);
-			p = p * mChunkSize + halfChunk;
-
-			if (
-				// Test if point is outside old loading range
-				DistanceSquared(p, mPrevPos) > unloadSquared &&
-				// Test if point is inside new loading range
-				DistanceSquared(p, newPos) < unloadSquared
-				)
-			{
-				ObjectChunk chunk(p - halfChunk, p + halfChunk);
-				mChunks.Push(std::move(chunk));
-			}
+			// Whole row is outside range around b
+			for (Int32 c = s; c <= e; ++c)
+				ring.Push(Vector2i(c, r));
+		}
+		else
+		{
+			Int32 bs = b.x - bw;
+			Int32 be = b.x + bw;
+
+			// Columns left of b's range
+			for (Int32 c = s; c <= e && c < bs; ++c)
+				ring.Push(Vector2i(c, r));
+			// Columns right of b's range
+			for (Int32 c = be + 1 > s ? be + 1 : s; c <= e; ++c)
+				ring.Push(Vector2i(c, r));
 		}
 	}
+}
 
-	// Update camera position
-	mPrevPos = newPos;
+///////////////////////////////////////////////////////////////////////////////
 
-	// Update chunks
-	UpdateChunks();
+void ObjectLoader::CalcRowWidths(float range, Array<Int32>& widths)
+{
+	// Chunk centers are measured from the center of the camera's chunk, so offsets are whole chunks
+	float rangeSquared = range * range / (mChunkSize * mChunkSize);
+	Int32 radius = (Int32)ceil(range / mChunkSize);
+
+	widths.Clear();
+	widths.Reserve(2 * radius + 1);
+
+	for (Int32 r = -radius; r <= radius; ++r)
+	{
+		// Find widest column inside range (-1 if none are)
+		Int32 w = -1;
+		while ((float)((w + 1) * (w + 1) + r * r) < rangeSquared)
+			++w;
+
+		widths.Push(w);
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void ObjectLoader::UpdateChunks()
+void ObjectLoader::EnterChunk(const Vector2i& index)
 {
-	if (mUnloadRange < mLoadRange) return;
+	ObjectChunk*& chunk = mChunks[GetChunkKey(index)];
+	// Chunk is still loaded from when it was last in range
+	if (chunk) return;
 
-	float loadSquared = mLoadRange * mLoadRange;
-	float unloadSquared = mUnloadRange * mUnloadRange;
+	Vector2f s = Vector2f((float)index.x, (float)index.y) * mChunkSize;
+	chunk = new ObjectChunk(s, s + mChunkSize);
 
-	for (Uint32 i = 0; i < mChunks.Size(); ++i)
+	if (mStreaming)
 	{
-		ObjectChunk& chunk = mChunks[i];
-		Vector3f p3 = chunk.GetBoundingBox().GetPosition();
-		Vector2f p(p3.x, p3.z);
+		// Prepare on a worker thread and commit when done
+		chunk->mState = ObjectChunk::Preparing;
+		mPendingChunks.Push(chunk);
+
+		PrepareJobData data;
+		data.mLoader = this;
+		data.mChunk = chunk;
+		JobSystem::Run(&ObjectLoader::PrepareJob, &data, sizeof(data), &chunk->mPrepareCounter);
+	}
+	else
+		LoadChunk(chunk);
+}
 
-		float distSquared = DistanceSquared(p, mPrevPos);
+///////////////////////////////////////////////////////////////////////////////
+
+void ObjectLoader::LeaveChunk(const Vector2i& index)
+{
+	auto it = mChunks.find(GetChunkKey(index));
+	if (it == mChunks.end()) return;
 
-		if (chunk.IsLoaded() && distSquared > unloadSquared)
+	ObjectChunk* chunk = it->second;
+
+	if (chunk->mState == ObjectChunk::Preparing)
+	{
+		// Chunk left before it was committed, nothing has been created yet so just drop it
+		JobSystem::Wait(&chunk->mPrepareCounter);
+
+		for (Uint32 i = 0; i < mPendingChunks.Size(); ++i)
 		{
-			// Remove chunk from renderer first
-			if (chunk.GetRenderables().Size())
+			if (mPendingChunks[i] == chunk)
 			{
-				Model* model = mScene->GetComponent<RenderComponent>(chunk.GetRenderables()[0])->mModel;
-				mRenderer->RemoveStaticChunk(model, p3);
+				mPendingChunks.SwapPop(i);
+				break;
 			}
+		}
+	}
+	else if (chunk->IsLoaded())
+		UnloadChunk(chunk);
 
-			// Unload chunk
-			OnChunkLeave(chunk);
+	delete chunk;
+	mChunks.erase(it);
+}
 
-			// Remove chunk from list
-			mChunks.SwapPop(i--);
-		}
-		else if (!chunk.IsLoaded() && distSquared < loadSquared)
+///////////////////////////////////////////////////////////////////////////////
+
+void ObjectLoader::CommitChunks()
+{
+	if (!mPendingChunks.Size()) return;
+
+	Clock clock;
+
+	// Find chunks that are done preparing
+	Array<ObjectChunk*, FrameAllocator> ready(mPendingChunks.Size());
+	for (Uint32 i = 0; i < mPendingChunks.Size(); ++i)
+	{
+		if (mPendingChunks[i]->mPrepareCounter.IsDone())
+			ready.Push(mPendingChunks[i]);
+	}
+
+	if (!ready.Size()) return;
+
+	// Commit closest chunks first
+	Vector2f camPos = mPrevPos;
+	std::sort(&ready.Front(), &ready.Front() + ready.Size(),
+		[camPos](ObjectChunk* a, ObjectChunk* b)
 		{
-			// Mark as loaded
-			chunk.MarkLoaded();
+			Vector3f pa = a->GetBoundingBox().GetPosition();
+			Vector3f pb = b->GetBoundingBox().GetPosition();
+			return DistanceSquared(Vector2f(pa.x, pa.z), camPos) < DistanceSquared(Vector2f(pb.x, pb.z), camPos);
+		}
+	);
 
-			// Load chunk
-			OnChunkEnter(chunk);
+	for (Uint32 i = 0; i < ready.Size(); ++i)
+	{
+		// Always commit at least one chunk so loading can't stall
+		if (i && clock.GetElapsedTime() * 1000.0f > mCommitBudget)
+			break;
 
-			// Remove chunk if nothing was added to it
-			if (!chunk.GetRenderables().Size())
-				mChunks.SwapPop(i--);
+		ObjectChunk* chunk = ready[i];
+		chunk->MarkLoaded();
+		OnChunkEnter(*chunk);
+
+		// Placements aren't needed after commit
+		chunk->mPlacements.Free();
+
+		for (Uint32 n = 0; n < mPendingChunks.Size(); ++n)
+		{
+			if (mPendingChunks[n] == chunk)
+			{
+				mPendingChunks.SwapPop(n);
+				break;
+			}
 		}
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void ObjectLoader::LoadChunk(ObjectChunk* chunk)
+{
+	// Prepare on this thread
+	OnChunkPrepare(*chunk);
+
+	// Mark as loaded
+	chunk->MarkLoaded();
+
+	// Load chunk
+	OnChunkEnter(*chunk);
+
+	// Placements aren't needed after commit
+	chunk->mPlacements.Free();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ObjectLoader::UnloadChunk(ObjectChunk* chunk)
+{
+	// Empty chunks stay in the map so they aren't loaded again, but there is nothing to unload
+	if (!chunk->GetRenderables().Size()) return;
+
+	// Remove chunk from renderer first
+	RenderComponent* r = mScene->GetComponent<RenderComponent>(chunk->GetRenderables()[0]);
+	if (r)
+		mRenderer->RemoveStaticChunk(r->mModel, chunk->GetBoundingBox().GetPosition());
+
+	// Unload chunk
+	OnChunkLeave(*chunk);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void ObjectLoader::PrepareJob(void* data)
+{
+	PrepareJobData* job = (PrepareJobData*)data;
+	job->mLoader->OnChunkPrepare(*job->mChunk);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Uint64 ObjectLoader::GetChunkKey(const Vector2i& index)
+{
+	return ((Uint64)(Uint32)index.x << 32) | (Uint32)index.y;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void ObjectLoader::ReloadChunks()
 {
 	// Unload any chunks
-	for (Uint32 i = 0; i < mChunks.Size(); ++i)
+	for (auto it = mChunks.begin(); it != mChunks.end(); ++it)
 	{
-		ObjectChunk& chunk = mChunks[i];
+		ObjectChunk* chunk = it->second;
+
+		// Wait for preparation to finish before the chunk is deleted
+		JobSystem::Wait(&chunk->mPrepareCounter);
 
 		// Unload chunk if needed
-		if (chunk.IsLoaded())
-		{
-			// Remove chunk from renderer first
-			if (chunk.GetRenderables().Size())
-			{
-				Model* model = mScene->GetComponent<RenderComponent>(chunk.GetRenderables()[0])->mModel;
-				mRenderer->RemoveStaticChunk(model, chunk.GetBoundingBox().GetPosition());
-			}
+		if (chunk->IsLoaded())
+			UnloadChunk(chunk);
 
-			// Unload chunk
-			OnChunkLeave(chunk);
-		}
+		delete chunk;
 	}
 
+	mChunks.clear();
+	mPendingChunks.Clear();
+
+	// Loader hasn't been set up yet
+	if (mChunkSize <= 0.0f) return;
+
+	// Chunks stay loaded until they leave the unload range, so it can't be smaller than the load range
+	CalcRowWidths(mLoadRange, mLoadWidths);
+	CalcRowWidths(mUnloadRange > mLoadRange ? mUnloadRange : mLoadRange, mUnloadWidths);
 
-	// Add initial points
 	Camera& cam = mScene->GetCamera();
 	mPrevPos = Vector2f(cam.GetPosition().x, cam.GetPosition().z);
+	mCenter = Floor(mPrevPos / mChunkSize);
 
-	Vector2i s = Floor((mPrevPos - mUnloadRange) / mChunkSize);
-	Vector2i e = Floor((mPrevPos + mUnloadRange + mChunkSize) / mChunkSize);
-	float unloadSquared = mUnloadRange * mUnloadRange;
-	float halfChunk = mChunkSize * 0.5f;
-
-	// Loop box
-	for (int r = s.y; r < e.y; ++r)
+	// Load all chunks inside load range
+	Int32 radius = (Int32)mLoadWidths.Size() / 2;
+	for (Int32 r = -radius; r <= radius; ++r)
 	{
-		for (int c = s.x; c < e.x; ++c)
-		{
-			Vector2f p((float)c, (float)r);
-			p = p * mChunkSize + halfChunk;
+		Int32 w = mLoadWidths[r + radius];
 
-			// Test if point is inside unload range
-			if (DistanceSquared(p, mPrevPos) < unloadSquared)
-			{
-				ObjectChunk chunk(p - halfChunk, p + halfChunk);
-				// Add to list
-				mChunks.Push(std::move(chunk));
-			}
-		}
+		for (Int32 c = -w; c <= w; ++c)
+			EnterChunk(Vector2i(mCenter.x + c, mCenter.y + r));
 	}
-
-	// Update chunks
-	UpdateChunks();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -209,6 +381,16 @@ void ObjectLoader::SetUnloadDist(float dist)
 	mUnloadRange = dist;
 }
 
+void ObjectLoader::SetStreaming(bool streaming)
+{
+	mStreaming = streaming;
+}
+
+void ObjectLoader::SetCommitBudget(float budget)
+{
+	mCommitBudget = budget;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -217,11 +399,16 @@ void ObjectLoader::OnInit()
 
 }
 
+void ObjectLoader::OnChunkPrepare(ObjectChunk& chunk)
+{
+
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
 ObjectChunk::ObjectChunk(const Vector2f& s, const Vector2f& e) :
-	mIsLoaded		(false)
+	mState			(Unloaded)
 {
 	mRenderables.Reserve(8);
 	mBoundingBox.mMin = Vector3f(s.x, INFINITY, s.y);
@@ -230,16 +417,51 @@ ObjectChunk::ObjectChunk(const Vector2f& s, const Vector2f& e) :
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void ObjectChunk::AddPlacement(const Vector3f& pos, const Vector3f& rot, float scale, Model* model)
+{
+	if (!mPlacements.Capacity())
+		mPlacements.Reserve(8);
+
+	ObjectPlacement placement;
+	placement.mPosition = pos;
+	placement.mRotation = rot;
+	placement.mScale = scale;
+	placement.mModel = model;
+
+	// Calculate bounding sphere
+	const BoundingBox& modelBox = model->GetBoundingBox();
+	Vector3f boxPos = modelBox.GetPosition();
+
+	BoundingSphere& sphere = placement.mBoundingSphere;
+	sphere.p = boxPos + pos;
+	sphere.r = Distance(boxPos, modelBox.mMin) * scale;
+
+	ExpandBounds(sphere);
+
+	mPlacements.Push(placement);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void ObjectChunk::AddRenderables(
-	Renderer* renderer, const Array<GameObjectID>& ids, ComponentMap& components)
+	Renderer* renderer, const Array<GameObjectID, FrameAllocator>& ids, ComponentMap& components)
 {
 	mRenderables = ids;
 
-	TransformComponent* t = components.Get<TransformComponent>();
-	RenderComponent* r = components.Get<RenderComponent>();
+	ComponentRange<TransformComponent> t = components.Get<TransformComponent>();
+	ComponentRange<RenderComponent> r = components.Get<RenderComponent>();
+
+	// Bounds were already calculated if the objects came from prepared placements
+	bool prepared = mPlacements.Size() == mRenderables.Size();
 
 	for (Uint32 i = 0; i < mRenderables.Size(); ++i)
 	{
+		if (prepared)
+		{
+			r[i].mBoundingSphere = mPlacements[i].mBoundingSphere;
+			continue;
+		}
+
 		// Update bounding box
 		const BoundingBox& modelBox = r[i].mModel->GetBoundingBox();
 		Vector3f boxPos = modelBox.GetPosition();
@@ -248,22 +470,7 @@ void ObjectChunk::AddRenderables(
 		sphere.p = boxPos + t[i].mPosition;
 		sphere.r = Distance(boxPos, modelBox.mMin) * t[i].mScale;
 
-		BoundingBox box(sphere.p - sphere.r, sphere.p + sphere.r);
-
-		if (box.mMin.x < mBoundingBox.mMin.x)
-			mBoundingBox.mMin.x = box.mMin.x;
-		if (box.mMax.x > mBoundingBox.mMax.x)
-			mBoundingBox.mMax.x = box.mMax.x;
-
-		if (box.mMin.y < mBoundingBox.mMin.y)
-			mBoundingBox.mMin.y = box.mMin.y;
-		if (box.mMax.y > mBoundingBox.mMax.y)
-			mBoundingBox.mMax.y = box.mMax.y;
-
-		if (box.mMin.z < mBoundingBox.mMin.z)
-			mBoundingBox.mMin.z = box.mMin.z;
-		if (box.mMax.z > mBoundingBox.mMax.z)
-			mBoundingBox.mMax.z = box.mMax.z;
+		ExpandBounds(sphere);
 	}
 
 	// Add to renderer
@@ -272,9 +479,31 @@ void ObjectChunk::AddRenderables(
 
 ///////////////////////////////////////////////////////////////////////////////
 
+void ObjectChunk::ExpandBounds(const BoundingSphere& sphere)
+{
+	BoundingBox box(sphere.p - sphere.r, sphere.p + sphere.r);
+
+	if (box.mMin.x < mBoundingBox.mMin.x)
+		mBoundingBox.mMin.x = box.mMin.x;
+	if (box.mMax.x > mBoundingBox.mMax.x)
+		mBoundingBox.mMax.x = box.mMax.x;
+
+	if (box.mMin.y < mBoundingBox.mMin.y)
+		mBoundingBox.mMin.y = box.mMin.y;
+	if (box.mMax.y > mBoundingBox.mMax.y)
+		mBoundingBox.mMax.y = box.mMax.y;
+
+	if (box.mMin.z < mBoundingBox.mMin.z)
+		mBoundingBox.mMin.z = box.mMin.z;
+	if (box.mMax.z > mBoundingBox.mMax.z)
+		mBoundingBox.mMax.z = box.mMax.z;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void ObjectChunk::MarkLoaded()
 {
-	mIsLoaded = true;
+	mState = Loaded;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -284,14 +513,24 @@ const Array<GameObjectID>& ObjectChunk::GetRenderables() const
 	return mRenderables;
 }
 
+const Array<ObjectPlacement>& ObjectChunk::GetPlacements() const
+{
+	return mPlacements;
+}
+
 const BoundingBox& ObjectChunk::GetBoundingBox() const
 {
 	return mBoundingBox;
 }
 
+ObjectChunk::State ObjectChunk::GetState() const
+{
+	return mState;
+}
+
 bool ObjectChunk::IsLoaded() const
 {
-	return mIsLoaded;
+	return mState == Loaded;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
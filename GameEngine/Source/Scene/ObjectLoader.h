@@ -3,6 +3,7 @@
 
 #include <Core/TypeInfo.h>
 #include <Core/Array.h>
+#include <Core/JobSystem.h>
 
 #include <Math/Vector2.h>
 #include <Math/BoundingBox.h>
@@ -11,38 +12,84 @@
 #include <Scene/Components.h>
 #include <Graphics/Components.h>
 
+#include <unordered_map>
+
 ///////////////////////////////////////////////////////////////////////////////
 
+/* Default time the main thread can spend committing prepared chunks each frame (in milliseconds) */
+#define DEFAULT_COMMIT_BUDGET 2.0f
+
 class Scene;
 class Renderer;
+class Model;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Object placement computed while a chunk is being prepared */
+struct ObjectPlacement
+{
+	/* Position */
+	Vector3f mPosition;
+	/* Rotation */
+	Vector3f mRotation;
+	/* Scale */
+	float mScale;
+	/* Model */
+	Model* mModel;
+	/* World space bounding sphere */
+	BoundingSphere mBoundingSphere;
+};
 
 ///////////////////////////////////////////////////////////////////////////////
 
 class ObjectChunk
 {
+	friend class ObjectLoader;
+
+public:
+	enum State
+	{
+		Unloaded,
+		Preparing,
+		Loaded
+	};
+
 public:
-	ObjectChunk() = default;
 	ObjectChunk(const Vector2f& s, const Vector2f& e);
 
-	/* Add renderables to chunk */
-	void AddRenderables(Renderer* renderer, const Array<GameObjectID>& ids, ComponentMap& components);
+	/* Add object placement and expand bounds (Call from OnChunkPrepare, safe on worker threads) */
+	void AddPlacement(const Vector3f& pos, const Vector3f& rot, float scale, Model* model);
+	/* Add renderables to chunk (Uses prepared placement bounds if there are any) */
+	void AddRenderables(Renderer* renderer, const Array<GameObjectID, FrameAllocator>& ids, ComponentMap& components);
 	/* Marks chunk as loaded */
 	void MarkLoaded();
 
 	/* Get list of renderables */
 	const Array<GameObjectID>& GetRenderables() const;
+	/* Get list of prepared placements */
+	const Array<ObjectPlacement>& GetPlacements() const;
 	/* Get bounding box */
 	const BoundingBox& GetBoundingBox() const;
+	/* Get chunk state */
+	State GetState() const;
 	/* Returns true if chunk has been loaded */
 	bool IsLoaded() const;
 
+private:
+	/* Expand bounding box to contain sphere */
+	void ExpandBounds(const BoundingSphere& sphere);
+
 private:
 	/* List of renderables */
 	Array<GameObjectID> mRenderables;
+	/* Placements computed during preparation */
+	Array<ObjectPlacement> mPlacements;
 	/* The chunk bounding box */
 	BoundingBox mBoundingBox;
-	/* True if chunk has been loaded */
-	bool mIsLoaded;
+	/* Keeps track of the preparation job */
+	JobCounter mPrepareCounter;
+	/* Current state */
+	State mState;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -54,6 +101,14 @@ class ObjectLoader
 {
 	REQUIRES_TYPE_INFO;
 
+	struct PrepareJobData
+	{
+		/* Loader that owns the chunk */
+		ObjectLoader* mLoader;
+		/* Chunk to prepare */
+		ObjectChunk* mChunk;
+	};
+
 public:
 	ObjectLoader();
 	virtual ~ObjectLoader();
@@ -63,12 +118,16 @@ public:
 	/* Update loader */
 	void Update();
 
-	/* Set chunk size */
+	/* Set chunk size (Takes effect on next ReloadChunks) */
 	void SetChunkSize(float size);
-	/* Set loading range */
+	/* Set loading range (Takes effect on next ReloadChunks) */
 	void SetLoadDist(float dist);
-	/* Set unloading range */
+	/* Set unloading range (Takes effect on next ReloadChunks) */
 	void SetUnloadDist(float dist);
+	/* Enable preparing chunks on worker threads and committing them over multiple frames */
+	void SetStreaming(bool streaming);
+	/* Set time the main thread can spend committing prepared chunks each frame (in milliseconds) */
+	void SetCommitBudget(float budget);
 
 	/* Reload chunks */
 	void ReloadChunks();
@@ -87,23 +146,94 @@ protected:
 	float mUnloadRange;
 	/* Previous camera position */
 	Vector2f mPrevPos;
+	/* Index of chunk the camera is in */
+	Vector2i mCenter;
+	/* True if chunks are prepared on worker threads */
+	bool mStreaming;
+	/* Time spent committing chunks each frame (in milliseconds) */
+	float mCommitBudget;
+
+protected:
+	/* Create objects from prepared placements and add them to the chunk (Call from OnChunkEnter) */
+	template <typename T> void CommitPlacements(ObjectChunk& chunk);
 
 private:
 	/* Called when loader is initialized */
 	virtual void OnInit();
+	/* Called before a chunk enters range, runs on a worker thread if streaming is enabled.
+	   It must not access the scene or create objects, only fill in chunk placements */
+	virtual void OnChunkPrepare(ObjectChunk& chunk);
 	/* Called when chunk enters range */
 	virtual void OnChunkEnter(ObjectChunk& chunk) = 0;
 	/* Called when chunk leaves range */
 	virtual void OnChunkLeave(ObjectChunk& chunk) = 0;
 
-	/* Update chunks in list */
-	void UpdateChunks();
+	/* Load chunks that entered the load range and unload chunks that left the unload range */
+	void UpdateChunks(const Vector2i& prevCenter);
+	/* Get chunks that are inside range around center a, but not inside the same range around center b */
+	void GetRing(const Vector2i& a, const Vector2i& b, const Array<Int32>& widths,
+		Array<Vector2i, FrameAllocator>& ring);
+	/* Calculate half width (in chunks) of each chunk row within range */
+	void CalcRowWidths(float range, Array<Int32>& widths);
+	/* Create chunk and start loading it */
+	void EnterChunk(const Vector2i& index);
+	/* Unload chunk and remove it */
+	void LeaveChunk(const Vector2i& index);
+	/* Commit prepared chunks, closest first, until budget runs out */
+	void CommitChunks();
+	/* Load chunk on the main thread */
+	void LoadChunk(ObjectChunk* chunk);
+	/* Remove chunk objects and renderables */
+	void UnloadChunk(ObjectChunk* chunk);
+
+	/* Job that prepares a chunk */
+	static void PrepareJob(void* data);
+
+	/* Get map key of chunk index */
+	static Uint64 GetChunkKey(const Vector2i& index);
 
 private:
-	/* List of chunks */
-	Array<ObjectChunk> mChunks;
+	/* Map of chunk index to chunk (Only contains chunks that are loading or loaded) */
+	std::unordered_map<Uint64, ObjectChunk*> mChunks;
+	/* Half width of each chunk row within load range, indexed by row offset from center */
+	Array<Int32> mLoadWidths;
+	/* Half width of each chunk row within unload range, indexed by row offset from center */
+	Array<Int32> mUnloadWidths;
+	/* Chunks that are being prepared or are waiting to be committed */
+	Array<ObjectChunk*> mPendingChunks;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <Scene/Scene.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+inline void ObjectLoader::CommitPlacements(ObjectChunk& chunk)
+{
+	const Array<ObjectPlacement>& placements = chunk.GetPlacements();
+	if (!placements.Size()) return;
+
+	ComponentMap components;
+	Array<GameObjectID, FrameAllocator> ids = mScene->CreateObjects<T>(placements.Size(), &components);
+
+	ComponentRange<TransformComponent> t = components.Get<TransformComponent>();
+	ComponentRange<RenderComponent> r = components.Get<RenderComponent>();
+
+	for (Uint32 i = 0; i < placements.Size(); ++i)
+	{
+		const ObjectPlacement& placement = placements[i];
+		t[i].mPosition = placement.mPosition;
+		t[i].mRotation = placement.mRotation;
+		t[i].mScale = placement.mScale;
+		r[i].mModel = placement.mModel;
+	}
+
+	// Add to chunk
+	chunk.AddRenderables(mRenderer, ids, components);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 #endif
\ No newline at end of file
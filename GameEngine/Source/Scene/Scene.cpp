@@ -32,7 +32,6 @@ void Scene::Create(Engine* engine)
 
 	mRenderer.Init(this);
 
-	mSystemUpdateList.Reserve(16);
 	mLoaderUpdateList.Reserve(16);
 	mRemovalQueue.Reserve(128);
 
@@ -69,8 +68,7 @@ void Scene::Update(float dt)
 	STOP_PROFILER(LoaderUpdate);
 
 	START_PROFILER(SystemUpdate);
-	for (Uint32 i = 0; i < mSystemUpdateList.Size(); ++i)
-		mSystemUpdateList[i]->Update(dt);
+	mSystemScheduler.Update(dt);
 	STOP_PROFILER(SystemUpdate);
 
 	// Remove objects in the removal queue
@@ -150,8 +148,17 @@ void Scene::SendEvent(const void* event, Uint32 type)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+bool Scene::IsValid(GameObjectID id)
+{
+	auto it = mTypeToObjectData.find(id.TypeID());
+	return it != mTypeToObjectData.end() && it->second.mObjectHandles.IsValid(id.Handle());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 void Scene::QueueRemoveObject(GameObjectID id)
 {
+	Lock lock(mRemovalMutex);
 	mRemovalQueue.Push(id);
 }
 
@@ -161,7 +168,10 @@ void Scene::RemoveQueuedObjects()
 {
 	if (!mRemovalQueue.Size()) return;
 
-	std::unordered_map<Uint32, Array<Uint32>> indicesMap;
+	// List of removed indices for each object type (There are only a few types, so search linearly)
+	Array<Uint32, FrameAllocator> types(8);
+	Array<ObjectData*, FrameAllocator> typeData(8);
+	Array<Array<Uint32, FrameAllocator>, FrameAllocator> typeIndices(8);
 
 	for (Uint32 i = 0; i < mRemovalQueue.Size(); ++i)
 	{
@@ -169,19 +179,28 @@ void Scene::RemoveQueuedObjects()
 		Uint32 typeID = id.TypeID();
 		Handle handle = id.Handle();
 
-		ObjectData& data = mTypeToObjectData[typeID];
-		Array<Uint32>& indices = indicesMap[typeID];
+		// Find object type
+		Uint32 type = 0;
+		for (; type < types.Size() && types[type] != typeID; ++type);
+
+		if (type == types.Size())
+		{
+			types.Push(typeID);
+			typeData.Push(&mTypeToObjectData[typeID]);
+			typeIndices.Push(Array<Uint32, FrameAllocator>(32));
+		}
 
-		if (!indices.Capacity())
-			indices.Reserve(32);
+		ObjectData& data = *typeData[type];
+		// Skip objects that were already removed (i.e. queued twice)
+		if (!data.mObjectHandles.IsValid(handle)) continue;
 
-		indices.Push(data.mObjectHandles.HandleToIndex(handle));
+		typeIndices[type].Push(data.mObjectHandles.HandleToIndex(handle));
 		data.mObjectHandles.Remove(handle);
 	}
 
 	// Remove components
-	for (auto it = indicesMap.begin(); it != indicesMap.end(); ++it)
-		(*mTypeToObjectData[it->first].mRemoveFunc)(it->second);
+	for (Uint32 i = 0; i < types.Size(); ++i)
+		(*typeData[i]->mRemoveFunc)(typeIndices[i]);
 
 	// Reset queue
 	mRemovalQueue.Clear();
@@ -199,8 +218,8 @@ bool Scene::RegisterSystem(GameSystem* system, Uint32 type)
 	system->Init(this);
 	system->RegisterDependencies();
 
-	// Add to update list
-	mSystemUpdateList.Push(system);
+	// Add to update schedule
+	mSystemScheduler.AddSystem(system, type);
 
 	return true;
 }
@@ -12,6 +12,8 @@
 
 #include <Resource/Resource.h>
 
+#include <Scene/SystemScheduler.h>
+
 #include <unordered_map>
 #include <unordered_set>
 #include <assert.h>
@@ -37,7 +39,7 @@ struct ObjectData
 	/* The set of component types the game object contains */
 	std::unordered_set<Uint32> mComponentTypes;
 	/* Remove function */
-	void (*mRemoveFunc)(const Array<Uint32>&);
+	void (*mRemoveFunc)(const Array<Uint32, FrameAllocator>&);
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -106,16 +108,19 @@ public:
 
 	/* Register object type */
 	template <typename T> void RegisterObject();
-	/* Create game objects (Provide components map to edit components upon creation) */
+	/* Create game objects (Provide components map to edit components upon creation).
+	   The returned list is only valid for the current frame, copy it to keep it longer */
 	template <typename T>
-	Array<GameObjectID> CreateObjects(Uint32 num, ComponentMap* components = 0);
+	Array<GameObjectID, FrameAllocator> CreateObjects(Uint32 num, ComponentMap* components = 0);
 	/* Get game object from ID */
 	template <typename T> T GetObject(GameObjectID id);
-	/* Access component using game object ID */
+	/* Access component using game object ID (Returns null if object was removed) */
 	template <typename T> T* GetComponent(GameObjectID id);
+	/* Returns true if game object ID refers to an object that hasn't been removed */
+	bool IsValid(GameObjectID id);
 	/* Remove a list of game objects */
 	template <typename T> void RemoveObjects(const Array<GameObjectID>& ids);
-	/* Queue removal of an object */
+	/* Queue removal of an object (Thread safe) */
 	void QueueRemoveObject(GameObjectID id);
 
 	/* ====================== Object Loaders ====================== */
@@ -185,8 +190,8 @@ private:
 	/* Map of object loaders */
 	std::unordered_map<Uint32, ObjectLoader*> mLoaders;
 
-	/* Update list for game systems */
-	Array<GameSystem*> mSystemUpdateList;
+	/* Schedules game system updates */
+	SystemScheduler mSystemScheduler;
 	/* Update list for object loaders */
 	Array<ObjectLoader*> mLoaderUpdateList;
 
@@ -194,6 +199,8 @@ private:
 	std::unordered_map<Uint32, ObjectData> mTypeToObjectData;
 	/* List of game objects to remove */
 	Array<GameObjectID> mRemovalQueue;
+	/* Protects removal queue (Systems can update on any thread) */
+	Mutex mRemovalMutex;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -252,7 +259,7 @@ inline void Scene::RegisterObject()
 
 
 template <typename T>
-inline Array<GameObjectID> Scene::CreateObjects(Uint32 num, ComponentMap* components)
+inline Array<GameObjectID, FrameAllocator> Scene::CreateObjects(Uint32 num, ComponentMap* components)
 {
 	Uint32 typeID = T::StaticTypeID();
 	ObjectData& data = mTypeToObjectData[typeID];
@@ -264,7 +271,7 @@ inline Array<GameObjectID> Scene::CreateObjects(Uint32 num, ComponentMap* compon
 		data = mTypeToObjectData[typeID];
 	}
 
-	Array<GameObjectID> ids(num);
+	Array<GameObjectID, FrameAllocator> ids(num);
 	// Create game object IDs
 	for (Uint32 i = 0; i < num; ++i)
 		ids.Push(GameObjectID(data.mObjectHandles.Add(true), (Uint16)typeID));
@@ -292,6 +299,8 @@ template <typename T>
 T* Scene::GetComponent(GameObjectID id)
 {
 	ObjectData& data = mTypeToObjectData[id.TypeID()];
+	if (!data.mObjectHandles.IsValid(id.Handle()))
+		return 0;
 
 	return ComponentData<T>::GetComponent(
 		(Uint32)id.TypeID(),
@@ -307,11 +316,14 @@ inline void Scene::RemoveObjects(const Array<GameObjectID>& ids)
 	ObjectData& data = mTypeToObjectData[typeID];
 
 	// Keep track of which indices were removed
-	Array<Uint32> indices(ids.Size());
+	Array<Uint32, FrameAllocator> indices(ids.Size());
 
 	for (Uint32 i = 0; i < ids.Size(); ++i)
 	{
 		Handle handle = ids[i].Handle();
+		// Skip objects that were already removed
+		if (!data.mObjectHandles.IsValid(handle)) continue;
+
 		indices.Push(data.mObjectHandles.HandleToIndex(handle));
 		data.mObjectHandles.Remove(handle);
 	}
@@ -0,0 +1,241 @@
+#include <Scene/SystemScheduler.h>
+#include <Scene/GameSystem.h>
+
+#include <Core/JobSystem.h>
+#include <Core/LogFile.h>
+
+#include <unordered_map>
+#include <unordered_set>
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+SystemScheduler::SystemScheduler() :
+	mNumPending		(0),
+	mNumRemaining	(0),
+	mDeltaTime		(0.0f),
+	mGraphDirty		(false)
+{
+	mSystems.Reserve(16);
+	mSystemTypes.Reserve(16);
+	mMainThreadQueue.Reserve(16);
+}
+
+SystemScheduler::~SystemScheduler()
+{
+	delete[] mNumPending;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void SystemScheduler::AddSystem(GameSystem* system, Uint32 type)
+{
+	mSystems.Push(system);
+	mSystemTypes.Push(type);
+
+	mGraphDirty = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SystemScheduler::Update(float dt)
+{
+	if (mGraphDirty)
+		BuildGraph();
+
+	Uint32 numSystems = mNodes.Size();
+	if (!numSystems) return;
+
+	mDeltaTime = dt;
+
+	// Reset counters
+	for (Uint32 i = 0; i < numSystems; ++i)
+		mNumPending[i].store(mNodes[i].mNumPredecessors, std::memory_order_relaxed);
+	mNumRemaining.store(numSystems, std::memory_order_release);
+
+	// Start systems that don't depend on anything
+	for (Uint32 i = 0; i < numSystems; ++i)
+	{
+		if (!mNodes[i].mNumPredecessors)
+			StartSystem(i);
+	}
+
+	// Run main thread systems and help out with jobs until all systems are done
+	while (mNumRemaining.load(std::memory_order_acquire))
+	{
+		Int32 index = -1;
+		{
+			Lock lock(mQueueMutex);
+			if (mMainThreadQueue.Size())
+			{
+				index = (Int32)mMainThreadQueue.Back();
+				mMainThreadQueue.Pop();
+			}
+		}
+
+		if (index >= 0)
+			RunSystem((Uint32)index);
+		else if (!JobSystem::RunJob())
+			std::this_thread::yield();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void SystemScheduler::BuildGraph()
+{
+	Uint32 numSystems = mSystems.Size();
+
+	// Map system type to registration index
+	std::unordered_map<Uint32, Uint32> typeToIndex;
+	for (Uint32 i = 0; i < numSystems; ++i)
+		typeToIndex[mSystemTypes[i]] = i;
+
+	// Get explicit dependencies as registration indices
+	Array<Array<Uint32>> dependencies;
+	dependencies.Resize(numSystems);
+	for (Uint32 i = 0; i < numSystems; ++i)
+	{
+		const Array<Uint32>& types = mSystems[i]->GetDependencies();
+		dependencies[i].Reserve(types.Size() + 1);
+
+		for (Uint32 n = 0; n < types.Size(); ++n)
+		{
+			auto it = typeToIndex.find(types[n]);
+			if (it != typeToIndex.end() && it->second != i)
+				dependencies[i].Push(it->second);
+		}
+	}
+
+	// Sort systems so dependencies come first, otherwise keep registration order
+	Array<Uint32> order(numSystems);
+	Array<bool> added;
+	added.Resize(numSystems, false);
+
+	while (order.Size() < numSystems)
+	{
+		Uint32 next = numSystems;
+
+		for (Uint32 i = 0; i < numSystems && next == numSystems; ++i)
+		{
+			if (added[i]) continue;
+
+			bool ready = true;
+			for (Uint32 n = 0; n < dependencies[i].Size() && ready; ++n)
+				ready = added[dependencies[i][n]];
+
+			if (ready)
+				next = i;
+		}
+
+		// Dependency cycle, fall back to registration order
+		if (next == numSystems)
+		{
+			LOG_WARNING << "Game system dependency cycle detected, using registration order\n";
+			for (next = 0; added[next]; ++next);
+		}
+
+		order.Push(next);
+		added[next] = true;
+	}
+
+	// Get component access of each system
+	Array<std::unordered_set<Uint32>> reads, writes;
+	reads.Resize(numSystems);
+	writes.Resize(numSystems);
+	for (Uint32 i = 0; i < numSystems; ++i)
+		mSystems[order[i]]->GetComponentAccess(reads[i], writes[i]);
+
+	// Create nodes
+	mNodes.Resize(numSystems);
+	for (Uint32 i = 0; i < numSystems; ++i)
+	{
+		SystemNode& node = mNodes[i];
+		node.mSystem = mSystems[order[i]];
+		node.mSuccessors.Reserve(numSystems);
+		node.mNumPredecessors = 0;
+		node.mMainThread = node.mSystem->IsMainThread();
+	}
+
+	// Add an edge from each system to any later system it conflicts with
+	for (Uint32 i = 0; i < numSystems; ++i)
+	{
+		for (Uint32 j = i + 1; j < numSystems; ++j)
+		{
+			bool conflict = false;
+
+			// Explicit dependency
+			for (Uint32 n = 0; n < dependencies[order[j]].Size() && !conflict; ++n)
+				conflict = dependencies[order[j]][n] == order[i];
+
+			// Write-read, write-write
+			for (auto it = writes[i].begin(); it != writes[i].end() && !conflict; ++it)
+				conflict = reads[j].find(*it) != reads[j].end() || writes[j].find(*it) != writes[j].end();
+
+			// Read-write
+			for (auto it = reads[i].begin(); it != reads[i].end() && !conflict; ++it)
+				conflict = writes[j].find(*it) != writes[j].end();
+
+			if (conflict)
+			{
+				mNodes[i].mSuccessors.Push(j);
+				++mNodes[j].mNumPredecessors;
+			}
+		}
+	}
+
+	// Allocate counters
+	delete[] mNumPending;
+	mNumPending = new std::atomic<Uint32>[numSystems];
+
+	mGraphDirty = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SystemScheduler::StartSystem(Uint32 index)
+{
+	if (mNodes[index].mMainThread)
+	{
+		Lock lock(mQueueMutex);
+		mMainThreadQueue.Push(index);
+	}
+	else
+	{
+		SystemJobData data;
+		data.mScheduler = this;
+		data.mIndex = index;
+
+		JobSystem::Run(&SystemScheduler::SystemJob, &data, sizeof(data));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SystemScheduler::RunSystem(Uint32 index)
+{
+	SystemNode& node = mNodes[index];
+	node.mSystem->Update(mDeltaTime);
+
+	// Start any systems that were only waiting for this one
+	for (Uint32 i = 0; i < node.mSuccessors.Size(); ++i)
+	{
+		Uint32 next = node.mSuccessors[i];
+		if (mNumPending[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+			StartSystem(next);
+	}
+
+	mNumRemaining.fetch_sub(1, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void SystemScheduler::SystemJob(void* data)
+{
+	SystemJobData* job = (SystemJobData*)data;
+	job->mScheduler->RunSystem(job->mIndex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
\ No newline at end of file
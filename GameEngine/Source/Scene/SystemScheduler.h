@@ -0,0 +1,85 @@
+#ifndef SYSTEM_SCHEDULER_H
+#define SYSTEM_SCHEDULER_H
+
+#include <Core/DataTypes.h>
+#include <Core/Array.h>
+#include <Core/Thread.h>
+
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////////////
+
+class GameSystem;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Updates game systems as a dependency graph, so systems that don't
+   touch the same components can update at the same time */
+class SystemScheduler
+{
+public:
+	SystemScheduler();
+	~SystemScheduler();
+
+	/* Add system to the schedule */
+	void AddSystem(GameSystem* system, Uint32 type);
+	/* Update all systems (Blocks until all systems are finished) */
+	void Update(float dt);
+
+private:
+	struct SystemNode
+	{
+		/* System to update */
+		GameSystem* mSystem;
+		/* Indices of systems that have to wait for this one */
+		Array<Uint32> mSuccessors;
+		/* Number of systems this one has to wait for */
+		Uint32 mNumPredecessors;
+		/* True if system has to run on the main thread */
+		bool mMainThread;
+	};
+
+	struct SystemJobData
+	{
+		/* Scheduler that owns the system */
+		SystemScheduler* mScheduler;
+		/* Index of system node */
+		Uint32 mIndex;
+	};
+
+	/* Sort systems and build dependency graph */
+	void BuildGraph();
+	/* Start system update on a worker or main thread queue */
+	void StartSystem(Uint32 index);
+	/* Update system and start any systems that were waiting for it */
+	void RunSystem(Uint32 index);
+	/* Job function that updates a single system */
+	static void SystemJob(void* data);
+
+private:
+	/* Systems in registration order */
+	Array<GameSystem*> mSystems;
+	/* Type ID of each system */
+	Array<Uint32> mSystemTypes;
+
+	/* Dependency graph nodes (In a valid update order) */
+	Array<SystemNode> mNodes;
+	/* Number of unfinished predecessors for each node */
+	std::atomic<Uint32>* mNumPending;
+	/* Number of systems left to update this frame */
+	std::atomic<Uint32> mNumRemaining;
+
+	/* Systems that are ready to run on the main thread */
+	Array<Uint32> mMainThreadQueue;
+	/* Protects main thread queue */
+	Mutex mQueueMutex;
+
+	/* Current frame time */
+	float mDeltaTime;
+	/* True if graph needs to be rebuilt */
+	bool mGraphDirty;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
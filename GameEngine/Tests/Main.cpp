@@ -0,0 +1,58 @@
+#include "Tests.h"
+
+#include <stdio.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Test function and name */
+	struct TestCase
+	{
+		/* Test name */
+		const char* mName;
+		/* Returns true if the test passed */
+		bool(*mFunc)();
+	};
+
+	/* All tests, in run order */
+	const TestCase TESTS[] =
+	{
+		{ "RenderData", &TestRenderData },
+		{ "UniformBlock", &TestUniformBlock }
+	};
+
+	/* All benchmarks, in run order */
+	void(*const BENCHMARKS[])() =
+	{
+		&BenchObjectPool,
+		&BenchNoise
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char** argv)
+{
+	int numFailed = 0;
+
+	for (unsigned i = 0; i < sizeof(TESTS) / sizeof(TestCase); ++i)
+	{
+		bool passed = TESTS[i].mFunc();
+		printf("%s: %s\n", TESTS[i].mName, passed ? "passed" : "failed");
+
+		if (!passed)
+			++numFailed;
+	}
+
+	// Benchmarks take a while, so builds don't run them
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+	{
+		for (unsigned i = 0; i < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); ++i)
+			BENCHMARKS[i]();
+	}
+
+	// Exit code fails the post build step
+	return numFailed;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "Tests.h"
+
+#include <Core/Clock.h>
+#include <Core/JobSystem.h>
+
+#include <Game/Terrain/MapGenerator.h>
+
+#include <Math/Noise.h>
+
+#include <SimplexNoise.h>
+
+#include <cmath>
+#include <stdio.h>
+#include <stdlib.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define NOISE_BENCH_OCTAVES		5
+#define NOISE_BENCH_FREQUENCY	0.01f
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Per-texel SimplexNoise::fractal, the path used before noise was vectorized */
+	void GenerateScalar(Uint32 w, Uint32 h, float* out)
+	{
+		SimplexNoise noise(NOISE_BENCH_FREQUENCY, 1.0f, 2.0f, 0.5f);
+
+		for (Uint32 r = 0; r < h; ++r)
+		{
+			for (Uint32 c = 0; c < w; ++c)
+				out[r * w + c] = noise.fractal(NOISE_BENCH_OCTAVES, (float)c, (float)r) * 0.5f + 0.5f;
+		}
+	}
+
+	/* Vectorized rows on the calling thread only */
+	void GenerateSIMD(Uint32 w, Uint32 h, float* out)
+	{
+		FractalNoise noise(NOISE_BENCH_FREQUENCY, 1.0f, 2.0f, 0.5f);
+
+		for (Uint32 r = 0; r < h; ++r)
+		{
+			float* row = out + r * w;
+			noise.EvaluateRow(NOISE_BENCH_OCTAVES, 0.0f, (float)r, 1.0f, w, row);
+
+			for (Uint32 c = 0; c < w; ++c)
+				row[c] = row[c] * 0.5f + 0.5f;
+		}
+	}
+
+	/* Largest difference between two height maps */
+	float MaxDifference(const float* a, const float* b, Uint32 num)
+	{
+		float diff = 0.0f;
+		for (Uint32 i = 0; i < num; ++i)
+			diff = fmaxf(diff, fabsf(a[i] - b[i]));
+
+		return diff;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BenchNoise()
+{
+	JobSystem::Init();
+
+	const Uint32 sizes[] = { 513, 2049, 8193 };
+
+	for (Uint32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		Uint32 size = sizes[i];
+		Uint32 num = size * size;
+
+		float* scalar = (float*)malloc(num * sizeof(float));
+		float* heights = (float*)malloc(num * sizeof(float));
+		Vector3f* normals = (Vector3f*)malloc(num * sizeof(Vector3f));
+		Vector3f* dudv = (Vector3f*)malloc(num * sizeof(Vector3f));
+
+		Clock clock;
+		GenerateScalar(size, size, scalar);
+		float scalarTime = clock.Restart();
+
+		GenerateSIMD(size, size, heights);
+		float simdTime = clock.Restart();
+
+		// Threaded generation, same as NoiseMap, NormalMap, and DuDvMap without the upload
+		FractalNoise noise(NOISE_BENCH_FREQUENCY, 1.0f, 2.0f, 0.5f);
+		MapGenerator::Noise(noise, NOISE_BENCH_OCTAVES, Vector2f(0.0f), size, size, heights);
+		float noiseTime = clock.Restart();
+
+		MapGenerator::Normals(heights, size, size, 30.0f, normals);
+		float normalTime = clock.Restart();
+
+		MapGenerator::DuDv(normals, size, size, 0.1f, dudv);
+		float dudvTime = clock.Restart();
+
+		printf("Noise %5u^2: scalar %8.1f ms, SIMD %8.1f ms (max diff %.2e), %u threads: noise %8.1f ms, normals %8.1f ms, du/dv %8.1f ms\n",
+			size, scalarTime * 1000.0f, simdTime * 1000.0f, MaxDifference(scalar, heights, num),
+			JobSystem::GetNumThreads(), noiseTime * 1000.0f, normalTime * 1000.0f, dudvTime * 1000.0f);
+
+		free(scalar);
+		free(heights);
+		free(normals);
+		free(dudv);
+	}
+
+	JobSystem::CleanUp();
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "Tests.h"
+
+#include <Core/ObjectPool.h>
+#include <Core/Clock.h>
+
+#include <stdio.h>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Pooled object, about the size of a small component */
+	struct PoolObject
+	{
+		double mData[4];
+	};
+
+	/* Small fast random number generator (rand() only has 15 bits on some platforms) */
+	struct XorShift
+	{
+		Uint32 mState;
+
+		Uint32 Next()
+		{
+			mState ^= mState << 13;
+			mState ^= mState >> 17;
+			mState ^= mState << 5;
+			return mState;
+		}
+	};
+
+	/* Allocates from an object pool */
+	struct PoolAllocator
+	{
+		ObjectPool<PoolObject> mPool;
+
+		PoolObject* New() { return mPool.New(); }
+		void Free(PoolObject* ptr) { mPool.Free(ptr); }
+	};
+
+	/* Allocates from the heap, for comparison */
+	struct HeapObjectAllocator
+	{
+		PoolObject* New() { return new PoolObject(); }
+		void Free(PoolObject* ptr) { delete ptr; }
+	};
+
+	/* Free and allocate random objects while a fixed number are alive, returns nanoseconds per free + new */
+	template <typename A>
+	double Churn(Uint32 numLive, Uint32 numOps)
+	{
+		A allocator;
+		std::vector<PoolObject*> objects(numLive);
+
+		for (Uint32 i = 0; i < numLive; ++i)
+			objects[i] = allocator.New();
+
+		XorShift rng = { 1 };
+		Clock clock;
+
+		for (Uint32 i = 0; i < numOps; ++i)
+		{
+			Uint32 n = rng.Next() % numLive;
+			allocator.Free(objects[n]);
+			objects[n] = allocator.New();
+		}
+
+		double time = clock.GetElapsedTime() * 1.0e9 / numOps;
+
+		for (Uint32 i = 0; i < numLive; ++i)
+			allocator.Free(objects[i]);
+
+		return time;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void BenchObjectPool()
+{
+	// Pool cost should stay flat as the number of live objects grows, only cache misses on the objects add to it
+	const Uint32 sizes[] = { 1000, 100000, 1000000 };
+
+	for (Uint32 i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		double pool = Churn<PoolAllocator>(sizes[i], 1000000);
+		double heap = Churn<HeapObjectAllocator>(sizes[i], 1000000);
+		printf("ObjectPool churn, %7u live: %6.1f ns per free + new (new/delete %6.1f ns)\n", sizes[i], pool, heap);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "Tests.h"
+
+#include <Graphics/Renderer.h>
+
+#include <stdio.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Add chunk with a number of instances at an instance buffer offset */
+	Uint32 AddChunk(StaticRenderData& data, Uint32 offset, Uint32 count, Uint32 lod)
+	{
+		RenderChunk chunk;
+		chunk.mTransforms.Reserve(8);
+		for (Uint32 i = 0; i < count; ++i)
+			chunk.mTransforms.Add(Matrix4f(1.0f));
+
+		chunk.mOffset = offset;
+		chunk.mCapacity = count;
+		chunk.mLod = lod;
+		chunk.mUpdated = false;
+
+		data.mRenderChunks.Add(std::move(chunk));
+		return data.mRenderChunks.Size() - 1;
+	}
+
+	/* Compare built commands of a detail level against the expected list */
+	bool CheckCommands(const StaticRenderData& data, Uint32 lod, const DrawCommand* expected, Uint32 num)
+	{
+		const Array<DrawCommand>& commands = data.mDrawCommands[lod];
+		bool match = commands.Size() == num;
+
+		for (Uint32 i = 0; match && i < num; ++i)
+			match = commands[i].mBaseInstance == expected[i].mBaseInstance && commands[i].mInstanceCount == expected[i].mInstanceCount;
+
+		if (!match)
+		{
+			printf("LOD %u: expected", lod);
+			for (Uint32 i = 0; i < num; ++i)
+				printf(" (%u, %u)", expected[i].mBaseInstance, expected[i].mInstanceCount);
+			printf(", got");
+			for (Uint32 i = 0; i < commands.Size(); ++i)
+				printf(" (%u, %u)", commands[i].mBaseInstance, commands[i].mInstanceCount);
+			printf("\n");
+		}
+
+		return match;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TestRenderData()
+{
+	// Set up like the renderer does (Arrays don't grow from empty)
+	StaticRenderData data;
+	data.mRenderChunks.Reserve(8);
+	data.mVisibleChunks.Reserve(8);
+	data.mNumLods = 2;
+	for (Uint32 lod = 0; lod < data.mNumLods; ++lod)
+		data.mDrawCommands[lod].Reserve(4);
+
+	Uint32 c0 = AddChunk(data, 0, 4, 0);
+	Uint32 c1 = AddChunk(data, 4, 2, 0);		// Touches c0
+	Uint32 c2 = AddChunk(data, 10, 3, 0);		// Gap after c1
+	Uint32 c3 = AddChunk(data, 6, 4, 1);		// Touches c1, but a different detail level
+	Uint32 c4 = AddChunk(data, 13, 0, 0);		// Empty
+	Uint32 c5 = AddChunk(data, 20, 5, 1);
+	AddChunk(data, 13, 7, 0);					// Touches c2, but not visible
+
+	// Visible chunks in no particular order
+	Uint32 visible[] = { c2, c5, c1, c0, c3, c4 };
+	for (Uint32 i = 0; i < sizeof(visible) / sizeof(visible[0]); ++i)
+		data.mVisibleChunks.Push(visible[i]);
+
+	// Build twice, the lists are rebuilt every frame
+	data.BuildDrawCommands();
+	data.BuildDrawCommands();
+
+	// Recorded command lists
+	const DrawCommand lod0[] = { { 0, 6 }, { 10, 3 } };
+	const DrawCommand lod1[] = { { 6, 4 }, { 20, 5 } };
+
+	bool passed = true;
+	passed = CheckCommands(data, 0, lod0, 2) && passed;
+	passed = CheckCommands(data, 1, lod1, 2) && passed;
+
+	return passed;
+}
\ No newline at end of file
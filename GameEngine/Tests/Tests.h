@@ -0,0 +1,25 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* CPU side tests of engine code that doesn't need a window or GL context.
+   Each returns true if it passed, failures are printed */
+
+/* Static draw command building (Graphics/RenderData.cpp) */
+bool TestRenderData();
+/* Std140 offsets, strides, and sizes, and the engine uniform block layouts (Graphics/UniformBlock.h) */
+bool TestUniformBlock();
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* Benchmarks, run with the "bench" argument. Results are printed */
+
+/* Object pool free and new with 1k, 100k and 1M live objects (Core/ObjectPool.h) */
+void BenchObjectPool();
+/* Scalar, SIMD, and threaded terrain map generation at 513^2, 2049^2, and 8193^2 (Math/Noise.h, Game/Terrain/MapGenerator.h) */
+void BenchNoise();
+
+///////////////////////////////////////////////////////////////////////////////
+
+#endif
\ No newline at end of file
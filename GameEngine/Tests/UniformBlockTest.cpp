@@ -0,0 +1,115 @@
+#include "Tests.h"
+
+#include <Graphics/UniformBlock.h>
+#include <Graphics/Renderer.h>
+#include <Graphics/Atmosphere.h>
+
+#include <stddef.h>
+#include <stdio.h>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/* Compare a computed offset or size against the std140 rules */
+	bool CheckValue(const char* name, Uint32 value, Uint32 expected)
+	{
+		if (value != expected)
+			printf("%s: expected %u, got %u\n", name, expected, value);
+
+		return value == expected;
+	}
+
+	/* CPU struct with a vec3 and float sharing a vec4, must validate */
+	struct PackedBlock
+	{
+		float mPosition[3];
+		float mScale;
+		float mSize[2];
+		float mPadding[2];
+	};
+
+	/* CPU struct that leaves out the end padding, must not validate */
+	struct UnpaddedBlock
+	{
+		float mPosition[3];
+		float mScale;
+		float mSize[2];
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool TestUniformBlock()
+{
+	bool passed = true;
+
+	// vec3 only takes 12 bytes, so a following float packs into its last component
+	{
+		Std140Layout layout("Vec3Float");
+		passed = CheckValue("vec3 offset", layout.Add(Std140Layout::Vec3), 0) && passed;
+		passed = CheckValue("float after vec3", layout.Add(Std140Layout::Float), 12) && passed;
+		passed = CheckValue("vec3 after float", layout.Add(Std140Layout::Vec3), 16) && passed;
+	}
+
+	// vec2 is aligned to 8 bytes
+	{
+		Std140Layout layout("Vec2");
+		passed = CheckValue("float offset", layout.Add(Std140Layout::Float), 0) && passed;
+		passed = CheckValue("vec2 after float", layout.Add(Std140Layout::Vec2), 8) && passed;
+		passed = CheckValue("float after vec2", layout.Add(Std140Layout::Float), 16) && passed;
+		passed = CheckValue("vec2 after 5 floats", layout.Add(Std140Layout::Vec2), 24) && passed;
+	}
+
+	// Array elements and matrix columns have a vec4 stride
+	{
+		Std140Layout layout("Arrays");
+		passed = CheckValue("float offset", layout.Add(Std140Layout::Float), 0) && passed;
+		passed = CheckValue("float[3] after float", layout.Add(Std140Layout::Float, 3), 16) && passed;
+		passed = CheckValue("float after float[3]", layout.Add(Std140Layout::Float), 64) && passed;
+		passed = CheckValue("mat3 after float", layout.Add(Std140Layout::Mat3), 80) && passed;
+		passed = CheckValue("float after mat3", layout.Add(Std140Layout::Float), 128) && passed;
+		passed = CheckValue("vec2[2] after float", layout.Add(Std140Layout::Vec2, 2), 144) && passed;
+		passed = CheckValue("int after vec2[2]", layout.Add(Std140Layout::Int), 176) && passed;
+
+		passed = CheckValue("vec3[2] size", Std140Layout::GetSize(Std140Layout::Vec3, 2), 32) && passed;
+		passed = CheckValue("mat3[2] size", Std140Layout::GetSize(Std140Layout::Mat3, 2), 96) && passed;
+		passed = CheckValue("mat4 size", Std140Layout::GetSize(Std140Layout::Mat4), 64) && passed;
+		passed = CheckValue("float[2] alignment", Std140Layout::GetAlignment(Std140Layout::Float, 2), 16) && passed;
+	}
+
+	// Block size is rounded up to a vec4
+	{
+		Std140Layout layout("Size");
+		passed = CheckValue("empty size", layout.GetSize(), 0) && passed;
+		layout.Add(Std140Layout::Float);
+		passed = CheckValue("float size", layout.GetSize(), 16) && passed;
+		layout.Add(Std140Layout::Vec3);
+		passed = CheckValue("float, vec3 size", layout.GetSize(), 32) && passed;
+		layout.Add(Std140Layout::Float);
+		passed = CheckValue("float, vec3, float size", layout.GetSize(), 32) && passed;
+		layout.Add(Std140Layout::Vec2);
+		passed = CheckValue("float, vec3, float, vec2 size", layout.GetSize(), 48) && passed;
+	}
+
+	// Validation catches a CPU struct that is missing its end padding (Logs an error)
+	{
+		Std140Layout packed("PackedBlock");
+		packed.Check("mPosition", Std140Layout::Vec3, offsetof(PackedBlock, mPosition));
+		packed.Check("mScale", Std140Layout::Float, offsetof(PackedBlock, mScale));
+		packed.Check("mSize", Std140Layout::Vec2, offsetof(PackedBlock, mSize));
+		passed = CheckValue("PackedBlock valid", packed.Validate(sizeof(PackedBlock)), true) && passed;
+
+		Std140Layout unpadded("UnpaddedBlock");
+		unpadded.Check("mPosition", Std140Layout::Vec3, offsetof(UnpaddedBlock, mPosition));
+		unpadded.Check("mScale", Std140Layout::Float, offsetof(UnpaddedBlock, mScale));
+		unpadded.Check("mSize", Std140Layout::Vec2, offsetof(UnpaddedBlock, mSize));
+		passed = CheckValue("UnpaddedBlock valid", unpadded.Validate(sizeof(UnpaddedBlock)), false) && passed;
+	}
+
+	// Engine blocks
+	passed = CheckValue("CommonUniforms valid", CommonUniforms::ValidateLayout(), true) && passed;
+	passed = CheckValue("AtmosphereUniforms valid", AtmosphereUniforms::ValidateLayout(), true) && passed;
+
+	return passed;
+}
\ No newline at end of file